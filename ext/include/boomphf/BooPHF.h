@@ -146,31 +146,22 @@ class bitVector {
     }
 
     ~bitVector() {
-        if (_bitArray != nullptr)
-            free(_bitArray);
+        release();
     }
 
-    //copy constructor
-    bitVector(bitVector const &r) {
-        _size =  r._size;
-        _nchar = r._nchar;
-        _ranks = r._ranks;
-        _bitArray = nullptr;
-        if (r._bitArray) {
-            _bitArray = (uint64_t *) calloc(_nchar,sizeof(uint64_t));
-            memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
-        }
+    //copy constructor, the copy of mapped vector owns its data
+    bitVector(bitVector const &r)
+            : _bitArray(nullptr) {
+        *this = r;
     }
 
     // Copy assignment operator
     bitVector &operator=(bitVector const &r) {
         if (&r != this) {
+            release();
             _size =  r._size;
             _nchar = r._nchar;
-            _ranks = r._ranks;
-            if (_bitArray != nullptr)
-                free(_bitArray);
-            _bitArray = nullptr;
+            _ranks.assign(r.ranks(), r.ranks() + r.nranks());
             if (r._bitArray) {
                 _bitArray = (uint64_t *) calloc(_nchar, sizeof(uint64_t));
                 memcpy(_bitArray, r._bitArray, _nchar*sizeof(uint64_t) );
@@ -182,14 +173,18 @@ class bitVector {
     // Move assignment operator
     bitVector &operator=(bitVector &&r) noexcept {
         if (&r != this) {
-            if (_bitArray != nullptr)
-                free(_bitArray);
+            release();
 
             _size =  r._size;
             _nchar = r._nchar;
             _ranks = std::move(r._ranks);
             _bitArray = r._bitArray;
+            _mapped = r._mapped;
+            _mapped_ranks = r._mapped_ranks;
+            _nmapped_ranks = r._nmapped_ranks;
             r._bitArray = nullptr;
+            r._mapped = false;
+            r._mapped_ranks = nullptr;
         }
         return *this;
     }
@@ -202,13 +197,18 @@ class bitVector {
 
 
     void resize(uint64_t newsize) {
+        if (_mapped) {
+            // Never touch the mapped data, make an owned copy first
+            bitVector copy(*this);
+            *this = std::move(copy);
+        }
         _nchar  = (1ULL+newsize/64ULL);
         _bitArray = (uint64_t *) realloc(_bitArray,_nchar*sizeof(uint64_t));
         _size = newsize;
     }
 
     size_t size() const { return _size; }
-    uint64_t bitSize() const {return (_nchar*64ULL + _ranks.capacity()*64ULL );}
+    uint64_t bitSize() const {return (_nchar*64ULL + (_mapped ? _nmapped_ranks : _ranks.capacity())*64ULL );}
 
     //clear whole array
     void clear() {
@@ -246,9 +246,9 @@ class bitVector {
         }
         printf("\n");
 
-        printf("rank array : size %lu \n",_ranks.size());
-        for (uint64_t ii = 0; ii< _ranks.size(); ii++) {
-            printf("%llu :  %lli,  ",ii,_ranks[ii]);
+        printf("rank array : size %lu \n",nranks());
+        for (uint64_t ii = 0; ii< nranks(); ii++) {
+            printf("%llu :  %lli,  ",ii,ranks()[ii]);
         }
         printf("\n");
     }
@@ -273,6 +273,12 @@ class bitVector {
         return _bitArray[cell64];
     }
 
+    // prefetch the memory needed for get(pos) and rank(pos)
+    void prefetch(uint64_t pos) const {
+        __builtin_prefetch(_bitArray + (pos >> 6));
+        __builtin_prefetch(ranks() + pos / _nb_bits_per_rank_sample);
+    }
+
     //set bit pos to 1
     void set(uint64_t pos) {
         assert(pos<_size);
@@ -304,7 +310,7 @@ class bitVector {
         uint64_t word_idx = pos / 64ULL;
         uint64_t word_offset = pos % 64;
         uint64_t block = pos / _nb_bits_per_rank_sample;
-        uint64_t r = _ranks[block];
+        uint64_t r = ranks()[block];
         for (uint64_t w = block * _nb_bits_per_rank_sample / 64; w < word_idx; ++w)
             r += popcount_64(_bitArray[w]);
         uint64_t mask = (uint64_t(1) << word_offset ) - 1;
@@ -323,6 +329,7 @@ class bitVector {
     }
 
     void load(std::istream& is) {
+        release();
         is.read(reinterpret_cast<char*>(&_size), sizeof(_size));
         is.read(reinterpret_cast<char*>(&_nchar), sizeof(_nchar));
         this->resize(_size);
@@ -334,8 +341,57 @@ class bitVector {
         is.read(reinterpret_cast<char*>(_ranks.data()), (std::streamsize)(sizeof(_ranks[0]) * _ranks.size()));
     }
 
+    // Layout which could be used in place, see map(). All the fields are
+    // 64-bit words, so the layout keeps 8-byte alignment.
+    void save_mapped(std::ostream& os) const {
+        uint64_t header[3] = { _size, _nchar, nranks() };
+        os.write(reinterpret_cast<char const*>(header), sizeof(header));
+        os.write(reinterpret_cast<char const*>(_bitArray), (std::streamsize)(sizeof(uint64_t) * _nchar));
+        os.write(reinterpret_cast<char const*>(ranks()), (std::streamsize)(sizeof(uint64_t) * nranks()));
+    }
+
+    // Uses the data saved by save_mapped() in place, data is advanced past
+    // the bit vector. The memory should outlive the bit vector and is never
+    // modified. Returns false if the data ends before end.
+    bool map(const uint8_t *&data, const uint8_t *end) {
+        release();
+        uint64_t header[3];
+        if (size_t(end - data) < sizeof(header))
+            return false;
+        memcpy(header, data, sizeof(header));
+        data += sizeof(header);
+        if (header[1] > size_t(end - data) / sizeof(uint64_t) ||
+            header[2] > size_t(end - data) / sizeof(uint64_t) - header[1])
+            return false;
+        _size = header[0];
+        _nchar = header[1];
+        _nmapped_ranks = header[2];
+
+        _bitArray = reinterpret_cast<uint64_t*>(const_cast<uint8_t*>(data));
+        data += sizeof(uint64_t) * _nchar;
+        _mapped_ranks = reinterpret_cast<const uint64_t*>(data);
+        data += sizeof(uint64_t) * _nmapped_ranks;
+        _mapped = true;
+        return true;
+    }
+
+    bool mapped() const { return _mapped; }
+
 
   protected:
+    const uint64_t *ranks() const { return _mapped ? _mapped_ranks : _ranks.data(); }
+    uint64_t nranks() const { return _mapped ? _nmapped_ranks : _ranks.size(); }
+
+    void release() {
+        if (_bitArray != nullptr && !_mapped)
+            free(_bitArray);
+        _bitArray = nullptr;
+        _ranks.clear();
+        _mapped = false;
+        _mapped_ranks = nullptr;
+        _nmapped_ranks = 0;
+    }
+
     uint64_t*  _bitArray;
     uint64_t _size;
     uint64_t _nchar;
@@ -344,6 +400,11 @@ class bitVector {
     // additional size for rank is epsilon * _size
     static constexpr uint64_t _nb_bits_per_rank_sample = 512; //512 seems ok
     std::vector<uint64_t> _ranks;
+
+    // Bit array and ranks could point to the external memory, see map()
+    bool _mapped = false;
+    const uint64_t *_mapped_ranks = nullptr;
+    uint64_t _nmapped_ranks = 0;
 };
 
 ////////////////////////////////////////////////////////////////
@@ -366,6 +427,10 @@ class level{
         return bitset.get(hashi);
     }
 
+    void prefetch(uint64_t hash_raw) const {
+        bitset.prefetch(fastrange64(hash_raw, hash_domain));
+    }
+
     uint64_t hash_domain;
     bitVector bitset;
 };
@@ -466,10 +531,27 @@ class mphf {
     uint64_t lookup(const elem_t &elem) const {
         if (!_built) return NOT_FOUND;
 
+        return lookup_hash(_hasher.hashpair128(elem));
+    }
+
+    // Split lookup for batched queries: hash the elements, prefetch the
+    // first level for all of them, then resolve the lookups by hashes.
+    template<class elem_t>
+    hash_pair_t hash(const elem_t &elem) const {
+        return _hasher.hashpair128(elem);
+    }
+
+    void prefetch(const hash_pair_t &bbhash) const {
+        if (_built)
+            _levels[0].prefetch(bbhash[0]);
+    }
+
+    uint64_t lookup_hash(hash_pair_t bbhash) const {
+        if (!_built) return NOT_FOUND;
+
         uint64_t non_minimal_hp;
         unsigned level;
 
-        hash_pair_t bbhash = _hasher.hashpair128(elem);
         uint64_t level_hash = getLevel(bbhash, &level, _nb_levels);
 
         if (level == (_nb_levels-1)) {
@@ -548,15 +630,7 @@ class mphf {
             }
         }
 
-        // mini setup, recompute size of each level
-        _proba_collision = 1.0 -  pow(((_gamma*(double)_nelem -1 ) / (_gamma*(double)_nelem)),_nelem-1);
-        uint64_t previous_idx =0;
-        _hash_domain = (size_t)(ceil(double(_nelem) * _gamma)) ;
-        for (int ii=0; ii<_nb_levels; ii++) {
-            _levels[ii].hash_domain =  ((uint64_t(_hash_domain * pow(_proba_collision,ii)) + 63) / 64) * 64;
-            if (_levels[ii].hash_domain == 0)
-                _levels[ii].hash_domain = 64;
-        }
+        restore_levels();
 
         //restore final hash
 
@@ -577,8 +651,88 @@ class mphf {
         _built = true;
     }
 
+    // Layout which could be used in place, see map(). All the fields are
+    // 64-bit words, so the layout keeps 8-byte alignment.
+    void save_mapped(std::ostream& os) const {
+        uint64_t nb_levels = _nb_levels, final_hash_size = _final_hash.size();
+        os.write(reinterpret_cast<char const*>(&_gamma), sizeof(_gamma));
+        os.write(reinterpret_cast<char const*>(&nb_levels), sizeof(nb_levels));
+        os.write(reinterpret_cast<char const*>(&_lastbitsetrank), sizeof(_lastbitsetrank));
+        os.write(reinterpret_cast<char const*>(&_nelem), sizeof(_nelem));
+
+        if (_nelem != 0) {
+            for (int ii=0; ii<_nb_levels; ii++) {
+                _levels[ii].bitset.save_mapped(os);
+            }
+        }
+
+        os.write(reinterpret_cast<char const*>(&final_hash_size), sizeof(final_hash_size));
+        for (auto it = _final_hash.begin(); it != _final_hash.end(); ++it) {
+            os.write(reinterpret_cast<char const*>(&(it->first)), sizeof(internal_hash_t));
+            os.write(reinterpret_cast<char const*>(&(it->second)), sizeof(uint64_t));
+        }
+    }
+
+    // Uses the bit vectors saved by save_mapped() in place, data is advanced
+    // past the mphf. The memory should outlive the mphf. The final hash is
+    // small, so it is loaded into memory. Returns false if the data ends
+    // before end.
+    bool map(const uint8_t *&data, const uint8_t *end) {
+        auto read = [&data, end](auto &value) {
+            if (size_t(end - data) < sizeof(value))
+                return false;
+            memcpy(&value, data, sizeof(value));
+            data += sizeof(value);
+            return true;
+        };
+
+        uint64_t nb_levels, final_hash_size;
+        if (!read(_gamma) || !read(nb_levels) || !read(_lastbitsetrank) || !read(_nelem))
+            return false;
+        // Every level has at least the bit vector header
+        if (_nelem != 0 && nb_levels > size_t(end - data) / (3 * sizeof(uint64_t)))
+            return false;
+        _nb_levels = int(nb_levels);
+
+        _levels.clear();
+        _levels.resize(_nb_levels);
+        if (_nelem != 0) {
+            for (int ii=0; ii<_nb_levels; ii++) {
+                if (!_levels[ii].bitset.map(data, end))
+                    return false;
+            }
+        }
+
+        restore_levels();
+
+        _final_hash.clear();
+        if (!read(final_hash_size) ||
+            final_hash_size > size_t(end - data) / (sizeof(internal_hash_t) + sizeof(uint64_t)))
+            return false;
+        for (uint64_t ii = 0; ii < final_hash_size; ii++) {
+            internal_hash_t key;
+            uint64_t value;
+            read(key);
+            read(value);
+            _final_hash[key] = value;
+        }
+        _built = true;
+        return true;
+    }
+
 
   private:
+    // mini setup, recompute size of each level
+    void restore_levels() {
+        _proba_collision = 1.0 -  pow(((_gamma*(double)_nelem -1 ) / (_gamma*(double)_nelem)),_nelem-1);
+        _hash_domain = (size_t)(ceil(double(_nelem) * _gamma)) ;
+        for (int ii=0; ii<_nb_levels; ii++) {
+            _levels[ii].hash_domain =  ((uint64_t(_hash_domain * pow(_proba_collision,ii)) + 63) / 64) * 64;
+            if (_levels[ii].hash_domain == 0)
+                _levels[ii].hash_domain = 64;
+        }
+    }
+
     void setup() {
         if (_fastmode)
             setLevelFastmode.resize(_percent_elem_loaded_for_fastMode * (double)_nelem);
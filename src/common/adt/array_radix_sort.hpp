@@ -0,0 +1,188 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <pdqsort/pdqsort_pod.h>
+
+#include <array>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+
+namespace adt {
+
+// In-place MSD radix sort (American flag sort) of arrays of unsigned words
+// stored contiguously, elcnt words per array. The resulting order is the
+// lexicographic order over words, same as adt::array_less.
+namespace array_radix_sort_detail {
+
+enum {
+    // Partitions below this size are sorted using pdqsort
+    small_partition_threshold = 64
+};
+
+typedef std::array<size_t, 256> Counts;
+
+template<class T>
+inline unsigned byte_at(const T *el, size_t byte) {
+    constexpr size_t word_bytes = sizeof(T);
+    T word = el[byte / word_bytes];
+    return unsigned(word >> (8 * (word_bytes - 1 - byte % word_bytes))) & 0xFF;
+}
+
+template<class T>
+inline void swap_arrays(T *a, T *b, T *tmp, size_t elcnt) {
+    memcpy(tmp, a, elcnt * sizeof(T));
+    memcpy(a, b, elcnt * sizeof(T));
+    memcpy(b, tmp, elcnt * sizeof(T));
+}
+
+// Partitions the arrays by the first byte starting from byte which is not
+// the same for all the arrays. Returns the byte used or total number of bytes
+// if all the arrays are equal.
+template<class T>
+size_t partition(T *data, size_t n, size_t elcnt, size_t byte, Counts &counts, T *tmp) {
+    const size_t total_bytes = elcnt * sizeof(T);
+
+    for (; byte < total_bytes; ++byte) {
+        counts.fill(0);
+        for (size_t i = 0; i < n; ++i)
+            counts[byte_at(data + i * elcnt, byte)] += 1;
+
+        if (counts[byte_at(data, byte)] != n)
+            break;
+    }
+
+    if (byte == total_bytes)
+        return byte;
+
+    Counts starts, ends;
+    size_t offset = 0;
+    for (size_t b = 0; b < 256; ++b) {
+        starts[b] = offset;
+        offset += counts[b];
+        ends[b] = offset;
+    }
+
+    for (unsigned b = 0; b < 256; ++b) {
+        while (starts[b] < ends[b]) {
+            T *el = data + starts[b] * elcnt;
+            unsigned c = byte_at(el, byte);
+            if (c == b) {
+                starts[b] += 1;
+                continue;
+            }
+
+            swap_arrays(el, data + starts[c] * elcnt, tmp, elcnt);
+            starts[c] += 1;
+        }
+    }
+
+    return byte;
+}
+
+template<class T>
+void sort(T *data, size_t n, size_t elcnt, size_t byte, T *tmp) {
+    if (n < 2)
+        return;
+
+    if (n < small_partition_threshold) {
+        pdqsort_pod(data, data + n * elcnt, elcnt);
+        return;
+    }
+
+    Counts counts;
+    byte = partition(data, n, elcnt, byte, counts, tmp);
+    if (byte == elcnt * sizeof(T))
+        return;
+
+    for (size_t b = 0, offset = 0; b < 256; offset += counts[b], ++b)
+        sort(data + offset * elcnt, counts[b], elcnt, byte + 1, tmp);
+}
+
+// Removes the duplicates from the sorted range, returns the number of unique arrays
+template<class T>
+size_t unique(T *data, size_t n, size_t elcnt) {
+    if (!n)
+        return 0;
+
+    const size_t el_bytes = elcnt * sizeof(T);
+    size_t out = 1;
+    for (size_t i = 1; i < n; ++i) {
+        const T *el = data + i * elcnt;
+        if (memcmp(el, data + (out - 1) * elcnt, el_bytes) == 0)
+            continue;
+
+        if (out != i)
+            memcpy(data + out * elcnt, el, el_bytes);
+        out += 1;
+    }
+
+    return out;
+}
+
+template<class T>
+size_t sort(T *data, size_t n, size_t elcnt, unsigned nthreads, bool dedup) {
+    static_assert(std::is_unsigned<T>::value, "radix sort requires unsigned words");
+
+    std::vector<T> tmp(elcnt);
+    if (n < small_partition_threshold) {
+        pdqsort_pod(data, data + n * elcnt, elcnt);
+        return dedup ? unique(data, n, elcnt) : n;
+    }
+
+    Counts counts;
+    size_t byte = partition(data, n, elcnt, 0, counts, tmp.data());
+    if (byte == elcnt * sizeof(T))
+        return dedup ? 1 : n;
+
+    Counts offsets, sizes;
+    for (size_t b = 0, offset = 0; b < 256; offset += counts[b], ++b)
+        offsets[b] = offset;
+
+    // Equal arrays never cross the partition boundaries, so every partition
+    // could be deduplicated on its own.
+#   pragma omp parallel num_threads(nthreads)
+    {
+        std::vector<T> ttmp(elcnt);
+#       pragma omp for schedule(dynamic)
+        for (size_t b = 0; b < 256; ++b) {
+            T *part = data + offsets[b] * elcnt;
+            sort(part, counts[b], elcnt, byte + 1, ttmp.data());
+            sizes[b] = dedup ? unique(part, counts[b], elcnt) : counts[b];
+        }
+    }
+
+    if (!dedup)
+        return n;
+
+    size_t out = 0;
+    for (size_t b = 0; b < 256; ++b) {
+        if (out != offsets[b])
+            memmove(data + out * elcnt, data + offsets[b] * elcnt, sizes[b] * elcnt * sizeof(T));
+        out += sizes[b];
+    }
+
+    return out;
+}
+
+}
+
+template<class T>
+void array_radix_sort(T *data, size_t n, size_t elcnt, unsigned nthreads = 1) {
+    array_radix_sort_detail::sort(data, n, elcnt, nthreads, /* dedup */ false);
+}
+
+// Sorts the arrays and moves the unique ones to the beginning of the range,
+// returns the number of unique arrays.
+template<class T>
+size_t array_radix_sort_unique(T *data, size_t n, size_t elcnt, unsigned nthreads = 1) {
+    return array_radix_sort_detail::sort(data, n, elcnt, nthreads, /* dedup */ true);
+}
+
+}
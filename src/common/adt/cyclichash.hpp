@@ -215,12 +215,16 @@ private:
     hasher hasher_;
     unsigned n_;
 
+    // Rotations are taken modulo precision, so k-mers longer than the digest
+    // are hashed correctly
     static digest rol(digest x, unsigned s = 1) {
-        return x << s | x >> (precision - s);
+        s %= precision;
+        return s ? (x << s | x >> (precision - s)) : x;
     }
 
     static digest ror(digest x, unsigned s = 1) {
-        return x >> s | x << (precision - s);
+        s %= precision;
+        return s ? (x >> s | x << (precision - s)) : x;
     }
 
 public:
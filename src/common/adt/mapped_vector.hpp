@@ -0,0 +1,149 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <type_traits>
+
+namespace adt {
+
+// Vector of trivially copyable elements which either owns its storage or uses
+// an external memory region (e.g. memory mapped file) in place. The external
+// region is kept alive by the holder and is copied into the owned storage as
+// soon as the size of the vector changes.
+template<class T>
+class mapped_vector {
+    static_assert(std::is_trivially_copyable<T>::value, "mapped_vector requires trivially copyable elements");
+
+  public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    mapped_vector() = default;
+
+    explicit mapped_vector(size_t n, const T &value = T())
+            : owned_(n, value) {
+        sync();
+    }
+
+    mapped_vector(const mapped_vector &other)
+            : owned_(other.begin(), other.end()) {
+        sync();
+    }
+
+    mapped_vector(mapped_vector &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    mapped_vector &operator=(const mapped_vector &other) {
+        if (this != &other) {
+            owned_.assign(other.begin(), other.end());
+            holder_.reset();
+            sync();
+        }
+        return *this;
+    }
+
+    mapped_vector &operator=(mapped_vector &&other) noexcept {
+        if (this != &other) {
+            // Moved vector keeps its buffer, so data_ stays valid
+            owned_ = std::move(other.owned_);
+            holder_ = std::move(other.holder_);
+            data_ = other.data_;
+            size_ = other.size_;
+            other.clear();
+        }
+        return *this;
+    }
+
+    // Uses n elements starting at data in place. The memory is kept alive by
+    // the holder.
+    void attach(T *data, size_t n, std::shared_ptr<void> holder) {
+        std::vector<T>().swap(owned_);
+        holder_ = std::move(holder);
+        data_ = data;
+        size_ = n;
+    }
+
+    bool mapped() const { return holder_ != nullptr; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T *data() { return data_; }
+    const T *data() const { return data_; }
+
+    T &operator[](size_t i) { return data_[i]; }
+    const T &operator[](size_t i) const { return data_[i]; }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    const_iterator cbegin() const { return data_; }
+    const_iterator cend() const { return data_ + size_; }
+
+    void resize(size_t n, const T &value = T()) {
+        if (n == size_)
+            return;
+
+        detach();
+        owned_.resize(n, value);
+        sync();
+    }
+
+    void push_back(const T &value) {
+        detach();
+        owned_.push_back(value);
+        sync();
+    }
+
+    void clear() {
+        owned_.clear();
+        holder_.reset();
+        sync();
+    }
+
+    void swap(mapped_vector &other) noexcept {
+        std::swap(owned_, other.owned_);
+        std::swap(holder_, other.holder_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+  private:
+    void detach() {
+        if (!mapped())
+            return;
+
+        owned_.assign(data_, data_ + size_);
+        holder_.reset();
+        sync();
+    }
+
+    void sync() {
+        data_ = owned_.data();
+        size_ = owned_.size();
+    }
+
+    std::vector<T> owned_;
+    std::shared_ptr<void> holder_;
+    T *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}
@@ -16,6 +16,8 @@
 
 #include <algorithm>
 #include <queue>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -58,6 +60,26 @@ struct simple_greater {
     }
 };
 
+// Visits the elements of the heap (ordered by simple_greater) best-first from
+// the root, i.e. in the order they would be popped, while visit returns true.
+// Only O(n) heap nodes are touched for n visited elements
+template<typename StoredType, typename Visitor>
+bool visit_heap_in_order(const std::vector<StoredType> &heap, Visitor visit) {
+    auto greater_node = [&heap](size_t i, size_t j) { return heap[j] < heap[i]; };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater_node)> front(greater_node);
+    if (!heap.empty())
+        front.push(0);
+    while (!front.empty()) {
+        size_t i = front.top();
+        front.pop();
+        if (!visit(heap[i]))
+            return false;
+        for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < heap.size(); ++child)
+            front.push(child);
+    }
+    return true;
+}
+
 template<typename T, typename Priority=identity>
 class erasable_priority_queue_key_dirty_heap {
 private:
@@ -190,8 +212,195 @@ public:
             push(*begin);
         }
     }
+
+    // Returns up to cnt top elements in the order they would be popped
+    std::vector<T> peek(size_t cnt) const {
+        std::vector<T> result;
+        phmap::flat_hash_set<StoredType> seen;
+        if (cnt == 0)
+            return result;
+        visit_heap_in_order(queue_.c, [&](const StoredType &el) {
+            // skip erased elements and the duplicates left by repeated push
+            if (set_.count(el) && seen.insert(el).second) {
+                if constexpr (is_trivial)
+                    result.push_back(el);
+                else
+                    result.push_back(el.second);
+            }
+            return result.size() < cnt;
+        });
+        return result;
+    }
 };
 
+// Priority (the functor) may provide static bucket(priority value) mapping
+// the priority values to small integers, non-decreasing in the priority.
+// Then the queue of such priorities is a bucket queue
+template<typename Priority, typename = void>
+struct has_priority_buckets : std::false_type {};
+
+template<typename Priority>
+struct has_priority_buckets<Priority, std::void_t<decltype(&Priority::bucket)>> : std::true_type {};
+
+// The elements are dispatched to the buckets of their priorities in O(1) and
+// only the elements of the same bucket are ordered by a (small) heap, so
+// the order is the same as of erasable_priority_queue_key_dirty_heap.
+// Erased elements are skipped lazily as well
+template<typename T, typename Priority>
+class erasable_priority_queue_key_buckets {
+private:
+    static constexpr size_t MAX_BUCKETS = size_t(1) << 14;
+
+    Priority priority_;
+    using PriorityValue = std::decay_t<decltype(std::declval<Priority>()(T()))>;
+    using StoredType = std::pair<PriorityValue, T>;
+
+    std::vector<std::vector<StoredType>> buckets_;
+    phmap::flat_hash_set<StoredType> set_;
+    // All the buckets before are empty
+    size_t first_;
+    // Including the erased elements still kept in the buckets
+    size_t stored_;
+
+    static size_t bucket(const PriorityValue &priority) {
+        return std::min(size_t(Priority::bucket(priority)), MAX_BUCKETS - 1);
+    }
+
+    StoredType get_stored(const T &key) const {
+        return std::make_pair(priority_(key), key);
+    }
+
+    void pop_bucket_top(std::vector<StoredType> &bucket) {
+        std::pop_heap(bucket.begin(), bucket.end(), simple_greater());
+        bucket.pop_back();
+        stored_ -= 1;
+    }
+
+    // Makes the top of the first non-empty bucket actual
+    void skip() {
+        if (empty()) return clear();
+
+        while (true) {
+            auto &bucket = buckets_[first_];
+            if (bucket.empty())
+                first_ += 1;
+            else if (!set_.count(bucket.front()))
+                pop_bucket_top(bucket);
+            else
+                break;
+        }
+    }
+
+public:
+    erasable_priority_queue_key_buckets(Priority priority = Priority())
+            : priority_(std::move(priority)), first_(0), stored_(0) {}
+
+    template<typename InputIterator>
+    erasable_priority_queue_key_buckets(InputIterator begin, InputIterator end,
+                                        Priority priority = Priority())
+            : erasable_priority_queue_key_buckets(std::move(priority)) {
+        insert(begin, end);
+    }
+
+    void pop() {
+        VERIFY(!set_.empty());
+        auto &bucket = buckets_[first_];
+        [[maybe_unused]] bool res = set_.erase(bucket.front());
+        VERIFY(res);
+        pop_bucket_top(bucket);
+        skip();
+    }
+
+    const T& top() const {
+        VERIFY(!set_.empty());
+        return buckets_[first_].front().second;
+    }
+
+    void push(const T &key) {
+        auto p = get_stored(key);
+        if (!set_.insert(p).second)
+            return;
+
+        size_t idx = bucket(p.first);
+        if (idx >= buckets_.size())
+            buckets_.resize(idx + 1);
+        auto &bucket = buckets_[idx];
+        bucket.push_back(std::move(p));
+        std::push_heap(bucket.begin(), bucket.end(), simple_greater());
+        stored_ += 1;
+        // The buckets of the empty queue are empty
+        if (set_.size() == 1 || idx < first_)
+            first_ = idx;
+    }
+
+    bool erase(const T &key) {
+        bool res = set_.erase(get_stored(key)) > 0;
+        skip();
+        if (2 * set_.size() < stored_)
+            compress();
+        return res;
+    }
+
+    void clear() {
+        set_.clear();
+        for (auto &bucket : buckets_)
+            bucket.clear();
+        first_ = 0;
+        stored_ = 0;
+    }
+
+    void compress() {
+        for (auto &bucket : buckets_)
+            bucket.clear();
+        first_ = buckets_.size();
+        for (const auto &p : set_) {
+            size_t idx = bucket(p.first);
+            buckets_[idx].push_back(p);
+            first_ = std::min(first_, idx);
+        }
+        for (auto &bucket : buckets_)
+            std::make_heap(bucket.begin(), bucket.end(), simple_greater());
+        stored_ = set_.size();
+        if (empty())
+            first_ = 0;
+    }
+
+    bool empty() const {
+        return set_.empty();
+    }
+
+    size_t size() const {
+        return set_.size();
+    }
+
+    template <class InputIterator>
+    void insert(InputIterator begin, InputIterator end) {
+        for (; begin != end; ++begin) {
+            push(*begin);
+        }
+    }
+
+    // Returns up to cnt top elements in the order they would be popped
+    std::vector<T> peek(size_t cnt) const {
+        std::vector<T> result;
+        phmap::flat_hash_set<StoredType> seen;
+        for (size_t idx = first_; idx < buckets_.size() && result.size() < cnt; ++idx) {
+            visit_heap_in_order(buckets_[idx], [&](const StoredType &el) {
+                // erased and then pushed again elements could be duplicated
+                if (set_.count(el) && seen.insert(el).second)
+                    result.push_back(el.second);
+                return result.size() < cnt;
+            });
+        }
+        return result;
+    }
+};
+
+template<typename T, typename Priority>
+using erasable_priority_queue_key_t = std::conditional_t<has_priority_buckets<Priority>::value,
+                                                         erasable_priority_queue_key_buckets<T, Priority>,
+                                                         erasable_priority_queue_key_dirty_heap<T, Priority>>;
+
 template<typename T, typename Priority=identity>
 class erasable_priority_queue_key {
 private:
@@ -493,6 +702,12 @@ public:
         return queue_.size();
     }
 
+    // Up to cnt top elements of the queue (normally starting with the current
+    // one) in the order of iteration, as it would go if nothing is pushed
+    std::vector<T> Upcoming(size_t cnt) const {
+        return queue_.peek(cnt);
+    }
+
     const T& operator*() {
         VERIFY(!queue_.empty());
         if (!current_actual_ || current_deleted_) {
@@ -518,10 +733,11 @@ public:
     }
 };
 
-// Iterator over queue that is ordered using Priority
+// Iterator over queue that is ordered using Priority (bucket queue is used if
+// Priority provides buckets, see has_priority_buckets)
 template<typename T, typename Priority = identity>
-class DynamicQueueIteratorKey : public DynamicQueueIteratorBase<T, erasable_priority_queue_key_dirty_heap<T, Priority>> {
-    using base = DynamicQueueIteratorBase<T, erasable_priority_queue_key_dirty_heap<T, Priority>>;
+class DynamicQueueIteratorKey : public DynamicQueueIteratorBase<T, erasable_priority_queue_key_t<T, Priority>> {
+    using base = DynamicQueueIteratorBase<T, erasable_priority_queue_key_t<T, Priority>>;
 public:
     DynamicQueueIteratorKey(const Priority &priority = Priority())
             : base(priority) {}
@@ -13,8 +13,10 @@
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/core/action_handlers.hpp"
 #include "assembly_graph/index/edge_info_updater.hpp"
+#include "io/kmers/mmapped_file.hpp"
 
 #include <limits>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -57,6 +59,20 @@ private:
         return { EdgeId(), NOT_FOUND };
     }
 
+    template<class Index>
+    void get(const Index *index, const KMer *kmers, size_t n,
+             std::pair<EdgeId, size_t> *res) const {
+        std::vector<typename Index::KeyWithHash> kwhs;
+        index->ConstructKWH(kmers, n, kwhs);
+        for (size_t i = 0; i < n; ++i) {
+            if (index->contains(kwhs[i])) {
+                auto entry = index->get_value(kwhs[i]);
+                res[i] = { entry.edge(), (size_t)entry.offset() };
+            } else
+                res[i] = { EdgeId(), NOT_FOUND };
+        }
+    }
+
     template<class Index>
     bool contains(const Index *index, const KMer& kmer) const {
         return index->contains(index->ConstructKWH(kmer));
@@ -124,6 +140,19 @@ private:
         inner_index_ = index;
     }
 
+    template<class Index>
+    void BinWriteMapped(const Index *index, std::ostream &os) const {
+        index->BinWriteMapped(os);
+    }
+
+    template<class Index>
+    void BinMap(Index *, const uint8_t *&data, const uint8_t *end, std::shared_ptr<void> holder) {
+        // kmer length is dummy value here to ensure we loaded the proper one
+        auto index = new Index(this->g(), -1);
+        index->BinMap(data, end, std::move(holder));
+        inner_index_ = index;
+    }
+
 public:
     EdgeIndex(const Graph& g, const std::filesystem::path &workdir)
             : omnigraph::GraphActionHandler<Graph>(g, "EdgeIndex"),
@@ -168,6 +197,12 @@ public:
         DISPATCH_TO(get, kmer);
     }
 
+    // Batched get(), considerably faster for many k-mers at once since the
+    // index lookups are prefetched
+    void get(const KMer *kmers, size_t n, std::pair<EdgeId, size_t> *res) const {
+        DISPATCH_TO(get, kmers, n, res);
+    }
+
     void Refill() {
         clear();
         uint64_t max_id = this->g().max_eid();
@@ -222,6 +257,21 @@ public:
         DISPATCH_TO(BinRead, reader);
     }
 
+    // Layout used in place by BinMap(), see io::binary::EdgeIndexIO
+    void BinWriteMapped(std::ostream &os) const {
+        mmapped::write(os, uint64_t(large_index_));
+        DISPATCH_TO(BinWriteMapped, os);
+    }
+
+    // Uses the index saved by BinWriteMapped() in place. The k-mer index is
+    // used read-only, the values are copied on write when the index is
+    // updated. The mapping ends at end and is kept alive by the holder.
+    void BinMap(const uint8_t *&data, const uint8_t *end, std::shared_ptr<void> holder) {
+        VERIFY(inner_index_ == nullptr);
+        large_index_ = mmapped::read<uint64_t>(data, end);
+        DISPATCH_TO(BinMap, data, end, std::move(holder));
+    }
+
 };
 
 #undef DISPATCH_TO
@@ -29,13 +29,20 @@ omnigraph::MappingPath<debruijn_graph::EdgeId> ShortKMerReadMapper::MapSequence(
 
     // Extract all k-mers from Sequence and count how many times each edge appears.
     // The top one (but with at least min_occ) hits wins
-    phmap::flat_hash_map<EdgeId, unsigned> occ;
+    std::vector<EdgeIndex::KMer> kmers;
+    kmers.reserve(sequence.size() - k_ + 1);
     EdgeIndex::KMer kmer = sequence.start<RtSeq>(k_) >> 'A';
     for (size_t j = k_ - 1; j < sequence.size(); ++j) {
         uint8_t inchar = sequence[j];
         kmer <<= inchar;
+        kmers.push_back(kmer);
+    }
 
-        auto pos = index_->get(kmer);
+    std::vector<std::pair<EdgeId, size_t>> positions(kmers.size());
+    index_->get(kmers.data(), kmers.size(), positions.data());
+
+    phmap::flat_hash_map<EdgeId, unsigned> occ;
+    for (const auto &pos : positions) {
         if (pos.second == EdgeIndex::NOT_FOUND)
             continue;
 
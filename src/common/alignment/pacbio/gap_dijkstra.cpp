@@ -7,10 +7,219 @@
 
 #include "gap_dijkstra.hpp"
 
+#include <algorithm>
+
 namespace sensitive_aligner {
 
 using namespace std;
 
+struct StateInfo {
+    int score = 0;
+    QueueState prev;
+    bool queued = false;
+};
+
+// Open addressing table of the visited states. The entries of the previous
+// runs are told apart by the run stamp, so the table is cleared in O(1) and
+// its memory is reused
+class DijkstraStateTable {
+    struct Slot {
+        QueueState state;
+        StateInfo info;
+        uint32_t stamp = 0;
+    };
+
+    vector<Slot> slots_;
+    unsigned bits_;
+    size_t size_;
+    uint32_t stamp_;
+
+    size_t Position(const QueueState &state) const {
+        size_t pos = (hash<QueueState>()(state) * 0x9E3779B97F4A7C15ULL) >> (64 - bits_);
+        while (slots_[pos].stamp == stamp_ && slots_[pos].state != state)
+            pos = (pos + 1) & (slots_.size() - 1);
+        return pos;
+    }
+
+    void Grow() {
+        vector<Slot> slots(slots_.size() * 2);
+        swap(slots, slots_);
+        bits_ += 1;
+        for (const Slot &slot : slots) {
+            if (slot.stamp == stamp_)
+                slots_[Position(slot.state)] = slot;
+        }
+    }
+
+  public:
+    static const unsigned MIN_BITS = 10;
+
+    DijkstraStateTable()
+            : slots_(size_t(1) << MIN_BITS), bits_(MIN_BITS), size_(0), stamp_(1) {}
+
+    void clear() {
+        size_ = 0;
+        if (++stamp_ == 0) {
+            for (Slot &slot : slots_)
+                slot.stamp = 0;
+            stamp_ = 1;
+        }
+    }
+
+    StateInfo *find(const QueueState &state) {
+        Slot &slot = slots_[Position(state)];
+        return slot.stamp == stamp_ ? &slot.info : nullptr;
+    }
+
+    // The reference is valid until the next insertion
+    StateInfo &insert(const QueueState &state) {
+        if (2 * (size_ + 1) > slots_.size())
+            Grow();
+        Slot &slot = slots_[Position(state)];
+        if (slot.stamp != stamp_) {
+            slot.state = state;
+            slot.info = StateInfo();
+            slot.stamp = stamp_;
+            size_ += 1;
+        }
+        return slot.info;
+    }
+
+    size_t capacity() const {
+        return slots_.size();
+    }
+};
+
+// Bucket queue of the states keyed by the edit distance (which is small)
+// backed by the state table. The states of the same bucket are popped in
+// increasing order, as from the set of (score, state). The entries of the
+// states removed from the queue or moved to the other bucket are skipped
+// lazily
+class DijkstraWorkspace {
+    vector<vector<QueueState>> buckets_;
+    // All the buckets before are empty
+    size_t first_;
+    size_t used_buckets_;
+    size_t queued_;
+
+    static bool Greater(const QueueState &a, const QueueState &b) {
+        return b < a;
+    }
+
+    bool Actual(size_t score, const QueueState &state) {
+        const StateInfo *info = states.find(state);
+        return info && info->queued && size_t(info->score) == score;
+    }
+
+    // Makes the top of the first non-empty bucket actual
+    void Skip() {
+        while (true) {
+            auto &bucket = buckets_[first_];
+            if (bucket.empty()) {
+                first_ += 1;
+            } else if (!Actual(first_, bucket.front())) {
+                pop_heap(bucket.begin(), bucket.end(), Greater);
+                bucket.pop_back();
+            } else {
+                break;
+            }
+        }
+    }
+
+  public:
+    // Larger workspaces are not kept after the run
+    static const size_t MAX_REUSED_STATES = size_t(1) << 20;
+
+    DijkstraStateTable states;
+
+    DijkstraWorkspace()
+            : first_(0), used_buckets_(0), queued_(0) {}
+
+    void clear() {
+        states.clear();
+        for (size_t i = 0; i < used_buckets_; ++i)
+            buckets_[i].clear();
+        first_ = 0;
+        used_buckets_ = 0;
+        queued_ = 0;
+    }
+
+    size_t queue_size() const {
+        return queued_;
+    }
+
+    void Enqueue(const QueueState &state, StateInfo &info) {
+        VERIFY(info.score >= 0 && !info.queued);
+        size_t idx = info.score;
+        if (idx >= buckets_.size())
+            buckets_.resize(idx + 1);
+        used_buckets_ = max(used_buckets_, idx + 1);
+        auto &bucket = buckets_[idx];
+        bucket.push_back(state);
+        push_heap(bucket.begin(), bucket.end(), Greater);
+        info.queued = true;
+        if (queued_++ == 0 || idx < first_)
+            first_ = idx;
+    }
+
+    void Dequeue(StateInfo &info) {
+        if (!info.queued)
+            return;
+        info.queued = false;
+        queued_ -= 1;
+    }
+
+    // Removes the state with the least score (and the least of such states)
+    QueueState Pop(int &score) {
+        VERIFY(queued_ > 0);
+        Skip();
+        auto &bucket = buckets_[first_];
+        QueueState state = bucket.front();
+        pop_heap(bucket.begin(), bucket.end(), Greater);
+        bucket.pop_back();
+        score = int(first_);
+        Dequeue(*states.find(state));
+        return state;
+    }
+};
+
+static thread_local vector<unique_ptr<DijkstraWorkspace>> workspace_pool;
+
+unique_ptr<DijkstraWorkspace> DijkstraGraphSequenceBase::AcquireWorkspace() {
+    if (workspace_pool.empty())
+        return make_unique<DijkstraWorkspace>();
+
+    auto ws = std::move(workspace_pool.back());
+    workspace_pool.pop_back();
+    return ws;
+}
+
+DijkstraGraphSequenceBase::DijkstraGraphSequenceBase(const debruijn_graph::Graph &g,
+                                                     const DijkstraParams &gap_cfg,
+                                                     const std::string &ss,
+                                                     EdgeId start_e, int start_p, int path_max_length)
+        : g_(g)
+        , gap_cfg_(gap_cfg)
+        , ss_(ss)
+        , start_e_(start_e)
+        , start_p_(start_p)
+        , path_max_length_(path_max_length)
+        , min_score_(std::numeric_limits<int>::max())
+        , queue_limit_(gap_cfg_.queue_limit)
+        , iter_limit_(gap_cfg_.iteration_limit)
+        , updates_(0)
+        , ws_(AcquireWorkspace()) {
+    best_ed_.resize(ss_.size(), path_max_length_);
+    AddNewEdge(GraphState(start_e_, start_p_, (int) g_.length(start_e_)), QueueState(), 0);
+}
+
+DijkstraGraphSequenceBase::~DijkstraGraphSequenceBase() {
+    if (ws_ && ws_->states.capacity() <= DijkstraWorkspace::MAX_REUSED_STATES) {
+        ws_->clear();
+        workspace_pool.push_back(std::move(ws_));
+    }
+}
+
 const int DijkstraGraphSequenceBase::SHORT_SEQ_LENGTH;
 const int DijkstraGraphSequenceBase::ED_DEVIATION;
 
@@ -32,22 +241,23 @@ bool DijkstraGraphSequenceBase::IsBetter(int seq_ind, int ed) {
 }
 
 void DijkstraGraphSequenceBase::Update(const QueueState &state, const QueueState &prev_state, int score) {
-    if (visited_.count(state) > 0) {
-        if (visited_[state] >= score) {
+    if (StateInfo *info = ws_->states.find(state)) {
+        if (info->score >= score) {
             ++ updates_;
-            q_.erase(make_pair(visited_[state], state));
+            ws_->Dequeue(*info);
             if (IsBetter(state.i, score)) {
-                q_.insert(make_pair(score, state));
-                visited_[state] = score;
-                prev_states_[state] = prev_state;
+                info->score = score;
+                info->prev = prev_state;
+                ws_->Enqueue(state, *info);
             }
         }
     } else {
         if (IsBetter(state.i, score)) {
             ++ updates_;
-            visited_.insert(make_pair(state, score));
-            prev_states_.insert(make_pair(state, prev_state));
-            q_.insert(make_pair(score, state));
+            StateInfo &new_info = ws_->states.insert(state);
+            new_info.score = score;
+            new_info.prev = prev_state;
+            ws_->Enqueue(state, new_info);
         }
     }
 }
@@ -93,7 +303,7 @@ void DijkstraGraphSequenceBase::AddNewEdge(const GraphState &gs, const QueueStat
 }
 
 bool DijkstraGraphSequenceBase::QueueLimitsExceeded(size_t iter) {
-    return_code_.queue_limit = q_.size() > queue_limit_;
+    return_code_.queue_limit = ws_->queue_size() > queue_limit_;
     return_code_.iter_limit = iter > iter_limit_;
     return return_code_.status;
 }
@@ -103,15 +313,13 @@ bool DijkstraGraphSequenceBase::RunDijkstra() {
     size_t iter = 0;
     QueueState cur_state;
     int ed = 0;
-    while (q_.size() > 0 &&
+    while (ws_->queue_size() > 0 &&
             !QueueLimitsExceeded(iter) &&
             ed <= path_max_length_ &&
             updates_ < gap_cfg_.updates_limit) {
-        cur_state = q_.begin()->second;
-        ed = visited_[cur_state];
+        cur_state = ws_->Pop(ed);
         ++ iter;
-        q_.erase(q_.begin());
-        if (visited_.count(end_qstate_) > 0) {
+        if (ws_->states.find(end_qstate_)) {
             found_path = true;
         }
         if (IsEndPosition(cur_state)) {
@@ -137,13 +345,16 @@ void DijkstraGraphSequenceBase::CloseGap() {
     if (found_path) {
         QueueState state(end_qstate_);
         while (!state.empty()) {
-            min_score_ = visited_[end_qstate_];
-            int start_edge = prev_states_[state].i;
+            const StateInfo *end_info = ws_->states.find(end_qstate_);
+            min_score_ = end_info ? end_info->score : 0;
+            const StateInfo *info = ws_->states.find(state);
+            QueueState prev_state = info ? info->prev : QueueState();
+            int start_edge = prev_state.i;
             int end_edge =  state.i;
             mapping_path_.push_back(state.gs.e,
                                     omnigraph::MappingRange(Range(start_edge, end_edge),
                                             Range(state.gs.start_pos, state.gs.end_pos) ));
-            state = prev_states_[state];
+            state = prev_state;
         }
         mapping_path_.reverse();
     }
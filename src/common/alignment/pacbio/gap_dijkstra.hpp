@@ -12,6 +12,8 @@
 #include "sequence/sequence_tools.hpp"
 #include "utils/perf/perfcounter.hpp"
 
+#include <memory>
+
 namespace sensitive_aligner {
 
 using debruijn_graph::EdgeId;
@@ -143,25 +145,15 @@ struct hash<sensitive_aligner::QueueState> {
 
 namespace sensitive_aligner {
 
+// Visited states and the queue of the run, see gap_dijkstra.cpp
+class DijkstraWorkspace;
+
 class DijkstraGraphSequenceBase {
   public:
     DijkstraGraphSequenceBase(const debruijn_graph::Graph &g,
                               const DijkstraParams &gap_cfg,
                               const std::string &ss,
-                              EdgeId start_e, int start_p, int path_max_length)
-        : g_(g)
-        , gap_cfg_(gap_cfg)
-        , ss_(ss)
-        , start_e_(start_e)
-        , start_p_(start_p)
-        , path_max_length_(path_max_length)
-        , min_score_(std::numeric_limits<int>::max())
-        , queue_limit_(gap_cfg_.queue_limit)
-        , iter_limit_(gap_cfg_.iteration_limit)
-        , updates_(0) {
-        best_ed_.resize(ss_.size(), path_max_length_);
-        AddNewEdge(GraphState(start_e_, start_p_, (int) g_.length(start_e_)), QueueState(), 0);
-    }
+                              EdgeId start_e, int start_p, int path_max_length);
 
     void CloseGap();
 
@@ -198,7 +190,7 @@ class DijkstraGraphSequenceBase {
         return end_qstate_.i;
     }
 
-    ~DijkstraGraphSequenceBase() {}
+    ~DijkstraGraphSequenceBase();
 
   protected:
     bool IsBetter(int seq_ind, int ed);
@@ -234,14 +226,15 @@ class DijkstraGraphSequenceBase {
     static const int SHORT_SEQ_LENGTH = 100;
     static const int ED_DEVIATION = 20;
 
-    std::set<std::pair<int, QueueState>> q_;
-    std::unordered_map<QueueState, int> visited_;
-    std::unordered_map<QueueState, QueueState> prev_states_;
+    // Workspaces are reused by the runs in the same thread
+    static std::unique_ptr<DijkstraWorkspace> AcquireWorkspace();
+
     std::vector<int> best_ed_;
 
     const size_t queue_limit_;
     const size_t iter_limit_;
     size_t updates_;
+    std::unique_ptr<DijkstraWorkspace> ws_;
 };
 
 
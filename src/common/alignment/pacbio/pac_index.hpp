@@ -16,8 +16,11 @@
 #include "alignment/gap_info.hpp"
 #include "assembly_graph/graph_support/basic_vertex_conditions.hpp"
 
+#include "parallel_hashmap/phmap.h"
+
 #include <algorithm>
 #include <set>
+#include <shared_mutex>
 #include <vector>
 
 namespace sensitive_aligner {
@@ -93,8 +96,16 @@ class PacBioMappingIndex {
 
     static const size_t DISTANT_IN_GRAPH = 1000;
     static const size_t MAX_VERTICES_IN_DIJKSTRA_FILTERING = 500;
+    typedef std::pair<VertexId, VertexId> VertexPair;
+    //Submaps are guarded by their own shared locks, so the threads looking up
+    //the distances do not block each other
+    typedef phmap::parallel_flat_hash_map<VertexPair, size_t,
+                                          phmap::Hash<VertexPair>, phmap::EqualTo<VertexPair>,
+                                          std::allocator<std::pair<const VertexPair, size_t>>,
+                                          6, std::shared_mutex> DistanceCache;
+
     //presumably separate class for this and GetDistance
-    mutable std::map<std::pair<VertexId, VertexId>, size_t> distance_cashed_;
+    mutable DistanceCache distance_cashed_;
     size_t read_count_;
     
     mutable size_t rna_filtering_count_;
@@ -301,6 +312,14 @@ class PacBioMappingIndex {
         size_t i = 0;
         for (auto i_iter = mapping_descr.begin(); i_iter != mapping_descr.end();
                 ++i_iter, ++i) {
+            //all the distances from the end of the edge are counted by a single Dijkstra run
+            std::vector<VertexId> targets;
+            for (auto j_iter = std::next(i_iter); j_iter != mapping_descr.end(); ++j_iter) {
+                if (NeedsDistance(*i_iter, *j_iter))
+                    targets.push_back(g_.EdgeStart(j_iter->edgeId));
+            }
+            CacheDistances(g_.EdgeEnd(i_iter->edgeId), targets);
+
             size_t j = i;
             for (auto j_iter = i_iter;
                     j_iter != mapping_descr.end(); ++j_iter, ++j) {
@@ -397,53 +416,85 @@ class PacBioMappingIndex {
         return res;
     }
 
+    bool CachedDistance(VertexId start_v, VertexId end_v, size_t &result) const {
+        return distance_cashed_.if_contains({start_v, end_v},
+                                            [&](const auto &entry) { result = entry.second; });
+    }
+
+    //Distances from start_v to the targets counted by a single bounded Dijkstra run
+    std::vector<size_t> CountDistances(VertexId start_v, const std::vector<VertexId> &end_vs) const {
+        omnigraph::DijkstraHelper<debruijn_graph::Graph>::BoundedDijkstra dijkstra(
+            omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra(g_,
+                    pb_config_.max_path_in_dijkstra,
+                    pb_config_.max_vertex_in_dijkstra));
+        dijkstra.Run(start_v);
+        std::vector<size_t> result(end_vs.size(), size_t(-1));
+        for (size_t i = 0; i < end_vs.size(); ++i) {
+            if (dijkstra.DistanceCounted(end_vs[i]))
+                result[i] = dijkstra.GetDistance(end_vs[i]);
+        }
+        return result;
+    }
+
+    //Caches the distances from start_v to all the targets
+    void CacheDistances(VertexId start_v, const std::vector<VertexId> &end_vs) const {
+        std::vector<VertexId> missing;
+        size_t result;
+        for (VertexId end_v : end_vs) {
+            if (!CachedDistance(start_v, end_v, result))
+                missing.push_back(end_v);
+        }
+        if (missing.empty())
+            return;
+
+        auto distances = CountDistances(start_v, missing);
+        for (size_t i = 0; i < missing.size(); ++i)
+            distance_cashed_.insert({{start_v, missing[i]}, distances[i]});
+    }
+
     size_t GetDistance(VertexId start_v, VertexId end_v,
                        bool update_cache = true) const {
         size_t result = size_t(-1);
-        auto vertex_pair = std::make_pair(start_v, end_v);
-        bool not_found;
-        auto distance_it = distance_cashed_.begin();
-        //FIXME should permit multiple readers
-        #pragma omp critical(pac_index)
-        {
-            distance_it = distance_cashed_.find(vertex_pair);
-            not_found = (distance_it == distance_cashed_.end());
-        }
-        if (not_found) {
-            omnigraph::DijkstraHelper<debruijn_graph::Graph>::BoundedDijkstra dijkstra(
-                omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra(g_,
-                        pb_config_.max_path_in_dijkstra,
-                        pb_config_.max_vertex_in_dijkstra));
-            dijkstra.Run(start_v);
-            if (dijkstra.DistanceCounted(end_v)) {
-                result = dijkstra.GetDistance(end_v);
-            }
-            if (update_cache) {
-                #pragma omp critical(pac_index)
-                distance_cashed_.insert({vertex_pair, result});
-            }
-        } else {
+        if (CachedDistance(start_v, end_v, result)) {
             TRACE("taking from cashed");
-            result = distance_it->second;
+            return result;
         }
 
+        result = CountDistances(start_v, {end_v}).front();
+        if (update_cache)
+            distance_cashed_.insert({{start_v, end_v}, result});
+
         return result;
     }
 
+    bool SimilarOnSameEdge(const QualityRange &a, const QualityRange &b) const {
+        int a_len = a.sorted_positions[1].read_position - a.sorted_positions[0].read_position;
+        int b_len = b.sorted_positions[1].read_position - b.sorted_positions[0].read_position;
+        return g_.int_id(a.edgeId) == g_.int_id(b.edgeId) &&
+               similar(a.sorted_positions[1], b.sorted_positions[0], a_len, b_len);
+    }
+
+    //FIXME: Is this check useful?
+    bool TooFarInRead(const QualityRange &a, const QualityRange &b) const {
+        return a.sorted_positions[a.last_trustable_index].read_position +
+               (int) pb_config_.max_path_in_dijkstra <
+               b.sorted_positions[b.first_trustable_index].read_position;
+    }
+
+    //Whether IsConsistent(a, b) needs the distance between the edges
+    bool NeedsDistance(const QualityRange &a, const QualityRange &b) const {
+        return !SimilarOnSameEdge(a, b) && !TooFarInRead(a, b);
+    }
+
     bool IsConsistent(const QualityRange &a,
                       const QualityRange &b) const {
         EdgeId a_edge = a.edgeId;
         EdgeId b_edge = b.edgeId;
-        int a_len = a.sorted_positions[1].read_position - a.sorted_positions[0].read_position;
-        int b_len = b.sorted_positions[1].read_position - b.sorted_positions[0].read_position;
         DEBUG("Checking consistency: " << g_.int_id(a_edge) << " and " << g_.int_id(b_edge));
-        if (g_.int_id(a_edge) == g_.int_id(b_edge) && similar(a.sorted_positions[1], b.sorted_positions[0], a_len, b_len)) {
+        if (SimilarOnSameEdge(a, b)) {
             return true;
         }
-        //FIXME: Is this check useful?
-        if (a.sorted_positions[a.last_trustable_index].read_position +
-                (int) pb_config_.max_path_in_dijkstra <
-                b.sorted_positions[b.first_trustable_index].read_position) {
+        if (TooFarInRead(a, b)) {
             DEBUG("Clusters are too far in read");
             return false;
         }
@@ -16,7 +16,11 @@
 #include "io/reads/paired_read.hpp"
 #include "io/reads/read_stream_vector.hpp"
 #include "utils/perf/timetracer.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -42,6 +46,7 @@ public:
 
 class SequenceMapperNotifier {
     static constexpr size_t BUFFER_SIZE = 200000;
+    static constexpr size_t READ_BATCH_SIZE = 512;
 public:
     typedef SequenceMapper<Graph> SequenceMapperT;
 
@@ -65,36 +70,42 @@ public:
         std::string lib_str = std::to_string(lib_index);
         TIME_TRACE_SCOPE("SequenceMapperNotifier::ProcessLibrary", lib_str);
         if (threads_count == 0)
-            threads_count = streams.size();
+            threads_count = omp_get_max_threads();
 
         streams.reset();
         NotifyStartProcessLibrary(lib_index, threads_count);
-        size_t counter = 0, n = 15;
-
-        #pragma omp parallel for num_threads(threads_count) shared(counter)
-        for (size_t i = 0; i < streams.size(); ++i) {
-            size_t size = 0;
-            ReadType r;
-            auto& stream = streams[i];
-            while (!stream.eof()) {
-                if (size == BUFFER_SIZE) {
-                    #pragma omp critical
-                    {
-                        counter += size;
-                        if (counter >> n) {
-                            INFO("Processed " << counter << " reads");
-                            n += 1;
-                        }
-                        size = 0;
-                        NotifyMergeBuffer(lib_index, i);
-                    }
+
+        // Reads are taken by small batches from any stream which is not busy,
+        // so all the threads are loaded regardless of the number of streams.
+        // Per-thread buffers of the listeners are merged by the thread which
+        // manages to take the merge lock, others keep on processing.
+        StreamStates states(streams.size());
+        std::mutex merge_lock;
+        std::atomic<size_t> counter{0};
+        std::atomic<unsigned> n{15};
+
+        #pragma omp parallel num_threads(threads_count)
+        {
+            size_t thread_id = omp_get_thread_num();
+            size_t current = thread_id;
+            size_t unmerged = 0;
+            std::vector<ReadType> batch(READ_BATCH_SIZE);
+            while (size_t size = FetchReads(streams, states, current, batch)) {
+                for (size_t i = 0; i < size; ++i)
+                    NotifyProcessRead(batch[i], mapper, lib_index, thread_id);
+
+                size_t processed = counter += size;
+                unsigned log_n = n;
+                if ((processed >> log_n) && n.compare_exchange_strong(log_n, log_n + 1))
+                    INFO("Processed " << processed << " reads");
+
+                unmerged += size;
+                if (unmerged >= BUFFER_SIZE && merge_lock.try_lock()) {
+                    NotifyMergeBuffer(lib_index, thread_id);
+                    merge_lock.unlock();
+                    unmerged = 0;
                 }
-                stream >> r;
-                ++size;
-                NotifyProcessRead(r, mapper, lib_index, i);
             }
-            #pragma omp atomic
-            counter += size;
         }
 
         for (size_t i = 0; i < threads_count; ++i)
@@ -104,6 +115,78 @@ public:
         NotifyStopProcessLibrary(lib_index);
     }
 
+    struct StreamStates {
+        StreamStates(size_t size)
+                : locks(size), exhausted(new std::atomic<bool>[size]), remaining(size) {
+            for (size_t i = 0; i < size; ++i)
+                exhausted[i] = false;
+        }
+
+        std::vector<std::mutex> locks;
+        std::unique_ptr<std::atomic<bool>[]> exhausted;
+        std::atomic<size_t> remaining;
+    };
+
+    // Reads the next batch from the first stream which is neither busy nor
+    // exhausted starting from the current one. Waits for the busy stream only
+    // if all the other ones are taken. Returns 0 if all the streams are exhausted.
+    template<class ReadType>
+    static size_t FetchReads(io::ReadStreamList<ReadType>& streams, StreamStates &states,
+                             size_t &current, std::vector<ReadType> &batch) {
+        while (states.remaining) {
+            size_t busy = -1ULL;
+            for (size_t i = 0; i < streams.size(); ++i) {
+                size_t idx = (current + i) % streams.size();
+                if (states.exhausted[idx])
+                    continue;
+
+                if (!states.locks[idx].try_lock()) {
+                    if (busy == -1ULL)
+                        busy = idx;
+                    continue;
+                }
+
+                size_t size = FillBatch(streams, states, idx, batch);
+                if (size) {
+                    current = idx;
+                    return size;
+                }
+            }
+
+            if (busy == -1ULL)
+                continue;
+
+            states.locks[busy].lock();
+            size_t size = FillBatch(streams, states, busy, batch);
+            if (size) {
+                current = busy;
+                return size;
+            }
+        }
+
+        return 0;
+    }
+
+    // Reads the batch from the locked stream and releases the lock
+    template<class ReadType>
+    static size_t FillBatch(io::ReadStreamList<ReadType>& streams, StreamStates &states,
+                            size_t idx, std::vector<ReadType> &batch) {
+        auto &stream = streams[idx];
+        size_t size = 0;
+        if (!states.exhausted[idx]) {
+            while (size < batch.size() && !stream.eof())
+                stream >> batch[size++];
+
+            if (stream.eof()) {
+                states.exhausted[idx] = true;
+                states.remaining -= 1;
+            }
+        }
+        states.locks[idx].unlock();
+
+        return size;
+    }
+
 private:
     template<class ReadType>
     void NotifyProcessRead(const ReadType& r, const SequenceMapperT& mapper, size_t ilib, size_t ithread) const;
@@ -483,7 +483,7 @@ private:
 #       pragma omp parallel for schedule(guided)
         for (size_t i = 0; i < size; ++i) {
             size_t j = i << 1;
-            EdgeId edge = helper.AddEdge(DeBruijnEdgeData(sequences[i]), min_id + j);
+            EdgeId edge = helper.AddEdge(DeBruijnEdgeData(graph.master().Store(sequences[i])), min_id + j);
             records[j] = StartLink(edge, sequences[i]);
             if (graph.conjugate(edge) != edge)
                 records[j + 1] = EndLink(edge, sequences[i]);
@@ -121,12 +121,11 @@ public:
     }
 
     void DeleteUnlinkedEdge(EdgeId e) {
-        EdgeId rc = graph_.conjugate(e);
-        graph_.DestroyEdge(e, rc);
+        graph_.ReleaseEdge(e);
     }
 
     void DeleteUnlinkedVertex(VertexId v) {
-        graph_.DestroyVertex(v);
+        graph_.ReleaseVertex(v);
     }
 
     VertexId CreateVertex(VertexData data, VertexId id = 0) {
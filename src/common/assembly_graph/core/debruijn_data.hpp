@@ -15,6 +15,7 @@
 #include <llvm/ADT/PointerSumType.h>
 #include <llvm/ADT/PointerEmbeddedInt.h>
 
+#include <memory>
 #include <utility>
 #include <vector>
 #include <set>
@@ -230,6 +231,8 @@ public:
 class DeBruijnDataMaster {
 private:
     unsigned k_;
+    // Storage of the edge sequences (if any)
+    std::shared_ptr<NuclArena> arena_;
 
 public:
     typedef DeBruijnVertexData VertexData;
@@ -237,8 +240,28 @@ public:
     typedef DeBruijnVertexData::LinkId LinkId;
     typedef DeBruijnVertexData::OverlapStorage OverlapStorage;
 
-    DeBruijnDataMaster(unsigned k)
-            : k_(k) {}
+    DeBruijnDataMaster(unsigned k, bool use_arena = true)
+            : k_(k), arena_(use_arena ? std::make_shared<NuclArena>() : nullptr) {}
+
+    NuclArena *arena() const {
+        return arena_.get();
+    }
+
+    // Sequence to be kept by the edge data
+    Sequence Store(const Sequence &nucls) const {
+        if (!arena_ || nucls.in_arena())
+            return nucls;
+        return Sequence(nucls, *arena_);
+    }
+
+    // Copies the nucleotides of the edge (and of its conjugate sharing them)
+    // into the arena
+    void Relocate(EdgeData &data, EdgeData &conjugate) const {
+        VERIFY(arena_);
+        data.nucls_ = Sequence(data.nucls_, *arena_);
+        if (&conjugate != &data)
+            conjugate.nucls_ = !data.nucls_;
+    }
 
     const EdgeData MergeData(const std::vector<const EdgeData *> &to_merge, const std::vector<uint32_t> &overlaps,
                              bool safe_merging = true) const;
@@ -289,7 +312,7 @@ inline const DeBruijnEdgeData DeBruijnDataMaster::MergeData(const std::vector<co
     for (auto it = to_merge.begin(); it != to_merge.end(); ++it) {
         ss.push_back((*it)->nucls());
     }
-    return EdgeData(MergeOverlappingSequences(ss, overlaps, safe_merging));
+    return EdgeData(Store(MergeOverlappingSequences(ss, overlaps, safe_merging)));
 }
 
 inline std::tuple<DeBruijnVertexData, DeBruijnEdgeData, DeBruijnEdgeData> DeBruijnDataMaster::SplitData(const EdgeData& edge,
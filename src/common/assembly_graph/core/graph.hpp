@@ -157,7 +157,41 @@ public:
 
     EdgeId AddEdge(VertexId from, VertexId to, const Sequence &nucls) {
         VERIFY(nucls.size() > k());
-        return AddEdge(from, to, EdgeData(nucls));
+        return AddEdge(from, to, EdgeData(master().Store(nucls)));
+    }
+
+    /**
+     * Moves the edge sequences to the fresh arena slabs if the arena is
+     * mostly taken by the sequences of the removed edges (or by the larger
+     * sequences the edges were split from). The slabs are not reused while
+     * they belong to the arena, so this should be called periodically if
+     * many edges are removed (e.g. between the simplification cycles)
+     */
+    void CompactSequences() {
+        NuclArena *arena = master().arena();
+        if (!arena)
+            return;
+
+        std::vector<EdgeId> edges;
+        size_t required = 0;
+        for (EdgeId e : canonical_edges()) {
+            edges.push_back(e);
+            required += EdgeNucls(e).size() / 4 + 16;
+        }
+        // Live buffers pinned by the short edges, or slabs of the removed
+        // edges (the current slab is partially filled anyway)
+        size_t live = arena->live(), reserved = arena->reserved();
+        if (2 * required >= live && 2 * (required + NuclArena::SLAB_SIZE) >= reserved)
+            return;
+
+        arena->Renew();
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < edges.size(); ++i) {
+            EdgeId e = edges[i];
+            master().Relocate(data(e), data(conjugate(e)));
+        }
+        INFO("Edge sequences compacted: " << reserved / 1024 / 1024 << " MB -> "
+             << arena->reserved() / 1024 / 1024 << " MB");
     }
 
     unsigned k() const {
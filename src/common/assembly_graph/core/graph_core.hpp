@@ -14,6 +14,8 @@
 
 #include "adt/iterator_range.hpp"
 #include "adt/small_pod_vector.hpp"
+// after small_pod_vector.hpp, folly redefines its LIKELY macros
+#include "vertex_locks.hpp"
 
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/iterator/iterator_adaptor.hpp>
@@ -21,6 +23,7 @@
 #include <boost/noncopyable.hpp>
 
 #include <atomic>
+#include <mutex>
 #include <vector>
 
 namespace omnigraph {
@@ -256,6 +259,7 @@ private:
 
         IdStorage(uint64_t bias = ID_BIAS)
                 : size_(0), bias_(bias), storage_(nullptr), storage_size_(0), id_distributor_(bias) {
+            lock_.init(0);
             resize(id_distributor_.size() + bias_);
         }
 
@@ -291,8 +295,11 @@ private:
             return id < storage_size_ && id_distributor_.occupied(id);
         }
 
+        // Thread-safe, though growing the storage relocates the elements, so
+        // the concurrent readers need the storage to be reserved beforehand
         template<typename... ArgTypes>
         uint64_t create(ArgTypes &&... args) {
+            std::lock_guard<folly::PicoSpinLock<uint16_t>> guard(lock_);
             uint64_t id = id_distributor_.allocate();
 
             while (storage_size_ < id + 1)
@@ -308,9 +315,11 @@ private:
         template<typename... ArgTypes>
         uint64_t emplace(uint64_t at, ArgTypes &&... args) {
             // One MUST call reserve before using emplace()
-            VERIFY(!id_distributor_.occupied(at));
-
-            id_distributor_.acquire(at);
+            {
+                std::lock_guard<folly::PicoSpinLock<uint16_t>> guard(lock_);
+                VERIFY(!id_distributor_.occupied(at));
+                id_distributor_.acquire(at);
+            }
             new(storage_ + at) T(std::forward<ArgTypes>(args)...);;
             size_.fetch_add(1);
 
@@ -324,6 +333,7 @@ private:
             // INFO("Remove " << id << ":" << typeid(T).name());
             v->~T();
 
+            std::lock_guard<folly::PicoSpinLock<uint16_t>> guard(lock_);
             id_distributor_.release(id);
             size_ -= 1;
         }
@@ -341,12 +351,15 @@ private:
         T *storage_;
         size_t storage_size_;
         omnigraph::ReclaimingIdDistributor id_distributor_;
+        // Guards the id distributor (and the storage growth)
+        folly::PicoSpinLock<uint16_t> lock_;
     };
 
     using VertexStorage = IdStorage<PairedVertex<DataMaster>>;
     VertexStorage vstorage_;
     using EdgeStorage = IdStorage<PairedEdge<DataMaster>>;
     EdgeStorage estorage_;
+    VertexLockTable vertex_locks_;
 
     PairedVertex<DataMaster>& vertex(VertexId id) const noexcept {
         return vstorage_.at(id.int_id());
@@ -664,14 +677,27 @@ protected:
         return result;
     }
 
-    void HiddenDeleteEdge(EdgeId e) {
-        TRACE("Hidden delete edge " << e.int_id());
+    // Removes the edge from the adjacency of its vertices keeping its data
+    void HiddenUnlinkEdge(EdgeId e) {
         EdgeId rcEdge = conjugate(e);
         VertexId rcStart = conjugate(edge(e).end());
         VertexId start = conjugate(edge(rcEdge).end());
         vertex(start).RemoveOutgoingEdge(e);
         vertex(rcStart).RemoveOutgoingEdge(rcEdge);
-        DestroyEdge(e, rcEdge);
+    }
+
+    void HiddenDestroyEdge(EdgeId e) {
+        DestroyEdge(e, conjugate(e));
+    }
+
+    void HiddenDestroyVertex(VertexId v) {
+        DestroyVertex(v);
+    }
+
+    void HiddenDeleteEdge(EdgeId e) {
+        TRACE("Hidden delete edge " << e.int_id());
+        HiddenUnlinkEdge(e);
+        HiddenDestroyEdge(e);
     }
 
     void HiddenDeletePath(const std::vector<EdgeId>& edgesToDelete,
@@ -702,6 +728,12 @@ public:
     size_t vreserved() const { return vstorage_.reserved(); }
     size_t ereserved() const { return estorage_.reserved(); }
 
+    const VertexLockTable &vertex_locks() const noexcept { return vertex_locks_; }
+    // The same for the vertex and its conjugate
+    size_t vertex_lock_stripe(VertexId v) const noexcept {
+        return VertexLockTable::stripe(std::min(v, conjugate(v)).int_id());
+    }
+
     uint64_t min_id() const noexcept { return ID_BIAS; }
 
     bool contains(VertexId vertex) const {
@@ -266,6 +266,10 @@ public:
         inner_it_.ReleaseCurrent();
     }
 
+    std::vector<ElementId> Upcoming(size_t cnt) const {
+        return inner_it_.Upcoming(cnt);
+    }
+
 };
 
 /**
@@ -0,0 +1,240 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "adt/iterator_range.hpp"
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace omnigraph {
+
+/**
+ * Frozen copy of the graph topology for read-only passes. Adjacency is kept
+ * in CSR form, edge lengths and coverages are kept in contiguous arrays, and
+ * vertices / edges are renumbered densely (canonical ones first, followed by
+ * their conjugates). The snapshot exposes the same ids and the same
+ * iteration API as the graph, so it could be passed to Dijkstra (see
+ * DijkstraHelper), PathProcessor and graph statistics instead of the graph
+ * itself (e.g. GraphDistanceFinder runs the path search on it). It is
+ * immutable and does not track graph modifications, so it could be shared
+ * across threads.
+ */
+template<class Graph>
+class GraphSnapshot {
+  public:
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef const EdgeId *edge_const_iterator;
+    typedef typename std::vector<VertexId>::const_iterator VertexIt;
+    typedef VertexIt iterator;
+    typedef typename std::vector<EdgeId>::const_iterator EdgeIt;
+
+    static constexpr uint32_t NO_INDEX = uint32_t(-1);
+
+  private:
+    // dense index -> id
+    std::vector<VertexId> vertices_;
+    std::vector<EdgeId> edges_;
+    size_t canonical_vertices_;
+    size_t canonical_edges_;
+
+    // id -> dense index
+    std::vector<uint32_t> vindex_;
+    std::vector<uint32_t> eindex_;
+
+    // CSR adjacency, indexed by the dense vertex index
+    std::vector<size_t> out_offsets_, in_offsets_;
+    std::vector<EdgeId> out_edges_, in_edges_;
+
+    // Indexed by the dense edge index
+    std::vector<VertexId> edge_start_, edge_end_;
+    std::vector<EdgeId> edge_conjugate_;
+    std::vector<size_t> length_;
+    std::vector<double> coverage_;
+
+    template<class Adjacency>
+    static void Fill(const std::vector<VertexId> &vertices,
+                     std::vector<size_t> &offsets, std::vector<EdgeId> &adjacent,
+                     Adjacency adjacency) {
+        size_t n = vertices.size();
+        offsets.assign(n + 1, 0);
+        for (size_t i = 0; i < n; ++i) {
+            auto edges = adjacency(vertices[i]);
+            offsets[i + 1] = offsets[i] + std::distance(edges.begin(), edges.end());
+        }
+        adjacent.resize(offsets[n]);
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < n; ++i) {
+            auto edges = adjacency(vertices[i]);
+            std::copy(edges.begin(), edges.end(), adjacent.begin() + offsets[i]);
+        }
+    }
+
+  public:
+    explicit GraphSnapshot(const Graph &g) {
+        for (VertexId v : g.canonical_vertices())
+            vertices_.push_back(v);
+        canonical_vertices_ = vertices_.size();
+        for (size_t i = 0; i < canonical_vertices_; ++i)
+            vertices_.push_back(g.conjugate(vertices_[i]));
+        VERIFY(vertices_.size() == g.size());
+
+        for (EdgeId e : g.canonical_edges())
+            edges_.push_back(e);
+        canonical_edges_ = edges_.size();
+        for (size_t i = 0; i < canonical_edges_; ++i) {
+            if (g.conjugate(edges_[i]) != edges_[i])
+                edges_.push_back(g.conjugate(edges_[i]));
+        }
+        VERIFY(edges_.size() == g.e_size());
+        VERIFY(vertices_.size() < NO_INDEX && edges_.size() < NO_INDEX);
+
+        vindex_.assign(g.max_vid(), NO_INDEX);
+        for (size_t i = 0; i < vertices_.size(); ++i)
+            vindex_[vertices_[i].int_id()] = uint32_t(i);
+        eindex_.assign(g.max_eid(), NO_INDEX);
+        for (size_t i = 0; i < edges_.size(); ++i)
+            eindex_[edges_[i].int_id()] = uint32_t(i);
+
+        Fill(vertices_, out_offsets_, out_edges_,
+             [&](VertexId v) { return g.OutgoingEdges(v); });
+        Fill(vertices_, in_offsets_, in_edges_,
+             [&](VertexId v) { return g.IncomingEdges(v); });
+
+        size_t m = edges_.size();
+        edge_start_.resize(m);
+        edge_end_.resize(m);
+        edge_conjugate_.resize(m);
+        length_.resize(m);
+        coverage_.resize(m);
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < m; ++i) {
+            EdgeId e = edges_[i];
+            edge_start_[i] = g.EdgeStart(e);
+            edge_end_[i] = g.EdgeEnd(e);
+            edge_conjugate_[i] = g.conjugate(e);
+            length_[i] = g.length(e);
+            coverage_[i] = g.coverage(e);
+        }
+    }
+
+    GraphSnapshot(const GraphSnapshot&) = delete;
+    GraphSnapshot &operator=(const GraphSnapshot&) = delete;
+    GraphSnapshot(GraphSnapshot&&) = default;
+    GraphSnapshot &operator=(GraphSnapshot&&) = default;
+
+    size_t size() const noexcept { return vertices_.size(); }
+    size_t e_size() const noexcept { return edges_.size(); }
+
+    bool contains(VertexId v) const noexcept {
+        return v.int_id() < vindex_.size() && vindex_[v.int_id()] != NO_INDEX;
+    }
+    bool contains(EdgeId e) const noexcept {
+        return e.int_id() < eindex_.size() && eindex_[e.int_id()] != NO_INDEX;
+    }
+
+    // Dense indices in [0, size()) and [0, e_size()). Conjugate vertices
+    // are exactly size() / 2 apart
+    size_t index(VertexId v) const noexcept { return vindex_[v.int_id()]; }
+    size_t index(EdgeId e) const noexcept { return eindex_[e.int_id()]; }
+    VertexId vertex(size_t idx) const noexcept { return vertices_[idx]; }
+    EdgeId edge(size_t idx) const noexcept { return edges_[idx]; }
+
+    size_t int_id(EdgeId edge) const noexcept { return edge.int_id(); }
+    size_t int_id(VertexId vertex) const noexcept { return vertex.int_id(); }
+
+    VertexIt begin() const noexcept { return vertices_.begin(); }
+    VertexIt end() const noexcept { return vertices_.end(); }
+    auto vertices() const { return adt::make_range(vertices_.begin(), vertices_.end()); }
+    auto canonical_vertices() const {
+        return adt::make_range(vertices_.begin(), vertices_.begin() + canonical_vertices_);
+    }
+    auto edges() const { return adt::make_range(edges_.begin(), edges_.end()); }
+    auto canonical_edges() const {
+        return adt::make_range(edges_.begin(), edges_.begin() + canonical_edges_);
+    }
+
+    adt::iterator_range<edge_const_iterator> OutgoingEdges(VertexId v) const noexcept {
+        size_t i = index(v);
+        return { out_edges_.data() + out_offsets_[i], out_edges_.data() + out_offsets_[i + 1] };
+    }
+    adt::iterator_range<edge_const_iterator> IncomingEdges(VertexId v) const noexcept {
+        size_t i = index(v);
+        return { in_edges_.data() + in_offsets_[i], in_edges_.data() + in_offsets_[i + 1] };
+    }
+    edge_const_iterator out_begin(VertexId v) const noexcept { return OutgoingEdges(v).begin(); }
+    edge_const_iterator out_end(VertexId v) const noexcept { return OutgoingEdges(v).end(); }
+    edge_const_iterator in_begin(VertexId v) const noexcept { return IncomingEdges(v).begin(); }
+    edge_const_iterator in_end(VertexId v) const noexcept { return IncomingEdges(v).end(); }
+    size_t OutgoingEdgeCount(VertexId v) const noexcept {
+        size_t i = index(v);
+        return out_offsets_[i + 1] - out_offsets_[i];
+    }
+    size_t IncomingEdgeCount(VertexId v) const noexcept {
+        size_t i = index(v);
+        return in_offsets_[i + 1] - in_offsets_[i];
+    }
+    std::vector<EdgeId> IncidentEdges(VertexId v) const {
+        std::vector<EdgeId> answer(IncomingEdges(v).begin(), IncomingEdges(v).end());
+        answer.insert(answer.end(), OutgoingEdges(v).begin(), OutgoingEdges(v).end());
+        return answer;
+    }
+
+    bool CheckUniqueOutgoingEdge(VertexId v) const noexcept { return OutgoingEdgeCount(v) == 1; }
+    bool CheckUniqueIncomingEdge(VertexId v) const noexcept { return IncomingEdgeCount(v) == 1; }
+    EdgeId GetUniqueOutgoingEdge(VertexId v) const {
+        VERIFY(CheckUniqueOutgoingEdge(v));
+        return *OutgoingEdges(v).begin();
+    }
+    EdgeId GetUniqueIncomingEdge(VertexId v) const {
+        VERIFY(CheckUniqueIncomingEdge(v));
+        return *IncomingEdges(v).begin();
+    }
+    bool IsDeadEnd(VertexId v) const noexcept { return OutgoingEdgeCount(v) == 0; }
+    bool IsDeadStart(VertexId v) const noexcept { return IncomingEdgeCount(v) == 0; }
+
+    VertexId EdgeStart(EdgeId e) const noexcept { return edge_start_[index(e)]; }
+    VertexId EdgeEnd(EdgeId e) const noexcept { return edge_end_[index(e)]; }
+
+    VertexId conjugate(VertexId v) const noexcept {
+        size_t i = index(v);
+        return vertices_[i < canonical_vertices_ ? i + canonical_vertices_ : i - canonical_vertices_];
+    }
+    EdgeId conjugate(EdgeId e) const noexcept { return edge_conjugate_[index(e)]; }
+
+    size_t length(EdgeId e) const noexcept { return length_[index(e)]; }
+    double coverage(EdgeId e) const noexcept { return coverage_[index(e)]; }
+
+    std::string str(EdgeId e) const {
+        std::stringstream ss;
+        ss << int_id(e) << " (" << length(e) << ")";
+        return ss.str();
+    }
+
+    std::string str(VertexId v) const {
+        return std::to_string(int_id(v));
+    }
+
+    template<class Container>
+    std::string str(const Container& container) const {
+        std::stringstream ss;
+        std::string delim = "";
+        for (const auto &el : container) {
+            ss << delim << str(el);
+            delim = ", ";
+        }
+        return ss.str();
+    }
+};
+
+}
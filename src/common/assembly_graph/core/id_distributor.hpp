@@ -34,14 +34,12 @@ class ReclaimingIdDistributor {
     bool occupied(uint64_t at) const {
         return !free_map_[at - bias_];
     }
+    // Not thread-safe: the neighbouring bits share the word, the owner
+    // (see GraphCore::IdStorage) serializes the modifications
     void acquire(uint64_t at) {
-        // FIXME: "lock" only single bit
-#pragma omp critical
         free_map_[at - bias_] = false;
     }
     void release(uint64_t at) {
-        // FIXME: "lock" only single bit
-#pragma omp critical
         free_map_[at - bias_] = true;
     }
 
@@ -11,9 +11,11 @@
 #include "utils/logger/logger.hpp"
 #include "graph_core.hpp"
 #include "graph_iterators.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include <vector>
 #include <set>
+#include <mutex>
 #include <cstring>
 
 namespace omnigraph {
@@ -36,9 +38,70 @@ public:
     typedef ActionHandler<VertexId, EdgeId> Handler;
 
 private:
+    friend class ConstructionHelper<DataMaster>;
+
+    // Event (or postponed destruction of the removed element) collected
+    // during concurrent modification
+    struct Event {
+        enum class Type {
+            AddVertex, AddEdge, DeleteVertex, DeleteEdge,
+            Merge, Glue, Split,
+            DestroyVertex, DestroyEdge
+        };
+
+        Event(Type type, VertexId v)
+                : type(type), v(v) {}
+        Event(Type type, EdgeId e1, EdgeId e2 = EdgeId(), EdgeId e3 = EdgeId())
+                : type(type), e1(e1), e2(e2), e3(e3) {}
+        Event(const std::vector<EdgeId> &old_edges, EdgeId new_edge)
+                : type(Type::Merge), e1(new_edge), path(old_edges) {}
+
+        Type type;
+        VertexId v;
+        EdgeId e1, e2, e3;
+        std::vector<EdgeId> path;
+    };
+
    //todo switch to smart iterators
    mutable std::vector<Handler*> action_handler_list_;
    std::unique_ptr<const HandlerApplier<VertexId, EdgeId>> applier_;
+   // Guards the handler list and the delivery of the collected events
+   mutable std::recursive_mutex handlers_lock_;
+   // Per-thread events of concurrent modification
+   mutable std::vector<std::vector<Event>> batches_;
+   bool concurrent_ = false;
+
+    std::vector<Event> *ThreadBatch() const {
+        if (!concurrent_)
+            return nullptr;
+        size_t thread = omp_get_thread_num();
+        VERIFY_MSG(thread < batches_.size(), "Concurrent modification was started for " << batches_.size() << " threads");
+        return &batches_[thread];
+    }
+
+    void DeliverEvents(std::vector<Event> &batch);
+
+    // Unlinks the edge and destroys it right away or, during concurrent
+    // modification, once the events about it are delivered
+    void HiddenRemoveEdge(EdgeId e);
+
+    void ReleaseEdge(EdgeId e);
+
+    void ReleaseVertex(VertexId v);
+
+    void NotifyAddVertex(VertexId v) const;
+
+    void NotifyAddEdge(EdgeId e) const;
+
+    void NotifyDeleteVertex(VertexId v) const;
+
+    void NotifyDeleteEdge(EdgeId e) const;
+
+    void NotifyMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) const;
+
+    void NotifyGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) const;
+
+    void NotifySplit(EdgeId edge, EdgeId new_edge1, EdgeId new_edge2) const;
 
 public:
 //todo move to graph core
@@ -82,6 +145,28 @@ public:
 
     bool VerifyAllDetached();
 
+    /**
+     * Concurrent modification mode. The threads (at most nthreads) could
+     * modify the graph holding the locks of all the vertices involved (see
+     * VertexTransaction); the events are collected thread-locally and
+     * delivered to the handlers in batches, one batch at a time, when the
+     * transaction is finished (see FlushEvents). The removed elements are
+     * destroyed only after the handlers are notified about the removal, so
+     * the handlers could still access their data.
+     * The storage should be reserved beforehand if new elements are added,
+     * since growing the storage relocates the elements.
+     */
+    void StartConcurrentModification(size_t nthreads = omp_get_max_threads());
+
+    // Delivers the remaining events of all the threads, should be called
+    // outside of the parallel region
+    void FinishConcurrentModification();
+
+    bool concurrent_modification() const { return concurrent_; }
+
+    // Delivers the events collected by the current thread
+    void FlushEvents();
+
     //smart iterators
     template<typename Priority>
     SmartVertexIterator<ObservableGraph, Priority> SmartVertexBegin(
@@ -148,6 +233,15 @@ public:
                      bool safe_merging = true,
                      std::vector<uint32_t> overlaps = std::vector<uint32_t>());
 
+    // Data of the edge the (corrected, see CorrectMergePath) path is merged into
+    EdgeData MergedData(const std::vector<EdgeId> &path,
+                        bool safe_merging = true,
+                        std::vector<uint32_t> overlaps = std::vector<uint32_t>()) const;
+
+    // Replaces the (corrected) path with the new edge of the given data,
+    // e.g. built by MergedData beforehand
+    EdgeId ReplacePath(const std::vector<EdgeId> &path, EdgeData data);
+
     std::pair<EdgeId, EdgeId> SplitEdge(EdgeId edge, size_t position);
 
     EdgeId GlueEdges(EdgeId edge1, EdgeId edge2);
@@ -169,7 +263,7 @@ void ObservableGraph<DataMaster>::DeleteVertex(VertexId v) {
     VERIFY(base::IsDeadEnd(v) && base::IsDeadStart(v));
     VERIFY(v != VertexId());
     FireDeleteVertex(v);
-    base::HiddenDeleteVertex(v);
+    ReleaseVertex(v);
 }
 
 template<class DataMaster>
@@ -199,7 +293,7 @@ ObservableGraph<DataMaster>::AddEdge(EdgeData data, EdgeId id1, EdgeId id2) {
 template<class DataMaster>
 void ObservableGraph<DataMaster>::DeleteEdge(EdgeId e) {
     FireDeleteEdge(e);
-    base::HiddenDeleteEdge(e);
+    HiddenRemoveEdge(e);
 }
 
 template<class DataMaster>
@@ -265,7 +359,7 @@ std::vector<typename ObservableGraph<DataMaster>::VertexId>
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::AddActionHandler(Handler* action_handler) const {
-#pragma omp critical(action_handler_list_modification)
+    std::lock_guard<std::recursive_mutex> guard(handlers_lock_);
     {
         TRACE("Action handler " << action_handler->name() << " added");
         if (std::find(action_handler_list_.begin(), action_handler_list_.end(), action_handler) != action_handler_list_.end()) {
@@ -279,7 +373,7 @@ void ObservableGraph<DataMaster>::AddActionHandler(Handler* action_handler) cons
 template<class DataMaster>
 bool ObservableGraph<DataMaster>::RemoveActionHandler(const Handler* action_handler) const {
     bool result = false;
-#pragma omp critical(action_handler_list_modification)
+    std::lock_guard<std::recursive_mutex> guard(handlers_lock_);
     {
         auto it = std::find(action_handler_list_.begin(), action_handler_list_.end(), action_handler);
         if (it != action_handler_list_.end()) {
@@ -320,7 +414,7 @@ void ObservableGraph<DataMaster>::FireGameOver() const {
 }
 
 template<class DataMaster>
-void ObservableGraph<DataMaster>::FireAddVertex(VertexId v) const {
+void ObservableGraph<DataMaster>::NotifyAddVertex(VertexId v) const {
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             TRACE("FireAddVertex to handler " << handler_ptr->name());
@@ -330,7 +424,7 @@ void ObservableGraph<DataMaster>::FireAddVertex(VertexId v) const {
 }
 
 template<class DataMaster>
-void ObservableGraph<DataMaster>::FireAddEdge(EdgeId e) const {
+void ObservableGraph<DataMaster>::NotifyAddEdge(EdgeId e) const {
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             TRACE("FireAddEdge to handler " << handler_ptr->name());
@@ -340,7 +434,7 @@ void ObservableGraph<DataMaster>::FireAddEdge(EdgeId e) const {
 }
 
 template<class DataMaster>
-void ObservableGraph<DataMaster>::FireDeleteVertex(VertexId v) const {
+void ObservableGraph<DataMaster>::NotifyDeleteVertex(VertexId v) const {
     for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
         if ((*it)->IsAttached()) {
             applier_->ApplyDelete(**it, v);
@@ -349,7 +443,7 @@ void ObservableGraph<DataMaster>::FireDeleteVertex(VertexId v) const {
 }
 
 template<class DataMaster>
-void ObservableGraph<DataMaster>::FireDeleteEdge(EdgeId e) const {
+void ObservableGraph<DataMaster>::NotifyDeleteEdge(EdgeId e) const {
     for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
         if ((*it)->IsAttached()) {
             applier_->ApplyDelete(**it, e);
@@ -358,7 +452,7 @@ void ObservableGraph<DataMaster>::FireDeleteEdge(EdgeId e) const {
 }
 
 template<class DataMaster>
-void ObservableGraph<DataMaster>::FireMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) const {
+void ObservableGraph<DataMaster>::NotifyMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) const {
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             applier_->ApplyMerge(*handler_ptr, old_edges, new_edge);
@@ -367,7 +461,7 @@ void ObservableGraph<DataMaster>::FireMerge(const std::vector<EdgeId> &old_edges
 }
 
 template<class DataMaster>
-void ObservableGraph<DataMaster>::FireGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) const {
+void ObservableGraph<DataMaster>::NotifyGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) const {
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             applier_->ApplyGlue(*handler_ptr, new_edge, edge1, edge2);
@@ -376,7 +470,7 @@ void ObservableGraph<DataMaster>::FireGlue(EdgeId new_edge, EdgeId edge1, EdgeId
 }
 
 template<class DataMaster>
-void ObservableGraph<DataMaster>::FireSplit(EdgeId edge, EdgeId new_edge1, EdgeId new_edge2) const {
+void ObservableGraph<DataMaster>::NotifySplit(EdgeId edge, EdgeId new_edge1, EdgeId new_edge2) const {
     for (Handler* handler_ptr : action_handler_list_) {
         if (handler_ptr->IsAttached()) {
             applier_->ApplySplit(*handler_ptr, edge, new_edge1, new_edge2);
@@ -384,6 +478,147 @@ void ObservableGraph<DataMaster>::FireSplit(EdgeId edge, EdgeId new_edge1, EdgeI
     }
 }
 
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FireAddVertex(VertexId v) const {
+    if (auto batch = ThreadBatch())
+        batch->emplace_back(Event::Type::AddVertex, v);
+    else
+        NotifyAddVertex(v);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FireAddEdge(EdgeId e) const {
+    if (auto batch = ThreadBatch())
+        batch->emplace_back(Event::Type::AddEdge, e);
+    else
+        NotifyAddEdge(e);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FireDeleteVertex(VertexId v) const {
+    if (auto batch = ThreadBatch())
+        batch->emplace_back(Event::Type::DeleteVertex, v);
+    else
+        NotifyDeleteVertex(v);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FireDeleteEdge(EdgeId e) const {
+    if (auto batch = ThreadBatch())
+        batch->emplace_back(Event::Type::DeleteEdge, e);
+    else
+        NotifyDeleteEdge(e);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FireMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) const {
+    if (auto batch = ThreadBatch())
+        batch->emplace_back(old_edges, new_edge);
+    else
+        NotifyMerge(old_edges, new_edge);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FireGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) const {
+    if (auto batch = ThreadBatch())
+        batch->emplace_back(Event::Type::Glue, new_edge, edge1, edge2);
+    else
+        NotifyGlue(new_edge, edge1, edge2);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FireSplit(EdgeId edge, EdgeId new_edge1, EdgeId new_edge2) const {
+    if (auto batch = ThreadBatch())
+        batch->emplace_back(Event::Type::Split, edge, new_edge1, new_edge2);
+    else
+        NotifySplit(edge, new_edge1, new_edge2);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::HiddenRemoveEdge(EdgeId e) {
+    base::HiddenUnlinkEdge(e);
+    ReleaseEdge(e);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::ReleaseEdge(EdgeId e) {
+    if (auto batch = ThreadBatch())
+        batch->emplace_back(Event::Type::DestroyEdge, e);
+    else
+        base::HiddenDestroyEdge(e);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::ReleaseVertex(VertexId v) {
+    if (auto batch = ThreadBatch())
+        batch->emplace_back(Event::Type::DestroyVertex, v);
+    else
+        base::HiddenDestroyVertex(v);
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::DeliverEvents(std::vector<Event> &batch) {
+    if (batch.empty())
+        return;
+
+    std::lock_guard<std::recursive_mutex> guard(handlers_lock_);
+    for (const Event &event : batch) {
+        switch (event.type) {
+            case Event::Type::AddVertex:
+                NotifyAddVertex(event.v);
+                break;
+            case Event::Type::AddEdge:
+                NotifyAddEdge(event.e1);
+                break;
+            case Event::Type::DeleteVertex:
+                NotifyDeleteVertex(event.v);
+                break;
+            case Event::Type::DeleteEdge:
+                NotifyDeleteEdge(event.e1);
+                break;
+            case Event::Type::Merge:
+                NotifyMerge(event.path, event.e1);
+                break;
+            case Event::Type::Glue:
+                NotifyGlue(event.e1, event.e2, event.e3);
+                break;
+            case Event::Type::Split:
+                NotifySplit(event.e1, event.e2, event.e3);
+                break;
+            case Event::Type::DestroyVertex:
+                base::HiddenDestroyVertex(event.v);
+                break;
+            case Event::Type::DestroyEdge:
+                base::HiddenDestroyEdge(event.e1);
+                break;
+        }
+    }
+    batch.clear();
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::StartConcurrentModification(size_t nthreads) {
+    VERIFY(!concurrent_);
+    batches_.clear();
+    batches_.resize(nthreads);
+    concurrent_ = true;
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FinishConcurrentModification() {
+    VERIFY(concurrent_);
+    for (auto &batch : batches_)
+        DeliverEvents(batch);
+    concurrent_ = false;
+    batches_.clear();
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FlushEvents() {
+    if (auto batch = ThreadBatch())
+        DeliverEvents(*batch);
+}
+
 template<class DataMaster>
 bool ObservableGraph<DataMaster>::VerifyAllDetached() {
     for (Handler* handler_ptr : action_handler_list_) {
@@ -455,11 +690,17 @@ typename ObservableGraph<DataMaster>::EdgeId
     //      cerr << "Merging " << PrintDetailedPath(pObservableGraph<DataMaster><VertexIdT, EdgeIdT, VertexIt>ath) << endl;
     //      cerr << "Conjugate " << PrintConjugatePath(path) << endl;
     auto corrected_path = CorrectMergePath(path);
-    VertexId v1 = base::EdgeStart(corrected_path[0]);
-    VertexId v2 = base::EdgeEnd(corrected_path[corrected_path.size() - 1]);
+    return ReplacePath(corrected_path, MergedData(corrected_path, safe_merging, std::move(overlaps)));
+}
+
+template<class DataMaster>
+typename ObservableGraph<DataMaster>::EdgeData
+        ObservableGraph<DataMaster>::MergedData(const std::vector<EdgeId> &path,
+                                                bool safe_merging,
+                                                std::vector<uint32_t> overlaps) const {
     std::vector<const EdgeData *> to_merge;
     bool empty_overlaps = overlaps.empty();
-    for (auto it1 = corrected_path.begin(), it2 = std::next(it1); it2 != corrected_path.end(); ++it1, ++it2) {
+    for (auto it1 = path.begin(), it2 = std::next(it1); it2 != path.end(); ++it1, ++it2) {
         if (empty_overlaps) {
             VertexId end = base::EdgeEnd(*it1);
             VERIFY(end == base::EdgeStart(*it2));
@@ -468,14 +709,25 @@ typename ObservableGraph<DataMaster>::EdgeId
         }
         to_merge.push_back(&(base::data(*it1)));
     }
-    to_merge.push_back(&(base::data(corrected_path.back())));
-    EdgeId new_edge = base::HiddenAddEdge(v1, v2, base::master().MergeData(to_merge, overlaps, safe_merging));
-    FireMerge(corrected_path, new_edge);
-    auto edges_to_delete = EdgesToDelete(corrected_path);
-    auto vertices_to_delete = VerticesToDelete(corrected_path);
+    to_merge.push_back(&(base::data(path.back())));
+    return base::master().MergeData(to_merge, overlaps, safe_merging);
+}
+
+template<class DataMaster>
+typename ObservableGraph<DataMaster>::EdgeId
+        ObservableGraph<DataMaster>::ReplacePath(const std::vector<EdgeId> &path, EdgeData data) {
+    VertexId v1 = base::EdgeStart(path[0]);
+    VertexId v2 = base::EdgeEnd(path[path.size() - 1]);
+    EdgeId new_edge = base::HiddenAddEdge(v1, v2, std::move(data));
+    FireMerge(path, new_edge);
+    auto edges_to_delete = EdgesToDelete(path);
+    auto vertices_to_delete = VerticesToDelete(path);
     FireDeletePath(edges_to_delete, vertices_to_delete);
     FireAddEdge(new_edge);
-    base::HiddenDeletePath(edges_to_delete, vertices_to_delete);
+    for (EdgeId e : edges_to_delete)
+        HiddenRemoveEdge(e);
+    for (VertexId v : vertices_to_delete)
+        ReleaseVertex(v);
     return new_edge;
 }
 
@@ -497,7 +749,7 @@ std::pair<typename ObservableGraph<DataMaster>::EdgeId, typename ObservableGraph
     FireAddVertex(splitVertex);
     FireAddEdge(new_edge1);
     FireAddEdge(new_edge2);
-    base::HiddenDeleteEdge(edge);
+    HiddenRemoveEdge(edge);
     return {new_edge1, new_edge2};
 }
 
@@ -510,8 +762,8 @@ typename ObservableGraph<DataMaster>::EdgeId ObservableGraph<DataMaster>::GlueEd
     FireAddEdge(new_edge);
     VertexId start = base::EdgeStart(edge1);
     VertexId end = base::EdgeEnd(edge1);
-    base::HiddenDeleteEdge(edge1);
-    base::HiddenDeleteEdge(edge2);
+    HiddenRemoveEdge(edge1);
+    HiddenRemoveEdge(edge2);
 
     if (base::IsDeadStart(start) && base::IsDeadEnd(start))
         DeleteVertex(start);
@@ -0,0 +1,49 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <folly/synchronization/PicoSpinLock.h>
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace omnigraph {
+
+/**
+ * Striped spin locks guarding the vertices during concurrent graph
+ * modification. The stripe is chosen by the id of the canonical vertex of the
+ * conjugate pair, so a vertex and its conjugate (i.e. both outgoing and
+ * incoming edges of the vertex) are guarded by the same lock.
+ * Several stripes should be always taken in increasing order (see
+ * VertexTransaction), otherwise deadlocks are possible.
+ */
+class VertexLockTable {
+  public:
+    static constexpr unsigned STRIPE_BITS = 16;
+
+    VertexLockTable()
+            : locks_(size_t(1) << STRIPE_BITS) {
+        for (auto &lock : locks_)
+            lock.init(0);
+    }
+
+    // Fibonacci hashing: conjugate vertices usually get consecutive ids, so
+    // canonical ids are not spread evenly over the low bits
+    static size_t stripe(uint64_t canonical_id) noexcept {
+        return size_t((canonical_id * 0x9E3779B97F4A7C15ULL) >> (64 - STRIPE_BITS));
+    }
+
+    void lock(size_t stripe) const { locks_[stripe].lock(); }
+    bool try_lock(size_t stripe) const { return locks_[stripe].try_lock(); }
+    void unlock(size_t stripe) const { locks_[stripe].unlock(); }
+
+  private:
+    mutable std::vector<folly::PicoSpinLock<uint16_t>> locks_;
+};
+
+}
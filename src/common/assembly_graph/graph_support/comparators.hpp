@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <functional>
 
 namespace omnigraph {
@@ -29,6 +30,13 @@ public:
         return double(g.kmer_multiplicity(edge)) / double(g.length(edge));
     }
 
+    /**
+     * Coverage bucket (1/8 coverage resolution) for the bucket queues.
+     */
+    static size_t bucket(double coverage) {
+        return size_t(std::min(coverage * 8, 1e9));
+    }
+
     bool operator()(EdgeId edge1, EdgeId edge2) const {
         const Graph &g = graph_;
 
@@ -61,6 +69,13 @@ struct LengthComparator {
         return g.length(edge);
     }
 
+    /**
+     * Length bucket for the bucket queues.
+     */
+    static size_t bucket(size_t length) {
+        return length;
+    }
+
     bool operator()(EdgeId edge1, EdgeId edge2) const {
         const Graph &g = graph_;
 
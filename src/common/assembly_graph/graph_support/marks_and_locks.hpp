@@ -8,8 +8,57 @@
 #pragma once
 #include "assembly_graph/core/order_and_law.hpp"
 
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
 namespace omnigraph {
 
+/**
+ * Locks the given vertices (along with their conjugates) for the concurrent
+ * graph modification. The vertex locks are always taken in the same order,
+ * so the transactions do not deadlock each other; they should not be nested
+ * though. During concurrent modification (see
+ * ObservableGraph::StartConcurrentModification) the events collected by the
+ * thread are delivered before the locks are released, so the handlers observe
+ * the modifications of the same vertices in the order they happened. If the
+ * order does not matter (e.g. the transactions never touch the same
+ * elements), the events could be left for FinishConcurrentModification.
+ */
+template<class Graph>
+class VertexTransaction {
+    typedef typename Graph::VertexId VertexId;
+
+    Graph &g_;
+    std::vector<size_t> stripes_;
+    bool flush_events_;
+
+public:
+    template<class It>
+    VertexTransaction(Graph &g, It begin, It end, bool flush_events = true)
+            : g_(g), flush_events_(flush_events) {
+        for (; begin != end; ++begin)
+            stripes_.push_back(g_.vertex_lock_stripe(*begin));
+        std::sort(stripes_.begin(), stripes_.end());
+        stripes_.erase(std::unique(stripes_.begin(), stripes_.end()), stripes_.end());
+        for (size_t stripe : stripes_)
+            g_.vertex_locks().lock(stripe);
+    }
+
+    VertexTransaction(Graph &g, std::initializer_list<VertexId> vertices, bool flush_events = true)
+            : VertexTransaction(g, vertices.begin(), vertices.end(), flush_events) {}
+
+    VertexTransaction(const VertexTransaction &) = delete;
+    VertexTransaction &operator=(const VertexTransaction &) = delete;
+
+    ~VertexTransaction() {
+        if (flush_events_)
+            g_.FlushEvents();
+        for (auto it = stripes_.rbegin(); it != stripes_.rend(); ++it)
+            g_.vertex_locks().unlock(*it);
+    }
+};
+
 template<class T>
 class PairedElementManipulationHelper {
 public:
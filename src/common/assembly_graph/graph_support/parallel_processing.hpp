@@ -333,6 +333,11 @@ protected:
         it_.push(el);
     }
 
+    // Elements to be processed next (see SmartIterator::Upcoming)
+    std::vector<ElementId> UpcomingElements(size_t cnt) const {
+        return it_.Upcoming(cnt);
+    }
+
     virtual bool Process(ElementId el) = 0;
     virtual bool Proceed(ElementId /*el*/) const { return true; }
     virtual void PrepareIteration(double /*iter_run_progress*/ = 1.) {}
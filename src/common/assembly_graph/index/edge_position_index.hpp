@@ -11,6 +11,7 @@
 #include "sequence/rtseq.hpp"
 #include "kmer_index/ph_map/perfect_hash_map.hpp"
 #include "kmer_index/ph_map/kmer_maps.hpp"
+#include "adt/mapped_vector.hpp"
 
 #include <folly/synchronization/PicoSpinLock.h>
 
@@ -105,9 +106,11 @@ struct GraphInverter {
 template<class Graph, class IdHolder = typename Graph::EdgeId, class StoringType = kmers::DefaultStoring>
 class KmerFreeEdgeIndex : public kmers::PerfectHashMap<RtSeq,
                                                        EdgeInfo<typename Graph::EdgeId, IdHolder>,
-                                                       kmers::kmer_index_traits<RtSeq>, StoringType> {
+                                                       kmers::kmer_index_traits<RtSeq>, StoringType,
+                                                       adt::mapped_vector<EdgeInfo<typename Graph::EdgeId, IdHolder>>> {
   typedef kmers::PerfectHashMap<RtSeq, EdgeInfo<typename Graph::EdgeId, IdHolder>,
-                                kmers::kmer_index_traits<RtSeq>, StoringType> base;
+                                kmers::kmer_index_traits<RtSeq>, StoringType,
+                                adt::mapped_vector<EdgeInfo<typename Graph::EdgeId, IdHolder>>> base;
   const Graph &graph_;
 
 public:
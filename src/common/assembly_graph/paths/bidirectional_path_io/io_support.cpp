@@ -70,10 +70,9 @@ void path_extend::TranscriptToGeneJoiner::Construct(const PathContainer &paths)
 
     DEBUG("Union trees");
     //  For all edges in coverage map
-    for (const auto &entry : edges_coverage) {
+    for (EdgeId edge : g_.edges()) {
         // Select a path covering an edge
-        EdgeId edge = entry.first;
-        auto &edge_paths = entry.second;
+        auto &edge_paths = edges_coverage.GetEdgePaths(edge);
 
         if (g_.length(edge) <= min_edge_len_ || edge_paths.size() <= 1)
             continue;
@@ -81,8 +80,8 @@ void path_extend::TranscriptToGeneJoiner::Construct(const PathContainer &paths)
         DEBUG("Long edge " << edge.int_id() << " Paths " << edge_paths.size());
         // For all other paths covering this edge join then into single gene with the first path
         for (auto it_edge = std::next(edge_paths.begin()); it_edge != edge_paths.end(); ++it_edge) {
-            size_t first = path_id_[edge_paths.begin()->first->GetId()];
-            size_t next = path_id_[it_edge->first->GetId()];
+            size_t first = path_id_[edge_paths.begin()->path->GetId()];
+            size_t next = path_id_[it_edge->path->GetId()];
             DEBUG("Edge " << edge.int_id() << " First " << first << " Next " << next);
 
             JoinTrees(first, next);
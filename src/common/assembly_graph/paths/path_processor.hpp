@@ -219,6 +219,12 @@ public:
         return error_code;
     }
 
+    // Vertices reached by the Dijkstra, the found paths depend only on the
+    // edges adjacent to them
+    auto reached() const {
+        return dijkstra_.reached();
+    }
+
     static const size_t MAX_CALL_CNT = 3000;
     static const size_t MAX_DIJKSTRA_VERTICES = 3000;
     static const size_t VERTEX_USAGE_ENABLE_THRESHOLD = 500;
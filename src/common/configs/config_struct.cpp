@@ -223,6 +223,8 @@ void load(debruijn_config::construction& con,
     load(con.keep_perfect_loops, pt, "keep_perfect_loops", complete);
     load(con.read_buffer_size, pt, "read_buffer_size", complete);
     load(con.read_cov_threshold, pt, "read_cov_threshold", complete);
+    load(con.in_memory_counting, pt, "in_memory_counting", complete);
+    load(con.compress_raw_kmers, pt, "compress_raw_kmers", complete);
 
     con.read_buffer_size *= 1024 * 1024;
     load(con.early_tc, pt, "early_tip_clipper", complete);
@@ -262,6 +264,7 @@ void load(debruijn_config::simplification::bulge_remover& br,
   load(br.buff_cov_diff,                    pt,     "buff_cov_diff", complete);
   load(br.buff_cov_rel_diff,                pt,     "buff_cov_rel_diff", complete);
   load(br.min_identity,                     pt,     "min_identity", false);
+  load(br.speculation_batch,                pt,     "speculation_batch", complete);
 }
 
 void load(debruijn_config::simplification::complex_tip_clipper &ctc,
@@ -412,6 +415,8 @@ void load(distance_estimator& de,
   load(de.max_distance_coeff_scaff, pt, "max_distance_coeff_scaff", complete);
   load(de.clustered_filter_threshold, pt, "clustered_filter_threshold", complete);
   load(de.raw_filter_threshold, pt, "raw_filter_threshold", complete);
+  load(de.raw_filter_single_pass, pt, "raw_filter_single_pass", complete);
+  load(de.sharded_paired_buffer, pt, "sharded_paired_buffer", complete);
   load(de.rounding_coeff, pt, "rounding_coeff", complete);
   load(de.rounding_thr, pt, "rounding_threshold", complete);
 }
@@ -184,6 +184,7 @@ struct debruijn_config {
             double buff_cov_diff;
             double buff_cov_rel_diff;
             double min_identity;
+            size_t speculation_batch;
         };
 
         struct erroneous_connections_remover {
@@ -316,10 +317,14 @@ struct debruijn_config {
         bool keep_perfect_loops;
         unsigned read_cov_threshold;
         size_t read_buffer_size;
+        bool in_memory_counting;
+        bool compress_raw_kmers;
         construction() :
                 keep_perfect_loops(true),
                 read_cov_threshold(0),
-                read_buffer_size(0) {}
+                read_buffer_size(0),
+                in_memory_counting(false),
+                compress_raw_kmers(false) {}
     };
 
     simplification simp;
@@ -17,6 +17,8 @@ struct distance_estimator {
     double max_distance_coeff_scaff    = 2000.0;
     double clustered_filter_threshold  = 2;
     unsigned raw_filter_threshold      = 2;
+    bool raw_filter_single_pass        = true; // count edge pairs while filling the index instead of a separate pass
+    bool sharded_paired_buffer         = false; // collect points into per-thread shards instead of the concurrent map
     double rounding_thr                = 0.5; // ; rounding : min(de_max_distance * rounding_coeff, rounding_thr)
     double rounding_coeff              = 0;
 };
@@ -251,6 +251,7 @@ void load(pe_config::MainPEParamsT& p, boost::property_tree::ptree const& pt,
           bool complete) {
     using config_common::load;
     load(p.debug_output, pt, "debug_output", complete);
+    load(p.extension_threads, pt, "extension_threads", complete);
     load(p.output, pt, "output", complete);
     load(p.viz, pt, "visualize", complete);
     load(p.param_set, pt, "params", complete);
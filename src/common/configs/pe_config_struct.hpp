@@ -204,6 +204,8 @@ struct pe_config {
 
     struct MainPEParamsT {
         bool debug_output;
+        // Threads extending the seeds, 0 for all the available threads
+        size_t extension_threads;
         std::filesystem::path etc_dir;
 
         OutputParamsT output;
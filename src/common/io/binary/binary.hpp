@@ -10,6 +10,7 @@
 #include "utils/verify.hpp"
 #include "io/binary/access.hpp"
 #include "io/binary/binary_fwd.hpp"
+#include "adt/mapped_vector.hpp"
 
 #include <iostream>
 #include <vector>
@@ -432,6 +433,28 @@ public:
     }
 };
 
+// adt::mapped_vector, same encoding as std::vector
+template <typename T>
+class Serializer<adt::mapped_vector<T>, std::enable_if_t<is_serializable<T>>> {
+public:
+    static void Write(std::ostream &os, const adt::mapped_vector<T> &v) {
+        BinWrite(os, v.size());
+        for (size_t i = 0; i < v.size(); ++i) {
+            BinWrite(os, v[i]);
+        }
+    }
+
+    static void Read(std::istream &is, adt::mapped_vector<T> &v) {
+        size_t size;
+        BinRead(is, size);
+        v.clear();
+        v.resize(size);
+        for (size_t i = 0; i < size; ++i) {
+            BinRead(is, v[i]);
+        }
+    }
+};
+
 // std::tuple
 namespace detail {
 template <class F, class Tuple, std::size_t... I>
@@ -10,19 +10,71 @@
 #include "io_base.hpp"
 
 #include "alignment/edge_index.hpp"
+#include "io/kmers/mmapped_file.hpp"
+
+#include <cstring>
+#include <memory>
 
 namespace io {
 
 namespace binary {
 
+/**
+ * @brief  Edge index files are saved in the layout which is memory mapped and used
+ *         in place on load (see EdgeIndex::BinMap), so the index is not deserialized
+ *         and the pages are shared between the processes loading the same saves.
+ *         Files of the stream format (without the header) are loaded as before.
+ *         Streaming (BinWrite / BinRead) always uses the stream format.
+ */
 template<typename Graph>
 class EdgeIndexIO : public IOSingle<debruijn_graph::EdgeIndex<Graph>> {
+    static constexpr char MAGIC[8] = { 'S', 'P', 'A', 'K', 'M', 'I', 'D', 'X' };
+    static constexpr uint64_t VERSION = 1;
+
 public:
     typedef debruijn_graph::EdgeIndex<Graph> Type;
     EdgeIndexIO()
             : IOSingle<Type>("edge index", ".kmidx") {
     }
 
+    void Save(const std::string &basename, const Type &value) override {
+        std::filesystem::path filename = basename + ".kmidx";
+        std::ofstream file(filename, std::ios::binary);
+        DEBUG("Saving edge index into " << filename);
+        VERIFY(file);
+        file.write(MAGIC, sizeof(MAGIC));
+        mmapped::write(file, VERSION);
+        mmapped::write(file, uint64_t(value.k()));
+        value.BinWriteMapped(file);
+        CHECK_FATAL_ERROR(file, "Failed to write " << filename);
+    }
+
+    bool Load(const std::string &basename, Type &value) override {
+        std::filesystem::path filename = basename + ".kmidx";
+        auto mapping = std::make_shared<MMappedFile>(filename);
+        if (mapping->size() == 0)
+            return false;
+
+        const uint8_t *data = mapping->data();
+        if (mapping->size() < sizeof(MAGIC) || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+            // Stream format
+            mapping.reset();
+            return IOSingle<Type>::Load(basename, value);
+        }
+
+        DEBUG("Mapping edge index from " << filename);
+        CHECK_FATAL_ERROR(mapping->size() >= sizeof(MAGIC) + 2 * sizeof(uint64_t),
+                          "Truncated edge index " << filename);
+        data += sizeof(MAGIC);
+        uint64_t version = mmapped::read<uint64_t>(data);
+        CHECK_FATAL_ERROR(version == VERSION, "Unsupported edge index version " << version << " in " << filename);
+        uint64_t k = mmapped::read<uint64_t>(data);
+        CHECK_FATAL_ERROR(k == value.k(), "Cannot read edge index, different Ks");
+        value.clear();
+        value.BinMap(data, mapping->data() + mapping->size(), mapping);
+        return true;
+    }
+
     void SaveImpl(BinOStream &str, const Type &value) override {
         str << (uint32_t)value.k() << value;
     }
@@ -0,0 +1,112 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+#include "utils/logger/logger.hpp"
+
+#include <filesystem>
+#include <ostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Whole file mapped copy-on-write. Pages are backed by the page cache and
+// shared with all the processes mapping the same file until they are
+// modified, modifications are never written back to the file.
+class MMappedFile {
+  public:
+    explicit MMappedFile(const std::filesystem::path &filename)
+            : filename_(filename) {
+        int fd = open(filename_.c_str(), O_RDONLY);
+        if (fd == -1)
+            FATAL_ERROR("open(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno << ". File: " << filename_);
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+            FATAL_ERROR("fstat(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno << ". File: " << filename_);
+        size_ = size_t(st.st_size);
+
+        if (size_) {
+            void *region = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (region == MAP_FAILED)
+                FATAL_ERROR("mmap(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno << ". File: " << filename_);
+            data_ = static_cast<uint8_t*>(region);
+        }
+        close(fd);
+    }
+
+    MMappedFile(const MMappedFile&) = delete;
+    MMappedFile &operator=(const MMappedFile&) = delete;
+
+    ~MMappedFile() {
+        if (data_)
+            munmap(data_, size_);
+    }
+
+    uint8_t *data() { return data_; }
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+    const std::filesystem::path &filename() const { return filename_; }
+
+  private:
+    std::filesystem::path filename_;
+    uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Helpers for the layouts used in place from MMappedFile. Layouts are written
+// from the beginning of the file and all the arrays are aligned to 8 bytes.
+namespace mmapped {
+
+constexpr size_t ALIGNMENT = 8;
+
+inline void align(std::ostream &os) {
+    static const char zeros[ALIGNMENT] = {};
+    size_t pos = size_t(os.tellp());
+    if (size_t rem = pos % ALIGNMENT)
+        os.write(zeros, ALIGNMENT - rem);
+}
+
+inline void align(const uint8_t *&data) {
+    if (size_t rem = reinterpret_cast<uintptr_t>(data) % ALIGNMENT)
+        data += ALIGNMENT - rem;
+}
+
+template<class T>
+void write(std::ostream &os, const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values could be mapped");
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<class T>
+T read(const uint8_t *&data) {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values could be mapped");
+    T value;
+    memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return value;
+}
+
+// Checks that count elements of the given size fit between data and the end
+// of the mapping
+inline void check(const uint8_t *data, const uint8_t *end, uint64_t count, size_t size = 1) {
+    CHECK_FATAL_ERROR(data <= end && count <= size_t(end - data) / size, "Truncated mapped data");
+}
+
+template<class T>
+T read(const uint8_t *&data, const uint8_t *end) {
+    check(data, end, sizeof(T));
+    return read<T>(data);
+}
+
+}
@@ -0,0 +1,457 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "read.hpp"
+
+#include "utils/verify.hpp"
+#include "utils/logger/logger.hpp"
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+namespace hammer {
+
+// Single record parsed in place. All the fields point into the arena of the
+// batch and are zero-terminated, quality is empty for FASTA records.
+struct ReadView {
+    std::string_view name;
+    std::string_view seq;
+    std::string_view qual;
+};
+
+// Block of the input together with the records parsed from it. Batches are
+// meant to be reused, so the arena is allocated once per batch.
+class ReadBatch {
+  public:
+    typedef std::vector<ReadView>::const_iterator const_iterator;
+
+    size_t size() const { return reads_.size(); }
+    bool empty() const { return reads_.empty(); }
+
+    const ReadView &operator[](size_t i) const { return reads_[i]; }
+    const_iterator begin() const { return reads_.begin(); }
+    const_iterator end() const { return reads_.end(); }
+
+  private:
+    friend class ReadBatchStream;
+
+    std::vector<char> arena_;
+    std::vector<ReadView> reads_;
+};
+
+// Reads FASTQ / FASTA input by large blocks and parses the records in place.
+// Uncompressed files are split into several chunks which could be read
+// concurrently (one thread per chunk), gzipped input is always read as a
+// single chunk. Records could span several lines, however FASTQ files are
+// split only at single-line records, since the quality lines of the wrapped
+// ones could start with '@' and '+'. FASTQ files starting with a wrapped
+// record are read as a single chunk.
+class ReadBatchStream {
+    static constexpr size_t tail_block_size = 1 << 16;
+    static constexpr size_t sync_block_size = 1 << 20;
+
+    struct Chunk {
+        uint64_t pos = 0;            // offset of the next byte to be read
+        uint64_t end = 0;            // records starting at or after end belong to the next chunk
+        std::vector<char> tail;      // incomplete record left from the previous block
+        bool eof = false;
+    };
+
+  public:
+    ReadBatchStream(const std::filesystem::path &filename, int offset = Read::PHRED_OFFSET,
+                    unsigned nchunks = 1, size_t block_size = 1 << 22)
+            : filename_(filename), offset_(offset), block_size_(block_size) {
+        open(nchunks);
+    }
+
+    ReadBatchStream(const ReadBatchStream&) = delete;
+    ReadBatchStream &operator=(const ReadBatchStream&) = delete;
+
+    ~ReadBatchStream() {
+        close();
+    }
+
+    bool is_open() const { return fd_ >= 0 || gz_; }
+    int offset() const { return offset_; }
+    size_t chunks() const { return chunks_.size(); }
+
+    bool eof(size_t chunk) const { return chunks_[chunk].eof; }
+    bool eof() const {
+        for (const auto &chunk : chunks_)
+            if (!chunk.eof)
+                return false;
+        return true;
+    }
+
+    // Reads the next block of the chunk and parses all the complete records
+    // from it. The previous contents of the batch are discarded. Returns false
+    // if the chunk is exhausted. Different chunks could be read concurrently.
+    bool read(ReadBatch &batch, size_t chunk = 0) {
+        VERIFY(chunk < chunks_.size());
+        Chunk &c = chunks_[chunk];
+        std::vector<char> &buf = batch.arena_;
+
+        batch.reads_.clear();
+        buf.assign(c.tail.begin(), c.tail.end());
+        c.tail.clear();
+        while (!c.eof) {
+            // The block could not contain records of the chunk anymore
+            if (!is_gz() && buf.empty() && c.pos >= c.end) {
+                c.eof = true;
+                break;
+            }
+
+            uint64_t base = c.pos - buf.size();
+            bool exhausted = !fetch(c, buf);
+            if (exhausted && buf.empty()) {
+                c.eof = true;
+                break;
+            }
+
+            // Terminate the last line, so every record is followed by the line break
+            if (exhausted && buf.back() != '\n')
+                buf.push_back('\n');
+
+            size_t consumed = parse(buf, exhausted, base, c.end, batch.reads_);
+            if (exhausted) {
+                CHECK_FATAL_ERROR(consumed == buf.size() || (!is_gz() && base + consumed >= c.end),
+                                  "Truncated record at the end of reads file " << filename_);
+                c.eof = true;
+                break;
+            }
+            if (!is_gz() && base + consumed >= c.end) {
+                c.eof = true;
+                break;
+            }
+
+            if (!batch.reads_.empty()) {
+                c.tail.assign(buf.begin() + consumed, buf.end());
+                break;
+            }
+        }
+
+        return !batch.reads_.empty();
+    }
+
+    void close() {
+        if (gz_) {
+            gzclose(gz_);
+            gz_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+  private:
+    bool is_gz() const { return gz_ != nullptr; }
+
+    void open(unsigned nchunks) {
+        gz_ = gzopen(filename_.c_str(), "r");
+        CHECK_FATAL_ERROR(gz_, "Cannot open reads file " << filename_);
+        if (gzdirect(gz_)) {
+            gzclose(gz_);
+            gz_ = nullptr;
+
+            fd_ = ::open(filename_.c_str(), O_RDONLY);
+            CHECK_FATAL_ERROR(fd_ >= 0, "Cannot open reads file " << filename_ << ". Reason: " << strerror(errno));
+            struct stat st;
+            CHECK_FATAL_ERROR(fstat(fd_, &st) == 0, "Cannot stat reads file " << filename_ << ". Reason: " << strerror(errno));
+            file_size_ = uint64_t(st.st_size);
+        } else
+            file_size_ = uint64_t(-1);
+
+        // Determine the format by the first character of the input
+        Chunk first;
+        first.end = file_size_;
+        bool empty = !fetch(first, first.tail, 1);
+        if (!empty) {
+            CHECK_FATAL_ERROR(first.tail[0] == '@' || first.tail[0] == '>',
+                              "Unsupported format of reads file " << filename_);
+            fastq_ = first.tail[0] == '@';
+        }
+
+        if (is_gz()) {
+            first.eof = empty;
+            chunks_.push_back(std::move(first));
+            return;
+        }
+
+        // Do not split the input into chunks smaller than a block
+        nchunks = unsigned(std::min<uint64_t>(std::max(nchunks, 1u), file_size_ / block_size_ + 1));
+        if (nchunks > 1 && fastq_) {
+            Chunk c;
+            c.end = file_size_;
+            std::vector<char> buf;
+            bool exhausted = !fetch(c, buf, sync_block_size) || c.pos == file_size_;
+            if (single_line_record(buf.data(), buf.data() + buf.size(), exhausted) <= 0) {
+                INFO("Reads file " << filename_ << " contains multi-line FASTQ records, it will be read sequentially");
+                nchunks = 1;
+            }
+        }
+        chunks_.resize(nchunks);
+        for (size_t i = 1; i < nchunks; ++i)
+            chunks_[i].pos = chunks_[i - 1].end = synchronize(file_size_ / nchunks * i);
+        chunks_.back().end = file_size_;
+
+        for (auto &chunk : chunks_)
+            chunk.eof = empty;
+    }
+
+    // Appends the next portion of the data to the buffer, returns false if the
+    // input is exhausted.
+    bool fetch(Chunk &c, std::vector<char> &buf, size_t want = 0) {
+        if (!want)
+            want = (is_gz() || c.pos < c.end) ? block_size_ : tail_block_size;
+        if (!is_gz() && c.pos < c.end)
+            want = std::min<uint64_t>(want, c.end - c.pos);
+
+        size_t size = buf.size();
+        buf.resize(size + want);
+        size_t got = 0;
+        if (is_gz()) {
+            int res = gzread(gz_, buf.data() + size, unsigned(want));
+            CHECK_FATAL_ERROR(res >= 0, "Failed to read reads file " << filename_);
+            got = size_t(res);
+        } else {
+            while (got < want) {
+                ssize_t res = pread(fd_, buf.data() + size + got, want - got, off_t(c.pos + got));
+                CHECK_FATAL_ERROR(res >= 0, "Failed to read reads file " << filename_ << ". Reason: " << strerror(errno));
+                if (res == 0)
+                    break;
+                got += size_t(res);
+            }
+        }
+
+        buf.resize(size + got);
+        c.pos += got;
+        return got > 0;
+    }
+
+    // Returns the offset of the first record starting at or after the given offset
+    uint64_t synchronize(uint64_t offset) {
+        VERIFY(offset > 0);
+
+        // Start from the preceding byte to see whether the record starts exactly at offset
+        Chunk c;
+        c.pos = offset - 1;
+        c.end = file_size_;
+        std::vector<char> buf;
+        bool exhausted = false;
+        size_t i = 1;
+        while (true) {
+            for (; i < buf.size(); ++i) {
+                if (buf[i - 1] != '\n')
+                    continue;
+
+                if (!fastq_) {
+                    if (buf[i] == '>')
+                        return c.pos - buf.size() + i;
+                    continue;
+                }
+
+                if (buf[i] != '@')
+                    continue;
+
+                // Record header is the only line starting with '@' which is
+                // followed by the separator line two lines below. The
+                // following record is checked as well to make sure the split
+                // does not happen inside the wrapped quality lines.
+                int res = single_line_record(buf.data() + i, buf.data() + buf.size(), exhausted);
+                if (res < 0)
+                    break;
+
+                if (res > 0)
+                    return c.pos - buf.size() + i;
+            }
+
+            if (exhausted)
+                return file_size_;
+
+            exhausted = !fetch(c, buf, sync_block_size);
+        }
+    }
+
+    static const char *next_line(const char *p, const char *end) {
+        const char *nl = (const char*)memchr(p, '\n', end - p);
+        return nl ? nl + 1 : nullptr;
+    }
+
+    // Length of the line [begin, next) without the line break
+    static size_t line_length(const char *begin, const char *next) {
+        size_t len = (next - 1) - begin;
+        if (len && begin[len - 1] == '\r')
+            len -= 1;
+        return len;
+    }
+
+    // Checks whether a single-line FASTQ record starts at p and is followed by
+    // the start of another record. If the input is exhausted, the second
+    // record is not required. Returns -1 if more data is needed
+    static int single_line_record(const char *p, const char *end, bool exhausted, unsigned records = 2) {
+        for (; records && !(exhausted && p == end); --records) {
+            const char *seq = next_line(p, end);
+            const char *sep = seq ? next_line(seq, end) : nullptr;
+            const char *qual = sep ? next_line(sep, end) : nullptr;
+            const char *next = qual ? next_line(qual, end) : nullptr;
+            if (!next)
+                return exhausted ? 0 : -1;
+
+            if (*p != '@' || *sep != '+' || line_length(seq, sep) != line_length(qual, next))
+                return 0;
+            p = next;
+        }
+
+        if (p == end)
+            return exhausted ? 1 : -1;
+        return *p == '@';
+    }
+
+    // Joins the lines [begin, end) in place and zero-terminates the result
+    static std::string_view join_lines(char *begin, char *end) {
+        char *out = begin;
+        for (char *line = begin; line != end; ) {
+            char *nl = const_cast<char*>(next_line(line, end));
+            size_t len = line_length(line, nl);
+            memmove(out, line, len);
+            out += len;
+            line = nl;
+        }
+        if (out == end)
+            return std::string_view("");
+
+        *out = '\0';
+        return std::string_view(begin, out - begin);
+    }
+
+    // Cuts [begin, end) line dropping trailing '\r' and zero-terminates it
+    static std::string_view terminate(char *begin, char *end) {
+        if (end != begin && end[-1] == '\r')
+            end -= 1;
+        *end = '\0';
+        return std::string_view(begin, end - begin);
+    }
+
+    // Same, but the read name ends at the first whitespace
+    static std::string_view terminate_name(char *begin, char *end) {
+        char *p = begin;
+        while (p != end && *p != ' ' && *p != '\t' && *p != '\r')
+            ++p;
+        *p = '\0';
+        return std::string_view(begin, p - begin);
+    }
+
+    // Parses complete records from the buffer, returns the number of bytes consumed
+    size_t parse(std::vector<char> &buf, bool exhausted,
+                 uint64_t base, uint64_t end, std::vector<ReadView> &reads) {
+        char *data = buf.data(), *last = data + buf.size();
+        char *p = data;
+        while (p != last) {
+            if (!is_gz() && base + uint64_t(p - data) >= end)
+                break;
+
+            char *next = fastq_ ? parse_fastq(p, last, reads) : parse_fasta(p, last, exhausted, reads);
+            if (!next)
+                break;
+            p = next;
+        }
+
+        return p - data;
+    }
+
+    char *parse_fastq(char *p, char *last, std::vector<ReadView> &reads) const {
+        CHECK_FATAL_ERROR(*p == '@', "Malformed FASTQ record in reads file " << filename_);
+        char *seq = const_cast<char*>(next_line(p, last));
+        if (!seq)
+            return nullptr;
+
+        // Sequence lines up to the separator
+        char *sep = seq;
+        size_t seq_len = 0;
+        while (true) {
+            if (sep == last)
+                return nullptr;
+            if (*sep == '+')
+                break;
+            CHECK_FATAL_ERROR(*sep != '@', "Malformed FASTQ record in reads file " << filename_);
+            char *nl = const_cast<char*>(next_line(sep, last));
+            if (!nl)
+                return nullptr;
+            seq_len += line_length(sep, nl);
+            sep = nl;
+        }
+
+        // Quality lines up to the sequence length, at least one
+        char *qual = const_cast<char*>(next_line(sep, last));
+        if (!qual)
+            return nullptr;
+        char *next = qual;
+        size_t qual_len = 0;
+        do {
+            char *nl = next == last ? nullptr : const_cast<char*>(next_line(next, last));
+            if (!nl)
+                return nullptr;
+            qual_len += line_length(next, nl);
+            next = nl;
+        } while (qual_len < seq_len);
+
+        ReadView &read = reads.emplace_back();
+        read.name = terminate_name(p + 1, seq - 1);
+        read.seq = join_lines(seq, sep);
+        read.qual = join_lines(qual, next);
+        CHECK_FATAL_ERROR(read.seq.size() == read.qual.size(),
+                          "Sequence and quality lengths differ for read " << read.name << " in reads file " << filename_);
+
+        return next;
+    }
+
+    char *parse_fasta(char *p, char *last, bool exhausted, std::vector<ReadView> &reads) const {
+        CHECK_FATAL_ERROR(*p == '>', "Malformed FASTA record in reads file " << filename_);
+        char *seq = const_cast<char*>(next_line(p, last));
+        if (!seq)
+            return nullptr;
+
+        // Find the start of the next record
+        char *next = seq;
+        while (next != last && *next != '>') {
+            next = const_cast<char*>(next_line(next, last));
+            if (!next)
+                return nullptr;
+        }
+        if (next == last && !exhausted)
+            return nullptr;
+
+        ReadView &read = reads.emplace_back();
+        read.name = terminate_name(p + 1, seq - 1);
+        read.seq = join_lines(seq, next);
+        read.qual = std::string_view("");
+
+        return next;
+    }
+
+    std::filesystem::path filename_;
+    int offset_;
+    size_t block_size_;
+    bool fastq_ = true;
+
+    gzFile gz_ = nullptr;
+    int fd_ = -1;
+    uint64_t file_size_ = 0;
+    std::vector<Chunk> chunks_;
+};
+
+}
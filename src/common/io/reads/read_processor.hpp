@@ -10,6 +10,7 @@
 #define __HAMMER_READ_PROCESSOR_HPP__
 
 #include "io/reads/mpmc_bounded.hpp"
+#include "io/reads/read_batch_stream.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 
 #include <memory>
@@ -66,6 +67,55 @@ private:
         }
     }
 
+    // Stops at the first read the operation asked to stop at, processed is
+    // set to the number of the reads passed to the operation
+    template<class Op>
+    bool ProcessBatch(const ReadBatch &batch, Read &r, int offset, Op &op, size_t &processed) {
+        processed = 0;
+        for (const ReadView &view : batch) {
+            r.setName(view.name.data());
+            r.setQuality(view.qual.data(), offset);
+            r.setSequence(view.seq.data());
+            processed += 1;
+            if (op(r))
+                return true;
+        }
+
+        return false;
+    }
+
+    template<class Op>
+    bool RunChunks(ReadBatchStream &irs, Op &op) {
+        bool stop = false;
+#   pragma omp parallel for shared(irs, op, stop) num_threads(nthreads_) schedule(dynamic)
+        for (size_t chunk = 0; chunk < irs.chunks(); ++chunk) {
+            ReadBatch batch;
+            Read r;
+            while (1) {
+                bool done;
+#       pragma omp atomic read
+                done = stop;
+                if (done || !irs.read(batch, chunk))
+                    break;
+
+#       pragma omp atomic
+                read_ += batch.size();
+
+                size_t processed;
+                bool res = ProcessBatch(batch, r, irs.offset(), op, processed);
+#       pragma omp atomic
+                processed_ += processed;
+
+                if (res) {
+#         pragma omp atomic
+                    stop |= res;
+                }
+            }
+        }
+
+        return stop;
+    }
+
 public:
     ReadProcessor(unsigned nthreads)
             : nthreads_(nthreads), read_(0), processed_(0) { }
@@ -131,6 +181,92 @@ public:
             }
         }
 
+#   pragma omp flush(stop)
+        return stop;
+    }
+
+    // Batched variant: blocks of the input are parsed in place and handed out
+    // to the workers as a whole. The operation is called for every read as
+    // op(Read &r), the read object is reused by the worker thread.
+    template<class Op>
+    bool Run(ReadBatchStream &irs, Op &op) {
+        using BatchPtr = std::unique_ptr<ReadBatch>;
+
+        // Uncompressed input is read by all the threads at once
+        if (irs.chunks() > 1 || nthreads_ < 2)
+            return RunChunks(irs, op);
+
+        // Round nthreads to next power of two
+        unsigned bufsize = nthreads_ - 1;
+        bufsize = (bufsize >> 1) | bufsize;
+        bufsize = (bufsize >> 2) | bufsize;
+        bufsize = (bufsize >> 4) | bufsize;
+        bufsize = (bufsize >> 8) | bufsize;
+        bufsize = (bufsize >> 16) | bufsize;
+        bufsize += 1;
+
+        // Processed batches are returned back to the reader to reuse the arenas
+        mpmc_bounded_queue<BatchPtr> in_queue(2 * bufsize), free_queue(2 * bufsize);
+        size_t allocated = 0;
+
+        bool stop = false;
+#   pragma omp parallel shared(in_queue, free_queue, irs, op, stop) num_threads(nthreads_)
+        {
+#     pragma omp master
+            {
+                while (!irs.eof()) {
+                    BatchPtr batch;
+                    if (!free_queue.dequeue(batch)) {
+                        if (allocated == 2 * bufsize) {
+                            sched_yield();
+                            continue;
+                        }
+
+                        batch.reset(new ReadBatch);
+                        allocated += 1;
+                    }
+
+                    if (!irs.read(*batch))
+                        break;
+#         pragma omp atomic
+                    read_ += batch->size();
+
+                    while (!in_queue.enqueue(std::move(batch)))
+                        sched_yield();
+
+#         pragma omp flush (stop)
+                    if (stop)
+                        break;
+                }
+
+                in_queue.close();
+            }
+
+            Read r;
+            while (1) {
+                BatchPtr batch;
+
+                if (!in_queue.wait_dequeue(batch))
+                    break;
+
+                // The rest of the batches are dropped once stopped
+                bool done;
+#       pragma omp atomic read
+                done = stop;
+                size_t processed = 0;
+                bool res = !done && ProcessBatch(*batch, r, irs.offset(), op, processed);
+#       pragma omp atomic
+                processed_ += processed;
+
+                if (res) {
+#         pragma omp atomic
+                    stop |= res;
+                }
+
+                free_queue.enqueue(std::move(batch));
+            }
+        }
+
 #   pragma omp flush(stop)
         return stop;
     }
@@ -64,15 +64,22 @@ public:
     kmers::KMerDiskStorage<RtSeq>
     BuildExtensionIndexFromStream(fs::TmpDir workdir, Index &index,
                                   Streams &streams,
-                                  size_t read_buffer_size = 0) const {
+                                  size_t read_buffer_size = 0,
+                                  bool in_memory = false,
+                                  RawKMerCodec codec = RawKMerCodec::Plain) const {
         unsigned nthreads = (unsigned) streams.size();
         using KmerFilter = StoringTypeFilter<typename Index::storing_type>;
 
         // First, build a k+1-mer index
         using Splitter = DeBruijnReadKMerSplitter<typename Streams::ReadT, KmerFilter>;
-        kmers::KMerDiskCounter<RtSeq> counter(workdir,
-                                              Splitter(workdir, index.k() + 1, streams, read_buffer_size));
-        auto kmers = counter.Count(10 * nthreads, nthreads);
+        Splitter splitter(workdir, index.k() + 1, streams, read_buffer_size);
+        splitter.set_raw_kmer_codec(codec);
+        std::unique_ptr<kmers::KMerCounter<RtSeq>> counter;
+        if (in_memory)
+            counter.reset(new kmers::KMerMemoryCounter<RtSeq>(workdir, std::move(splitter)));
+        else
+            counter.reset(new kmers::KMerDiskCounter<RtSeq>(workdir, std::move(splitter)));
+        auto kmers = counter->Count(10 * nthreads, nthreads);
 
         BuildExtensionIndexFromKPOMers(workdir, index, kmers,
                                        nthreads, read_buffer_size);
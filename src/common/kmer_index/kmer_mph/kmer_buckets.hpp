@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "kmer_segment_hash.hpp"
+
 #include "adt/lemiere_mod_reduce.hpp"
 #include <iosfwd>
 #include <cstdlib>
@@ -39,7 +41,7 @@ protected:
 
 template<class Seq>
 class KMerSegmentPolicy : public KMerSegmentPolicyBase {
-    typedef typename Seq::hash hash;
+    typedef KMerSegmentHash<Seq> hash;
 
   public:
     using KMerSegmentPolicyBase::KMerSegmentPolicyBase;
@@ -56,7 +58,16 @@ class KMerSegmentPolicy : public KMerSegmentPolicyBase {
         if (this->num_segments_ == 1)
             return 0;
 
-        return reduce(hash()(s.data(), s.size()));
+        return reduce(hash()(s));
+    }
+
+    // Segment of the k-mer given its precomputed segment hash (e.g. obtained
+    // from RollingKMerHash)
+    size_t segment(uint64_t segment_hash) const {
+        if (this->num_segments_ == 1)
+            return 0;
+
+        return reduce(segment_hash);
     }
 };
 
@@ -8,10 +8,12 @@
 //***************************************************************************
 
 #include "kmer_buckets.hpp"
+#include "io/kmers/mmapped_file.hpp"
 
 #include <boomphf/BooPHF.h>
 
 #include <vector>
+#include <memory>
 #include <cmath>
 
 #define XXH_INLINE_ALL
@@ -32,6 +34,9 @@ public:
   typedef typename traits::KMerRawReference KMerRawReference;
   typedef size_t IdxType;
 
+  // Segment and MPH hash of the k-mer, see seq_hash()
+  typedef std::pair<size_t, boomphf::hash_pair_t> KMerHash;
+
 private:
   struct hash_function128 {
     std::pair<uint64_t, uint64_t> operator()(const KMerSeq &k) const {
@@ -62,6 +67,7 @@ public:
     num_segments_ = 0;
     segment_starts_.clear();
     index_.clear();
+    mapping_.reset();
   }
 
   size_t mem_size() {
@@ -89,6 +95,32 @@ public:
     return (idx == -1ULL ? idx : segment_starts_[bucket] + idx);
   }
 
+  // Same as seq_idx(s), but the segment is given by the precomputed segment
+  // hash of the k-mer, see kmer::RollingKMerHash
+  size_t seq_idx(const KMerSeq &s, uint64_t segment_hash) const {
+    size_t bucket = segment_policy_.segment(segment_hash);
+    size_t idx = index_[bucket].lookup(s);
+
+    return (idx == -1ULL ? idx : segment_starts_[bucket] + idx);
+  }
+
+  // Split version of seq_idx() for batched lookups: hash a group of k-mers
+  // first, then resolve them, so the memory accesses for different k-mers
+  // overlap. The hash is prefetched into the cache as well.
+  KMerHash seq_hash(const KMerSeq &s) const {
+    size_t bucket = seq_bucket(s);
+    KMerHash res(bucket, index_[bucket].hash(s));
+    index_[bucket].prefetch(res.second);
+
+    return res;
+  }
+
+  size_t seq_idx(const KMerHash &h) const {
+    size_t idx = index_[h.first].lookup_hash(h.second);
+
+    return (idx == -1ULL ? idx : segment_starts_[h.first] + idx);
+  }
+
   size_t raw_seq_idx(const KMerRawReference data) const {
     size_t bucket = raw_seq_bucket(data);
     size_t idx = index_[bucket].lookup(data);
@@ -120,12 +152,45 @@ public:
     segment_policy_.reset(num_segments_);
   }
 
+  // Layout which could be used in place without deserialization, see map()
+  void serialize_mapped(std::ostream &os) const {
+    mmapped::align(os);
+    mmapped::write(os, uint64_t(num_segments_));
+    for (size_t i = 0; i <= num_segments_; ++i)
+      mmapped::write(os, uint64_t(i < segment_starts_.size() ? segment_starts_[i] : 0));
+    for (size_t i = 0; i < num_segments_; ++i)
+      index_[i].save_mapped(os);
+  }
+
+  // Uses the perfect hash saved by serialize_mapped() in place, data is
+  // advanced past the index. The mapping ends at end and is kept alive by the
+  // holder.
+  void map(const uint8_t *&data, const uint8_t *end, std::shared_ptr<void> holder) {
+    clear();
+
+    mmapped::align(data);
+    num_segments_ = mmapped::read<uint64_t>(data, end);
+    mmapped::check(data, end, num_segments_, sizeof(uint64_t));
+    segment_starts_.resize(num_segments_ + 1);
+    for (auto &start : segment_starts_)
+      start = mmapped::read<uint64_t>(data, end);
+
+    index_.resize(num_segments_);
+    for (size_t i = 0; i < num_segments_; ++i)
+      CHECK_FATAL_ERROR(index_[i].map(data, end), "Truncated mapped data");
+
+    count_size();
+    segment_policy_.reset(num_segments_);
+    mapping_ = std::move(holder);
+  }
+
   void swap(KMerIndex<traits> &other) {
     std::swap(index_, other.index_);
     std::swap(num_segments_, other.num_segments_);
     std::swap(size_, other.size_);
     std::swap(segment_starts_, other.segment_starts_);
     std::swap(segment_policy_, other.segment_policy_);
+    std::swap(mapping_, other.mapping_);
   }
 
  private:
@@ -135,6 +200,8 @@ public:
   std::vector<size_t> segment_starts_;
   size_t size_;
   kmer::KMerSegmentPolicy<KMerSeq> segment_policy_;
+  // Keeps alive the memory used by the mapped index, see map()
+  std::shared_ptr<void> mapping_;
 
   size_t seq_bucket(const KMerSeq &s) const {
     return segment_policy_(s);
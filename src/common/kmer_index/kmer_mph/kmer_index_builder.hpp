@@ -16,6 +16,7 @@
 
 #include "utils/parallel/openmp_wrapper.h"
 #include "utils/logger/logger.hpp"
+#include "utils/memory_limit.hpp"
 #include "utils/perf/timetracer.hpp"
 
 #include "adt/kmer_vector.hpp"
@@ -24,8 +25,6 @@
 
 #include <boomphf/BooPHF.h>
 
-#include <pdqsort/pdqsort_pod.h>
-
 #include <algorithm>
 #ifdef USE_GLIBCXX_PARALLEL
 #include <parallel/algorithm>
@@ -38,6 +37,7 @@
 #endif
 
 #include <fstream>
+#include <functional>
 #include <vector>
 #include <cmath>
 
@@ -50,6 +50,7 @@ class KMerDiskStorage {
  public:
   typedef S Seq;
   typedef typename std::vector<fs::DependentTmpFile> Buckets;
+  typedef typename std::vector<adt::KMerVector<Seq>> MemoryBuckets;
   typedef typename kmer::KMerSegmentPolicy<Seq>       KMerSegmentPolicy;
   typedef typename std::pair<const typename Seq::DataType*, size_t> KMerRawData;
 
@@ -68,28 +69,48 @@ class KMerDiskStorage {
         : inner_iterator_(FileName, Seq::GetDataSize(k)),
           k_(k), kmer_bytes_(Seq::GetDataSize(k_) * sizeof(typename Seq::DataType)) {}
 
+    // In-memory bucket iterator
+    kmer_iterator(const adt::KMerVector<Seq> &bucket, unsigned k)
+        : inner_iterator_(),
+          k_(k), kmer_bytes_(Seq::GetDataSize(k_) * sizeof(typename Seq::DataType)),
+          cur_(bucket.data()), end_(bucket.data() + bucket.size() * bucket.el_size()) {}
+
     void operator+=(size_t n) {
-      inner_iterator_ += n;
+      if (cur_)
+        cur_ += n * Seq::GetDataSize(k_);
+      else
+        inner_iterator_ += n;
     }
 
    private:
     friend class boost::iterator_core_access;
 
     void increment() {
-      ++inner_iterator_;
+      if (cur_)
+        cur_ += Seq::GetDataSize(k_);
+      else
+        ++inner_iterator_;
     }
 
     bool equal(const kmer_iterator &other) const {
-        return inner_iterator_ == other.inner_iterator_;
+      if (cur_ || other.cur_)
+        return cur_ == end_ ? other.cur_ == other.end_ : cur_ == other.cur_;
+
+      return inner_iterator_ == other.inner_iterator_;
     }
 
     KMerRawData dereference() const {
+      if (cur_)
+        return { cur_, kmer_bytes_ };
+
       return { *inner_iterator_, kmer_bytes_ };
     }
 
     MMappedFileRecordArrayIterator<typename Seq::DataType> inner_iterator_;
     unsigned k_;
     size_t kmer_bytes_;
+    const typename Seq::DataType *cur_ = nullptr;
+    const typename Seq::DataType *end_ = nullptr;
   };
 
   static_assert(std::is_nothrow_move_constructible<kmer_iterator>::value, "kmer_iterator must be nonthrow move constructible");
@@ -103,6 +124,14 @@ class KMerDiskStorage {
     resize(policy.num_segments());
   }
 
+  // The storage takes ownership of sorted and deduplicated in-memory buckets,
+  // nothing is written to disk unless the final merge is requested.
+  KMerDiskStorage(fs::TmpDir work_dir, unsigned k,
+                  KMerSegmentPolicy policy, MemoryBuckets buckets)
+      : work_dir_(work_dir), k_(k), memory_buckets_(std::move(buckets)), segment_policy_(std::move(policy)) {
+    kmer_prefix_ = work_dir_->tmp_file("kmers");
+  }
+
   KMerDiskStorage(KMerDiskStorage &&) = default;
   KMerDiskStorage &operator=(KMerDiskStorage &&) = default;
 
@@ -127,11 +156,17 @@ class KMerDiskStorage {
   }
 
   unsigned k() const { return k_; }
+  bool in_memory() const { return !memory_buckets_.empty(); }
 
   size_t total_kmers() const {
     size_t fsize = 0;
     if (all_kmers_) {
       fsize = std::filesystem::file_size(*all_kmers_);
+    } else if (in_memory()) {
+      size_t total = 0;
+      for (const auto &bucket : memory_buckets_)
+        total += bucket.size();
+      return total;
     } else {
       for (const auto &file : buckets_)
         fsize += std::filesystem::file_size(*file);
@@ -146,10 +181,16 @@ class KMerDiskStorage {
   }
 
   size_t bucket_size(size_t i) const {
+    if (in_memory())
+      return memory_buckets_.at(i).size();
+
     return std::filesystem::file_size(*buckets_.at(i)) / (Seq::GetDataSize(k_) * sizeof(typename Seq::DataType));
   }
 
   kmer_iterator bucket_begin(size_t i) const {
+    if (in_memory())
+      return kmer_iterator(memory_buckets_.at(i), k_);
+
     return kmer_iterator(*buckets_.at(i), k_);
   }
 
@@ -161,7 +202,7 @@ class KMerDiskStorage {
     return adt::make_range(bucket_begin(i), bucket_end(i));
   }
 
-  size_t num_buckets() const { return buckets_.size(); }
+  size_t num_buckets() const { return in_memory() ? memory_buckets_.size() : buckets_.size(); }
   KMerSegmentPolicy segment_policy() const { return segment_policy_; }
 
   void merge() {
@@ -170,6 +211,9 @@ class KMerDiskStorage {
 
     all_kmers_ = work_dir_->tmp_file("final_kmers");
     std::ofstream ofs(all_kmers_->file(), std::ios::out | std::ios::binary);
+    for (const auto &bucket : memory_buckets_)
+      ofs.write((const char*)bucket.data(), bucket.size() * bucket.el_data_size());
+    memory_buckets_.clear();
     for (auto &entry : buckets_) {
       BucketStorage bucket(*entry, Seq::GetDataSize(k_), false);
       ofs.write((const char*)bucket.data(), bucket.data_size());
@@ -189,6 +233,7 @@ class KMerDiskStorage {
   }
 
   void BinWrite(std::ostream& os) const {
+    VERIFY_MSG(!in_memory(), "In-memory k-mer storage cannot be serialized, merge it first");
     io::binary::BinWrite(os,
                          k_, segment_policy_,
                          work_dir_,
@@ -202,6 +247,7 @@ class KMerDiskStorage {
   fs::TmpFile all_kmers_;
   unsigned k_;
   Buckets buckets_;
+  MemoryBuckets memory_buckets_;
   KMerSegmentPolicy segment_policy_;
 };
 
@@ -223,10 +269,21 @@ public:
   virtual KMerDiskStorage<Seq> Count(unsigned num_buckets, unsigned num_threads) = 0;
   virtual KMerDiskStorage<Seq> CountAll(unsigned num_buckets, unsigned num_threads, bool merge = true) = 0;
 
+  // The callback is invoked for every bucket as soon as it is counted,
+  // possibly concurrently from several threads.
+  typedef std::function<void(const KMerDiskStorage<Seq> &storage, size_t bucket)> BucketCallback;
+  void set_bucket_callback(BucketCallback cb) { on_bucket_ = std::move(cb); }
+
   virtual ~KMerCounter() {}
 
  protected:
   unsigned k_;
+  BucketCallback on_bucket_;
+
+  void NotifyBucket(const KMerDiskStorage<Seq> &storage, size_t bucket) const {
+    if (on_bucket_)
+      on_bucket_(storage, bucket);
+  }
 
   DECL_LOGGER("K-mer Counting");
 };
@@ -254,22 +311,69 @@ public:
   }
 
   KMerDiskStorage<Seq> Count(unsigned num_buckets, unsigned num_threads) override {
+    auto raw_kmers = Split(num_buckets, num_threads);
+    return CountRaw(raw_kmers, num_threads);
+  }
+
+  KMerDiskStorage<Seq> CountAll(unsigned num_buckets, unsigned num_threads, bool merge = true) override {
+    auto storage = this->Count(num_buckets, num_threads);
+    if (merge)
+      storage.merge();
+
+    return storage;
+  }
+
+protected:
+  std::unique_ptr<kmers::KMerSplitter<Seq>> splitter_;
+  fs::TmpDir work_dir_;
+
+  typename KMerSplitter<Seq>::RawKMers Split(unsigned num_buckets, unsigned num_threads) {
     // Split k-mers into buckets.
     INFO("Splitting kmer instances into " << num_buckets << " files using " << num_threads << " threads. This might take a while.");
-    TIME_TRACE_BEGIN("KMerDiskCounter::Split");
+    TIME_TRACE_SCOPE("KMerDiskCounter::Split");
     auto raw_kmers = splitter_->Split(num_buckets, num_threads);
     VERIFY(raw_kmers.size() == num_buckets);
-    TIME_TRACE_END;
 
+    return raw_kmers;
+  }
+
+  KMerDiskStorage<Seq> CountRaw(typename KMerSplitter<Seq>::RawKMers &raw_kmers, unsigned num_threads) {
     INFO("Starting k-mer counting.");
     KMerDiskStorage<Seq> res(work_dir_, this->k(), splitter_->bucket_policy());
+
+    // Buckets much larger than the average one are merged one by one using
+    // all the threads, the rest are merged in parallel single-threaded.
+    std::vector<size_t> large, small;
+    {
+      std::vector<size_t> sizes;
+      size_t total = 0;
+      for (const auto &file : raw_kmers) {
+        std::error_code ec;
+        size_t sz = std::filesystem::file_size(*file, ec);
+        sizes.push_back(ec ? 0 : sz);
+        total += sizes.back();
+      }
+
+      size_t threshold = 2 * total / std::max(raw_kmers.size(), size_t(1));
+      for (size_t i = 0; i < raw_kmers.size(); ++i)
+        (num_threads > 1 && sizes[i] > threshold ? large : small).push_back(i);
+    }
+
     size_t kmers = 0;
     {
         TIME_TRACE_SCOPE("KMerDiskCounter::Count");
+        for (size_t i : large) {
+          kmers += MergeKMers(*raw_kmers[i], *res.create(i), num_threads);
+          raw_kmers[i].reset();
+          this->NotifyBucket(res, i);
+        }
+
 #       pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
-        for (size_t i = 0; i < raw_kmers.size(); ++i) {
+        for (size_t j = 0; j < small.size(); ++j) {
+          size_t i = small[j];
           kmers += MergeKMers(*raw_kmers[i], *res.create(i));
           raw_kmers[i].reset();
+          this->NotifyBucket(res, i);
         }
     }
     INFO("K-mer counting done. There are " << kmers << " kmers in total. ");
@@ -281,19 +385,219 @@ public:
     return res;
   }
 
-  KMerDiskStorage<Seq> CountAll(unsigned num_buckets, unsigned num_threads, bool merge = true) override {
-    auto storage = Count(num_buckets, num_threads);
-    if (merge)
-      storage.merge();
+  using RawIterator = typename MMappedRecordArrayReader<typename Seq::DataType>::iterator;
+  using RawRange = adt::iterator_range<RawIterator>;
+  using RawLess = adt::array_less<typename Seq::DataType>;
+  using RawTree = adt::loser_tree<RawIterator, RawLess>;
 
-    return storage;
+  // Single buffered writer kept open during the whole bucket merge
+  class RawKMerWriter {
+   public:
+    explicit RawKMerWriter(const std::filesystem::path &fname)
+        : fname_(fname), f_(fopen(fname.c_str(), "wb")) {
+      if (!f_)
+        FATAL_ERROR("Cannot open temporary file " << fname_ << " for writing");
+      setvbuf(f_, nullptr, _IOFBF, 8 * 1024 * 1024);
+    }
+
+    ~RawKMerWriter() {
+      if (fclose(f_) != 0)
+        FATAL_ERROR("I/O error! Cannot close " << fname_ << ". Reason: " << strerror(errno) << ". Error code: " << errno);
+    }
+
+    void write(const adt::KMerVector<Seq> &buf) {
+      size_t res = fwrite(buf.data(), buf.el_data_size(), buf.size(), f_);
+      if (res != buf.size())
+        FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+    }
+
+   private:
+    std::filesystem::path fname_;
+    FILE *f_;
+  };
+
+  // Pops unique k-mers from the tree into buf until limit is reached. All the
+  // copies of the last k-mer are consumed as well, so subsequent calls never
+  // produce duplicates.
+  static void FillUnique(RawTree &tree, adt::KMerVector<Seq> &buf, size_t limit = -1ULL) {
+    buf.clear();
+    if (tree.empty())
+      return;
+
+    buf.push_back(tree.pop());
+    while (buf.size() < limit) {
+      while (!tree.empty() &&
+             adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
+        tree.replay();
+
+      if (tree.empty())
+        break;
+
+      buf.push_back(tree.top());
+      tree.replay();
+    }
+
+    // Handle the last value
+    while (!tree.empty() &&
+           adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
+      tree.replay();
   }
 
-private:
-  std::unique_ptr<kmers::KMerSplitter<Seq>> splitter_;
-  fs::TmpDir work_dir_;
+  size_t MergeRuns(const std::vector<RawRange> &ranges, RawKMerWriter &out) {
+    if (ranges.empty())
+      return 0;
+
+    RawTree tree(ranges);
+    adt::KMerVector<Seq> buf(this->k(), 1024*1024);
+    size_t total = 0;
+    while (!tree.empty()) {
+      FillUnique(tree, buf, buf.capacity());
+      total += buf.size();
+      out.write(buf);
+    }
+
+    return total;
+  }
+
+  // Splits the key space of the runs into disjoint ranges using sampled
+  // pivots, so each range could be merged independently. Equal k-mers always
+  // fall into the same range, therefore no deduplication across ranges is
+  // necessary.
+  size_t MergeRunsParallel(const std::vector<RawRange> &ranges, RawKMerWriter &out, unsigned num_threads) {
+    TIME_TRACE_SCOPE("KMerDiskCounter::MergeRunsParallel");
+    RawLess less;
+
+    size_t total = 0;
+    for (const auto &range : ranges)
+      total += range.end() - range.begin();
+
+    const size_t min_part_size = 1024 * 1024;
+    size_t num_parts = std::min(size_t(4 * num_threads), total / min_part_size + 1);
+    if (num_parts < 2)
+      return MergeRuns(ranges, out);
+
+    std::vector<RawIterator> pivots;
+    {
+      TIME_TRACE_SCOPE("KMerDiskCounter::SamplePivots");
+      std::vector<RawIterator> samples;
+      const size_t oversampling = 16;
+      for (const auto &range : ranges) {
+        size_t sz = range.end() - range.begin();
+        size_t cnt = std::min(sz, oversampling * num_parts * sz / total + 1);
+        for (size_t i = 0; i < cnt; ++i)
+          samples.push_back(range.begin() + (i * sz / cnt));
+      }
+      std::sort(samples.begin(), samples.end(),
+                [&](const RawIterator &a, const RawIterator &b) { return less(*a, *b); });
+      for (size_t i = 1; i < num_parts; ++i)
+        pivots.push_back(samples[i * samples.size() / num_parts]);
+    }
+
+    // Part boundaries inside each run
+    std::vector<std::vector<RawIterator>> bounds(ranges.size());
+    for (size_t r = 0; r < ranges.size(); ++r) {
+      auto &bound = bounds[r];
+      bound.push_back(ranges[r].begin());
+      for (const auto &pivot : pivots)
+        bound.push_back(std::lower_bound(bound.back(), ranges[r].end(), *pivot, less));
+      bound.push_back(ranges[r].end());
+    }
+
+    // Merge the parts in waves to bound the memory consumption, the output is
+    // written in part order by the calling thread.
+    size_t res = 0;
+    for (size_t wave = 0; wave < num_parts; wave += num_threads) {
+      size_t cnt = std::min(size_t(num_threads), num_parts - wave);
+      std::vector<adt::KMerVector<Seq>> bufs;
+      bufs.reserve(cnt);
+      for (size_t i = 0; i < cnt; ++i)
+        bufs.emplace_back(this->k());
+
+#     pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+      for (size_t i = 0; i < cnt; ++i) {
+        size_t part = wave + i;
+        std::vector<RawRange> part_ranges;
+        for (const auto &bound : bounds) {
+          if (bound[part] != bound[part + 1])
+            part_ranges.push_back(adt::make_range(bound[part], bound[part + 1]));
+        }
+
+        if (part_ranges.empty())
+          continue;
+
+        RawTree tree(part_ranges);
+        FillUnique(tree, bufs[i]);
+      }
+
+      for (const auto &buf : bufs) {
+        out.write(buf);
+        res += buf.size();
+      }
+    }
+
+    return res;
+  }
+
+  // Streams the encoded runs through the decoders, the key space of encoded
+  // runs could not be partitioned without decoding, so the merge is serial.
+  size_t MergeEncodedRuns(const std::filesystem::path &ifname, RawKMerWriter &out) {
+    using ElTy = typename Seq::DataType;
+    using Iterator = RawKMerRunIterator<ElTy>;
+
+    size_t elcnt = Seq::GetDataSize(this->k());
+    RawKMerCodec codec = splitter_->raw_kmer_codec();
+    MMappedReader ins(ifname, /* unlink */ true, -1ULL);
+    MMappedRecordReader<size_t> index(ifname.native() + ".idx", true, -1ULL);
+    VERIFY(index.size() % 2 == 0);
+
+    std::vector<adt::iterator_range<Iterator>> ranges;
+    const uint8_t *data = (const uint8_t*)ins.data();
+    for (size_t i = 0, offset = 0; i < index.size(); i += 2) {
+      size_t cnt = index[i], bytes = index[i + 1];
+      VERIFY(offset + bytes <= ins.size());
+      if (cnt)
+        ranges.push_back(adt::make_range(Iterator(std::make_shared<RawKMerRunDecoder<ElTy>>(codec, data + offset, bytes, cnt, elcnt)),
+                                         Iterator()));
+      offset += bytes;
+    }
+
+    if (ranges.empty())
+      return 0;
+
+    RawKMerPtrLess<ElTy> less(elcnt);
+    adt::loser_tree<Iterator, RawKMerPtrLess<ElTy>> tree(ranges, less);
+    adt::KMerVector<Seq> buf(this->k(), 1024*1024);
+    size_t total = 0;
+    while (!tree.empty()) {
+      buf.clear();
+      while (!tree.empty() && buf.size() < buf.capacity()) {
+        const ElTy *top = tree.top();
+        if (!buf.size() || less(buf[buf.size() - 1], top))
+          buf.push_back(top);
+        tree.replay();
+      }
+
+      // Handle the last value
+      while (!tree.empty() && !less(buf[buf.size() - 1], tree.top()))
+        tree.replay();
+
+      total += buf.size();
+      out.write(buf);
+    }
+
+    return total;
+  }
+
+  size_t MergeKMers(const std::filesystem::path &ifname, const std::filesystem::path &ofname,
+                    unsigned num_threads = 1) {
+    TIME_TRACE_SCOPE("KMerDiskCounter::MergeKMers");
+    if constexpr (std::is_unsigned<typename Seq::DataType>::value) {
+      if (splitter_->raw_kmer_codec() != RawKMerCodec::Plain) {
+        RawKMerWriter out(ofname);
+        return MergeEncodedRuns(ifname, out);
+      }
+    }
 
-  size_t MergeKMers(const std::filesystem::path &ifname, const std::filesystem::path &ofname) {
     MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
 
     std::filesystem::path IdxFileName = ifname.native() + ".idx";
@@ -304,82 +608,95 @@ private:
       // INFO("Total runs: " << index.size());
 
       // Prepare runs
-      std::vector<adt::iterator_range<decltype(ins.begin())>> ranges;
+      std::vector<RawRange> ranges;
       auto beg = ins.begin();
       for (size_t sz : index) {
         auto end = std::next(beg, sz);
-        ranges.push_back(adt::make_range(beg, end));
-        VERIFY(std::is_sorted(beg, end, adt::array_less<typename Seq::DataType>()));
+        VERIFY(std::is_sorted(beg, end, RawLess()));
+        if (sz)
+          ranges.push_back(adt::make_range(beg, end));
         beg = end;
       }
 
-      // Construct tree on top entries of runs
-      adt::loser_tree<decltype(beg),
-              adt::array_less<typename Seq::DataType>> tree(ranges);
-
-      if (tree.empty()) {
-        FILE *g = fopen(ofname.c_str(), "ab");
-        if (!g)
-          FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-        fclose(g);
-        return 0;
-      }
-
       // Write it down!
-      adt::KMerVector<Seq> buf(this->k(), 1024*1024);
-      size_t total = 0;
-      while (!tree.empty()) {
-          buf.clear();
-          buf.push_back(tree.pop());
-          size_t cnt = 1;
-
-          while (cnt < buf.capacity()) {
-            while (!tree.empty() &&
-                   adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
-              tree.replay();
-
-            if (tree.empty())
-              break;
-
-            buf.push_back(tree.top());
-            tree.replay();
-            cnt += 1;
-          }
-
-          // Handle the last value
-          while (!tree.empty() &&
-                 adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
-            tree.replay();
-
-          total += buf.size();
-
-          FILE *g = fopen(ofname.c_str(), "ab");
-          if (!g)
-            FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-          size_t res = fwrite(buf.data(), buf.el_data_size(), buf.size(), g);
-          if (res != buf.size())
-            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-          fclose(g);
-      }
+      RawKMerWriter out(ofname);
+      if (num_threads > 1)
+        return MergeRunsParallel(ranges, out, num_threads);
 
-      return total;
+      return MergeRuns(ranges, out);
     } else {
       // Sort the stuff
-      pdqsort_pod(ins.data(), ins.data() + ins.size() * ins.elcnt(), ins.elcnt());
-
-      // FIXME: Use something like parallel version of unique_copy but with explicit
-      // resizing.
-      auto it = std::unique(ins.begin(), ins.end(), adt::array_equal_to<typename Seq::DataType>());
+      size_t cnt = SortUniqueKMers<Seq>(ins.data(), ins.size(), ins.elcnt(), num_threads);
 
       MMappedRecordArrayWriter<typename Seq::DataType> os(ofname, Seq::GetDataSize(this->k()));
-      os.resize(it - ins.begin());
-      std::copy(ins.begin(), it, os.begin());
+      os.resize(cnt);
+      std::copy(ins.begin(), ins.begin() + cnt, os.begin());
 
-      return it - ins.begin();
+      return cnt;
     }
   }
 };
 
+// Keeps all raw k-mers in memory and sorts them in place, never touching the
+// disk. Falls back to KMerDiskCounter behavior if the k-mers do not fit into
+// the given fraction of free memory.
+template<class Seq, class traits = kmer_index_traits<Seq> >
+class KMerMemoryCounter : public KMerDiskCounter<Seq, traits> {
+  typedef KMerDiskCounter<Seq, traits> __super;
+public:
+  template<class Splitter>
+  KMerMemoryCounter(fs::TmpDir work_dir,
+                    Splitter splitter, double memory_fraction = 0.5)
+      : __super(work_dir, std::move(splitter)), memory_fraction_(memory_fraction) {}
+
+  template<class Splitter>
+  KMerMemoryCounter(const std::filesystem::path &work_dir,
+                    Splitter splitter, double memory_fraction = 0.5)
+      : KMerMemoryCounter(fs::tmp::make_temp_dir(work_dir, "kmer_counter"), std::move(splitter), memory_fraction) {}
+
+  KMerDiskStorage<Seq> Count(unsigned num_buckets, unsigned num_threads) override {
+    this->splitter_->set_memory_limit(std::max(size_t((double)utils::get_free_memory() * memory_fraction_), size_t(1)));
+    auto raw_kmers = this->Split(num_buckets, num_threads);
+    if (!this->splitter_->in_memory()) {
+      INFO("Falling back to disk-based k-mer counting");
+      return this->CountRaw(raw_kmers, num_threads);
+    }
+
+    INFO("Starting in-memory k-mer counting.");
+    auto buckets = this->splitter_->TakeMemoryKMers();
+    this->splitter_->set_memory_limit(0);
+    VERIFY(buckets.size() == raw_kmers.size());
+    size_t kmers = 0;
+    {
+        TIME_TRACE_SCOPE("KMerMemoryCounter::Count");
+#       pragma omp parallel for shared(buckets) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
+        for (size_t i = 0; i < buckets.size(); ++i) {
+          auto &bucket = buckets[i];
+          bucket.shrink(SortUniqueKMers(bucket));
+          bucket.shrink_to_fit();
+          kmers += bucket.size();
+        }
+    }
+    INFO("K-mer counting done. There are " << kmers << " kmers in total. ");
+    if (!kmers) {
+      FATAL_ERROR("No kmers were extracted from reads. Check the read lengths and k-mer length settings");
+      exit(-1);
+    }
+
+    KMerDiskStorage<Seq> res(this->work_dir_, this->k(), this->splitter_->bucket_policy(), std::move(buckets));
+    if (this->on_bucket_) {
+#     pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+      for (size_t i = 0; i < res.num_buckets(); ++i)
+        this->NotifyBucket(res, i);
+    }
+
+    return res;
+  }
+
+private:
+  double memory_fraction_;
+};
+
 template<class Index>
 class KMerIndexBuilder {
   typedef typename Index::KMerSeq Seq;
@@ -404,25 +721,17 @@ class KMerIndexBuilder {
     auto segment_policy = kmer_storage.segment_policy();
     size_t segments = segment_policy.num_segments();
     index.segment_starts_.resize(segments + 1, 0);
-    index.segment_policy_ = segment_policy;
-    index.num_segments_ = segments;
 
     INFO("Building perfect hash indices");
 
     if (segments == kmer_storage.num_buckets()) {
       // Build segmented index joining all buckets
       TIME_TRACE_SCOPE("KMerIndexBuilder::BuildIndex(storage, segmented)");
-      for (size_t i = 0; i < kmer_storage.num_buckets(); ++i)
-        // Use of gamma = 4 implies ~5.7 bits per k-mer, however, faster construction and lookup
-        index.index_.emplace_back(kmer_storage.bucket_size(i),
-                                  Index::KMerDataIndex::ConflictPolicy::Ignore,
-                                  /* gamma */ 4.0);
+      index.index_.resize(kmer_storage.num_buckets());
 
 #     pragma omp parallel for shared(index) num_threads(num_threads_)
-      for (size_t i = 0; i < kmer_storage.num_buckets(); ++i) {
-          index.segment_starts_[i + 1] = kmer_storage.bucket_size(i);
-          index.index_[i].build(boomphf::range(kmer_storage.bucket_begin(i), kmer_storage.bucket_end(i)));
-      }
+      for (size_t i = 0; i < kmer_storage.num_buckets(); ++i)
+        BuildSegment(index, kmer_storage, i);
     } else {
       // Build single index parallel over buckets
       TIME_TRACE_SCOPE("KMerIndexBuilder::BuildIndex(storage, parallel)");
@@ -438,24 +747,35 @@ class KMerIndexBuilder {
       index.index_[0].build(ranges, num_threads_);
     }
 
-    // Finally, record the sizes of buckets.
-    for (unsigned i = 1; i < segments; ++i)
-      index.segment_starts_[i] += index.segment_starts_[i - 1];
-
-    double bits_per_kmer = 8.0 * (double)index.mem_size() / (double)kmer_storage.total_kmers();
-    INFO("Index built. Total " << kmer_storage.total_kmers() << " kmers, " << index.mem_size() << " bytes occupied (" << bits_per_kmer << " bits per kmer).");
-    index.count_size();
+    FinalizeIndex(index, kmer_storage);
   }
 
   auto BuildIndex(Index &index, KMerCounter<Seq> &counter, bool save_final = false) {
     TIME_TRACE_SCOPE("KMerIndexBuilder::BuildIndex(counter)");
 
     INFO("Building kmer index");
-    // First, count the unique k-mers
+
+    // Build the segments of the index as soon as the corresponding buckets
+    // are counted, overlapping counting I/O with perfect hash construction.
+    VERIFY(num_buckets_ > 0);
+    index.clear();
+    index.index_.resize(num_buckets_);
+    index.segment_starts_.resize(num_buckets_ + 1, 0);
+    counter.set_bucket_callback([&](const KMerDiskStorage<Seq> &storage, size_t i) {
+        BuildSegment(index, storage, i);
+    });
     auto kmer_storage = counter.Count(num_buckets_, num_threads_);
+    counter.set_bucket_callback(nullptr);
 
-    // Now, build the index itself
-    BuildIndex(index, kmer_storage);
+    if (kmer_storage.segment_policy().num_segments() == num_buckets_ &&
+        kmer_storage.num_buckets() == num_buckets_) {
+      TIME_TRACE_SCOPE("KMerIndexBuilder::BuildIndex(counter, pipelined)");
+      INFO("Perfect hash indices were built during k-mer counting");
+      FinalizeIndex(index, kmer_storage);
+    } else {
+      // Non-segmented bucket policy, build the index from scratch
+      BuildIndex(index, kmer_storage);
+    }
 
     if (save_final)
       kmer_storage.merge();
@@ -464,6 +784,32 @@ class KMerIndexBuilder {
   }
 
  private:
+  template<class KMerStorage>
+  void BuildSegment(Index &index, const KMerStorage &kmer_storage, size_t i) const {
+    // Use of gamma = 4 implies ~5.7 bits per k-mer, however, faster construction and lookup
+    index.index_[i].init(kmer_storage.bucket_size(i),
+                         Index::KMerDataIndex::ConflictPolicy::Ignore,
+                         /* gamma */ 4.0);
+    index.segment_starts_[i + 1] = kmer_storage.bucket_size(i);
+    index.index_[i].build(boomphf::range(kmer_storage.bucket_begin(i), kmer_storage.bucket_end(i)));
+  }
+
+  template<class KMerStorage>
+  void FinalizeIndex(Index &index, const KMerStorage &kmer_storage) const {
+    auto segment_policy = kmer_storage.segment_policy();
+    size_t segments = segment_policy.num_segments();
+    index.segment_policy_ = segment_policy;
+    index.num_segments_ = segments;
+
+    // Finally, record the sizes of buckets.
+    for (unsigned i = 1; i < segments; ++i)
+      index.segment_starts_[i] += index.segment_starts_[i - 1];
+
+    double bits_per_kmer = 8.0 * (double)index.mem_size() / (double)kmer_storage.total_kmers();
+    INFO("Index built. Total " << kmer_storage.total_kmers() << " kmers, " << index.mem_size() << " bytes occupied (" << bits_per_kmer << " bits per kmer).");
+    index.count_size();
+  }
+
   DECL_LOGGER("K-mer Index Building");
 };
 
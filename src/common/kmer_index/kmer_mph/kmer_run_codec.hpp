@@ -0,0 +1,236 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+#include "utils/logger/logger.hpp"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <zlib.h>
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace kmers {
+
+// Encoding of the sorted runs of raw k-mers spilled by KMerSortingSplitter.
+//  - Plain: raw k-mer data, run sizes are stored in .idx file
+//  - Delta: every k-mer is stored as the number of leading bytes shared with
+//    the previous one followed by the remaining bytes (bytes are enumerated
+//    from the most significant one, so sorted k-mers share long prefixes)
+//  - DeltaZlib: delta-encoded run additionally compressed with deflate
+// For encoded runs .idx file contains pairs of (number of k-mers, number of bytes).
+enum class RawKMerCodec {
+    Plain,
+    Delta,
+    DeltaZlib
+};
+
+namespace run_codec {
+
+template<class T>
+inline uint8_t get_byte(const T *el, size_t byte) {
+    constexpr size_t word_bytes = sizeof(T);
+    return uint8_t(el[byte / word_bytes] >> (8 * (word_bytes - 1 - byte % word_bytes)));
+}
+
+template<class T>
+inline void set_byte(T *el, size_t byte, uint8_t val) {
+    constexpr size_t word_bytes = sizeof(T);
+    unsigned shift = unsigned(8 * (word_bytes - 1 - byte % word_bytes));
+    T &word = el[byte / word_bytes];
+    word = T((word & ~(T(0xFF) << shift)) | (T(val) << shift));
+}
+
+}
+
+// Encodes a sorted run of cnt k-mers, elcnt words each
+template<class T>
+std::vector<uint8_t> EncodeRawKMers(RawKMerCodec codec, const T *data, size_t cnt, size_t elcnt) {
+    static_assert(std::is_unsigned<T>::value, "only k-mers represented by unsigned words could be encoded");
+    VERIFY(codec != RawKMerCodec::Plain);
+
+    const size_t total_bytes = elcnt * sizeof(T);
+    VERIFY(total_bytes < 256);
+
+    std::vector<uint8_t> res;
+    res.reserve(cnt * total_bytes / 2);
+    const T *prev = nullptr;
+    for (size_t i = 0; i < cnt; ++i, data += elcnt) {
+        size_t lcp = 0;
+        if (prev) {
+            while (lcp < total_bytes &&
+                   run_codec::get_byte(prev, lcp) == run_codec::get_byte(data, lcp))
+                lcp += 1;
+        }
+
+        res.push_back(uint8_t(lcp));
+        for (size_t b = lcp; b < total_bytes; ++b)
+            res.push_back(run_codec::get_byte(data, b));
+        prev = data;
+    }
+
+    if (codec == RawKMerCodec::Delta)
+        return res;
+
+    uLongf compressed_size = compressBound(uLong(res.size()));
+    std::vector<uint8_t> compressed(compressed_size);
+    int status = compress2(compressed.data(), &compressed_size, res.data(), uLong(res.size()), /* level */ 1);
+    CHECK_FATAL_ERROR(status == Z_OK, "Failed to compress raw k-mers, zlib error code: " << status);
+    compressed.resize(compressed_size);
+
+    return compressed;
+}
+
+// Streaming decoder of a single encoded run. The last two decoded k-mers are
+// kept valid, so the value of the iterator could be used after it is advanced.
+template<class T>
+class RawKMerRunDecoder {
+  public:
+    RawKMerRunDecoder(RawKMerCodec codec, const uint8_t *data, size_t bytes, size_t cnt, size_t elcnt)
+            : codec_(codec), data_(data), bytes_(bytes), remaining_(cnt),
+              elcnt_(elcnt), total_bytes_(elcnt * sizeof(T)),
+              slots_(2 * elcnt), current_(0) {
+        VERIFY(codec != RawKMerCodec::Plain);
+        if (codec_ == RawKMerCodec::DeltaZlib) {
+            memset(&stream_, 0, sizeof(stream_));
+            stream_.next_in = const_cast<Bytef*>(data_);
+            stream_.avail_in = uInt(bytes_);
+            int status = inflateInit(&stream_);
+            CHECK_FATAL_ERROR(status == Z_OK, "Failed to initialize raw k-mers decompression, zlib error code: " << status);
+            buffer_.resize(1 << 16);
+        } else {
+            pos_ = data_;
+            end_ = data_ + bytes_;
+        }
+
+        next();
+    }
+
+    RawKMerRunDecoder(const RawKMerRunDecoder&) = delete;
+    RawKMerRunDecoder &operator=(const RawKMerRunDecoder&) = delete;
+
+    ~RawKMerRunDecoder() {
+        if (codec_ == RawKMerCodec::DeltaZlib)
+            inflateEnd(&stream_);
+    }
+
+    bool good() const { return good_; }
+    const T *current() const { return slots_.data() + current_ * elcnt_; }
+
+    void next() {
+        if (!remaining_) {
+            good_ = false;
+            return;
+        }
+
+        const T *prev = current();
+        current_ ^= 1;
+        T *el = slots_.data() + current_ * elcnt_;
+
+        size_t lcp = get();
+        VERIFY(lcp <= total_bytes_);
+        memcpy(el, prev, elcnt_ * sizeof(T));
+        for (size_t b = lcp; b < total_bytes_; ++b)
+            run_codec::set_byte(el, b, get());
+
+        remaining_ -= 1;
+        good_ = true;
+    }
+
+  private:
+    uint8_t get() {
+        if (pos_ == end_)
+            refill();
+        return *pos_++;
+    }
+
+    void refill() {
+        VERIFY_MSG(codec_ == RawKMerCodec::DeltaZlib, "Truncated raw k-mers run");
+
+        stream_.next_out = buffer_.data();
+        stream_.avail_out = uInt(buffer_.size());
+        int status = inflate(&stream_, Z_NO_FLUSH);
+        CHECK_FATAL_ERROR(status == Z_OK || status == Z_STREAM_END,
+                          "Failed to decompress raw k-mers, zlib error code: " << status);
+        pos_ = buffer_.data();
+        end_ = buffer_.data() + (buffer_.size() - stream_.avail_out);
+        VERIFY_MSG(pos_ != end_, "Truncated raw k-mers run");
+    }
+
+    RawKMerCodec codec_;
+    const uint8_t *data_;
+    size_t bytes_;
+    size_t remaining_;
+    size_t elcnt_;
+    size_t total_bytes_;
+    std::vector<T> slots_;
+    unsigned current_;
+    bool good_ = false;
+
+    const uint8_t *pos_ = nullptr;
+    const uint8_t *end_ = nullptr;
+    z_stream stream_;
+    std::vector<uint8_t> buffer_;
+};
+
+// Input iterator over decoded run yielding pointers to the raw k-mer data
+template<class T>
+class RawKMerRunIterator :
+        public boost::iterator_facade<RawKMerRunIterator<T>,
+                                      const T*,
+                                      std::input_iterator_tag,
+                                      const T*> {
+  public:
+    // Default ctor, used to implement "end" iterator
+    RawKMerRunIterator() = default;
+
+    explicit RawKMerRunIterator(std::shared_ptr<RawKMerRunDecoder<T>> decoder)
+            : decoder_(std::move(decoder)) {}
+
+  private:
+    friend class boost::iterator_core_access;
+
+    bool at_end() const { return !decoder_ || !decoder_->good(); }
+
+    void increment() { decoder_->next(); }
+
+    bool equal(const RawKMerRunIterator &other) const {
+        if (at_end() || other.at_end())
+            return at_end() == other.at_end();
+
+        return decoder_ == other.decoder_;
+    }
+
+    const T *dereference() const { return decoder_->current(); }
+
+    std::shared_ptr<RawKMerRunDecoder<T>> decoder_;
+};
+
+// Lexicographic comparison of raw k-mers given by pointers, same order as adt::array_less
+template<class T>
+struct RawKMerPtrLess {
+    explicit RawKMerPtrLess(size_t elcnt = 0)
+            : elcnt_(elcnt) {}
+
+    bool operator()(const T *lhs, const T *rhs) const {
+        for (size_t i = 0; i < elcnt_; ++i) {
+            if (lhs[i] != rhs[i])
+                return lhs[i] < rhs[i];
+        }
+
+        return false;
+    }
+
+    size_t elcnt_;
+};
+
+}
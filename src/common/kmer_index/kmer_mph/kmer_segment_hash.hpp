@@ -0,0 +1,149 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "adt/cyclichash.hpp"
+#include "sequence/rtseq.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace kmer {
+
+// Hash used to assign k-mers to the segments of the index. By default it is
+// just the hash of the k-mer.
+template<class Seq>
+struct KMerSegmentHash {
+    uint64_t operator()(const Seq &s) const {
+        return typename Seq::hash()(s);
+    }
+
+    template<class Ref>
+    uint64_t operator()(Ref s) const {
+        return typename Seq::hash()(s.data(), s.size());
+    }
+};
+
+// RtSeq k-mers are assigned to the segments by the cyclic hash of all the
+// nucleotide slots of the k-mer data, including the zero padding of the last
+// word. This way the hash could be computed both from the raw k-mer data
+// (which does not know K) and in O(1) per k-mer while rolling over a
+// sequence, see RollingKMerHash.
+template<>
+struct KMerSegmentHash<RtSeq> {
+    typedef rolling_hash::digest digest;
+
+    uint64_t operator()(const RtSeq &s) const {
+        return (*this)(s.data(), s.data_size());
+    }
+
+    template<class Ref>
+    uint64_t operator()(Ref s) const {
+        return (*this)(s.data(), s.size());
+    }
+
+    uint64_t operator()(const RtSeq::DataType *data, size_t sz) const {
+        static_assert(RtSeq::TBits % 8 == 0, "k-mer data should consist of whole bytes");
+
+        // Nucleotides are packed starting from the lowest bits, so process
+        // every word byte by byte starting from the lowest one
+        const auto &table = byte_table();
+        digest h = 0;
+        for (size_t i = 0; i < sz; ++i) {
+            RtSeq::DataType word = data[i];
+            for (size_t b = 0; b < sizeof(RtSeq::DataType); ++b, word >>= 8)
+                h = rol(h, 4) ^ table[word & 0xFF];
+        }
+
+        return finalize(h);
+    }
+
+    static digest rol(digest x, unsigned s) {
+        s %= 64;
+        return s ? (x << s | x >> (64 - s)) : x;
+    }
+
+    // Cyclic hash is linear, mix the bits before reducing the hash to segments
+    static uint64_t finalize(digest h) {
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+  private:
+    // Cyclic hash of four nucleotides packed into the byte
+    static const std::array<digest, 256> &byte_table() {
+        static const std::array<digest, 256> table = [] {
+            rolling_hash::NDNASeqHash hasher;
+            std::array<digest, 256> res;
+            for (unsigned byte = 0; byte < 256; ++byte) {
+                digest h = 0;
+                for (unsigned j = 0; j < 4; ++j)
+                    h = rol(h, 1) ^ hasher(rolling_hash::chartype((byte >> (2 * j)) & 3));
+                res[byte] = h;
+            }
+            return res;
+        }();
+
+        return table;
+    }
+};
+
+// Rolling forward and reverse-complement cyclic hash of consecutive k-mers of
+// a sequence. Provides the segment hashes of the k-mer and of its reverse
+// complement equal to KMerSegmentHash<RtSeq>, so the segment of the
+// canonical k-mer is known without rehashing of the k-mer data.
+class RollingKMerHash {
+    typedef rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> Hasher;
+    typedef rolling_hash::digest digest;
+    typedef KMerSegmentHash<RtSeq> SegmentHash;
+
+  public:
+    explicit RollingKMerHash(unsigned k)
+            : hasher_(k),
+              padding_(unsigned(RtSeq::GetDataSize(k) * RtSeq::TNucl - k)),
+              padding_hash_(0) {
+        rolling_hash::NDNASeqHash hasher;
+        for (unsigned i = 0; i < padding_; ++i)
+            padding_hash_ = SegmentHash::rol(padding_hash_, 1) ^ hasher(0);
+    }
+
+    // Hashes the first k nucleotides of the sequence
+    template<class Seq>
+    void reset(const Seq &s) {
+        digest_ = hasher_(s);
+    }
+
+    // Moves to the next k-mer: outnucl leaves the k-mer, innucl is appended
+    void update(char outnucl, char innucl) {
+        digest_ = hasher_.hash_update(digest_, rolling_hash::chartype(outnucl), rolling_hash::chartype(innucl));
+    }
+
+    uint64_t segment_hash() const {
+        return padded(digest_.fwd);
+    }
+
+    uint64_t rc_segment_hash() const {
+        return padded(digest_.rvs);
+    }
+
+    uint64_t segment_hash(bool forward) const {
+        return forward ? segment_hash() : rc_segment_hash();
+    }
+
+  private:
+    uint64_t padded(digest h) const {
+        return SegmentHash::finalize(SegmentHash::rol(h, padding_) ^ padding_hash_);
+    }
+
+    Hasher hasher_;
+    unsigned padding_;
+    digest padding_hash_;
+    Hasher::CyclicDigest digest_;
+};
+
+}
@@ -8,7 +8,9 @@
 #pragma once
 
 #include "kmer_buckets.hpp"
+#include "kmer_run_codec.hpp"
 
+#include "adt/array_radix_sort.hpp"
 #include "adt/kmer_vector.hpp"
 #include "utils/filesystem/file_limit.hpp"
 #include "utils/filesystem/temporary.hpp"
@@ -21,11 +23,32 @@
 
 namespace kmers {
 
+// Sorts raw k-mers in place and moves the unique ones to the beginning,
+// returns the number of unique k-mers. Radix sort is used for k-mers
+// represented by unsigned words, generic comparison sort otherwise.
+template<class Seq>
+size_t SortUniqueKMers(typename Seq::DataType *data, size_t n, size_t elcnt, unsigned nthreads = 1) {
+    using ElTy = typename Seq::DataType;
+    if constexpr (std::is_unsigned<ElTy>::value) {
+        return adt::array_radix_sort_unique(data, n, elcnt, nthreads);
+    } else {
+        pdqsort_pod(data, data + n * elcnt, elcnt);
+        adt::array_vector<ElTy> v(data, n, elcnt);
+        return std::unique(v.begin(), v.end(), adt::array_equal_to<ElTy>()) - v.begin();
+    }
+}
+
+template<class Seq>
+size_t SortUniqueKMers(adt::KMerVector<Seq> &v, unsigned nthreads = 1) {
+    return SortUniqueKMers<Seq>(v.data(), v.size(), v.el_size(), nthreads);
+}
+
 template<class Seq>
 class KMerSplitter {
 public:
     typedef typename kmer::KMerSegmentPolicy<Seq> KMerBuckets;
     typedef std::vector<fs::DependentTmpFile> RawKMers;
+    typedef std::vector<adt::KMerVector<Seq>> MemoryKMers;
 
     KMerSplitter(const std::filesystem::path &work_dir, unsigned K)
             : KMerSplitter(fs::tmp::make_temp_dir(work_dir, "kmer_splitter"), K) {}
@@ -44,10 +67,34 @@ public:
     unsigned K() const { return K_; }
     KMerBuckets bucket_policy() const { return bucket_; }
 
+    // When memory limit is set, the splitter keeps raw k-mers in RAM instead
+    // of spilling them to disk. Once the limit is exceeded, everything is
+    // flushed to the raw k-mer files and the splitter falls back to disk mode.
+    void set_memory_limit(size_t limit) { memory_limit_ = limit; }
+    bool in_memory() const { return memory_limit_ > 0; }
+
+    MemoryKMers TakeMemoryKMers() {
+        VERIFY(in_memory());
+        return std::move(memory_kmers_);
+    }
+
+    // Encoding of the sorted runs written to the raw k-mer files
+    void set_raw_kmer_codec(RawKMerCodec codec) {
+        if constexpr (std::is_unsigned<typename Seq::DataType>::value) {
+            raw_kmer_codec_ = codec;
+        } else if (codec != RawKMerCodec::Plain) {
+            WARN("Raw k-mer encoding is not supported for this k-mer type, storing k-mers as is");
+        }
+    }
+    RawKMerCodec raw_kmer_codec() const { return raw_kmer_codec_; }
+
 protected:
     fs::TmpDir work_dir_;
     unsigned K_;
     KMerBuckets bucket_;
+    size_t memory_limit_ = 0;
+    MemoryKMers memory_kmers_;
+    RawKMerCodec raw_kmer_codec_ = RawKMerCodec::Plain;
 
     DECL_LOGGER("K-mer Splitting");
 };
@@ -100,6 +147,14 @@ protected:
             cell_size_ = 16384;
 
         INFO("Using cell size of " << cell_size_);
+        if (this->in_memory()) {
+            INFO("Keeping raw k-mers in memory, limit: " << (double)this->memory_limit_ / 1024.0 / 1024.0 / 1024.0 << " Gb");
+            this->memory_kmers_.clear();
+            this->memory_kmers_.reserve(num_files_);
+            for (unsigned i = 0; i < num_files_; ++i)
+                this->memory_kmers_.emplace_back(this->K_);
+        }
+
         kmer_buffers_.resize(nthreads);
         for (unsigned i = 0; i < nthreads; ++i) {
             KMerBuffer &entry = kmer_buffers_[i];
@@ -110,16 +165,105 @@ protected:
     }
 
     bool push_back_internal(const Seq &seq, unsigned thread_id) {
+        return push_back_to_bucket(seq, this->bucket_(seq), thread_id);
+    }
+
+    // Same as above, but the bucket is given by the precomputed segment hash
+    bool push_back_internal(const Seq &seq, uint64_t segment_hash, unsigned thread_id) {
+        return push_back_to_bucket(seq, this->bucket_.segment(segment_hash), thread_id);
+    }
+
+    bool push_back_to_bucket(const Seq &seq, size_t idx, unsigned thread_id) {
         VERIFY(thread_id < kmer_buffers_.size());
         KMerBuffer &entry = kmer_buffers_[thread_id];
 
-        size_t idx = this->bucket_(seq);
         entry[idx].push_back(seq);
         return entry[idx].size() > cell_size_;
     }
 
+    void WriteRun(const std::filesystem::path &file,
+                  const typename Seq::DataType *data, size_t el_data_size, size_t cnt) const {
+        std::vector<size_t> idx = { cnt };
+        std::vector<uint8_t> encoded;
+        if constexpr (std::is_unsigned<typename Seq::DataType>::value) {
+            if (this->raw_kmer_codec_ != RawKMerCodec::Plain) {
+                encoded = EncodeRawKMers(this->raw_kmer_codec_, data, cnt, el_data_size / sizeof(typename Seq::DataType));
+                idx.push_back(encoded.size());
+            }
+        }
+
+        // Write k-mers
+        FILE *f = fopen(file.c_str(), "ab");
+        if (!f)
+            FATAL_ERROR("Cannot open temporary file " << file << " for writing");
+        size_t res = (idx.size() > 1 ?
+                      fwrite(encoded.data(), 1, encoded.size(), f) == encoded.size() :
+                      fwrite(data, el_data_size, cnt, f) == cnt);
+        if (!res)
+            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+        fclose(f);
+
+        // Write index
+        f = fopen((file.native() + ".idx").c_str(), "ab");
+        if (!f)
+            FATAL_ERROR("Cannot open temporary file " << file << " for writing");
+        res = fwrite(idx.data(), sizeof(size_t), idx.size(), f);
+        if (res != idx.size())
+            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+        fclose(f);
+    }
+
+    void SpillMemoryKMers(const RawKMers &ostreams) {
+        INFO("Raw k-mers do not fit into memory limit, spilling them to disk");
+        auto &buckets = this->memory_kmers_;
+
+#   pragma omp parallel for schedule(dynamic)
+        for (size_t k = 0; k < num_files_; ++k) {
+            auto &bucket = buckets[k];
+            WriteRun(ostreams[k]->file(), bucket.data(), bucket.el_data_size(), SortUniqueKMers(bucket));
+        }
+
+        buckets.clear();
+        buckets.shrink_to_fit();
+        this->memory_limit_ = 0;
+    }
+
+    void DumpBuffersToMemory(const RawKMers &ostreams) {
+        auto &buckets = this->memory_kmers_;
+        size_t memory_used = 0;
+
+#   pragma omp parallel for reduction(+ : memory_used)
+        for (size_t k = 0; k < num_files_; ++k) {
+            auto &bucket = buckets[k];
+
+            // Sort and deduplicate the freshly collected cell in place at the
+            // end of the bucket, the whole bucket is deduplicated at the end.
+            size_t start = bucket.size();
+            for (auto & entry : kmer_buffers_) {
+                const auto &buffer = entry[k];
+                for (size_t j = 0; j < buffer.size(); ++j)
+                    bucket.push_back(buffer[j]);
+            }
+            size_t cnt = SortUniqueKMers<Seq>(bucket.data() + start * bucket.el_size(), bucket.size() - start, bucket.el_size());
+            bucket.shrink(start + cnt);
+
+            memory_used += bucket.capacity() * bucket.el_data_size();
+        }
+
+        for (auto & entry : kmer_buffers_)
+            for (auto & eentry : entry)
+                eentry.clear();
+
+        if (memory_used > this->memory_limit_)
+            SpillMemoryKMers(ostreams);
+    }
+
     void DumpBuffers(const RawKMers &ostreams) {
         VERIFY(ostreams.size() == num_files_ && kmer_buffers_[0].size() == num_files_);
+        if (this->in_memory()) {
+            DumpBuffersToMemory(ostreams);
+            return;
+        }
 
 #   pragma omp parallel for
         for (size_t k = 0; k < num_files_; ++k) {
@@ -135,30 +279,11 @@ protected:
                 for (size_t j = 0; j < buffer.size(); ++j)
                     SortBuffer.push_back(buffer[j]);
             }
-            pdqsort_pod(SortBuffer.data(), SortBuffer.data() + SortBuffer.size() * SortBuffer.el_size(), SortBuffer.el_size());
-            auto it = std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
+            size_t cnt = SortUniqueKMers(SortBuffer);
 
 #     pragma omp critical
             {
-                size_t cnt =  it - SortBuffer.begin();
-
-                // Write k-mers
-                FILE *f = fopen(ostreams[k]->file().c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                size_t res = fwrite(SortBuffer.data(), SortBuffer.el_data_size(), cnt, f);
-                if (res != cnt)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
-
-                // Write index
-                f = fopen((ostreams[k]->file().native() + ".idx").c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                res = fwrite(&cnt, sizeof(cnt), 1, f);
-                if (res != 1)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
+                WriteRun(ostreams[k]->file(), SortBuffer.data(), SortBuffer.el_data_size(), cnt);
             }
         }
 
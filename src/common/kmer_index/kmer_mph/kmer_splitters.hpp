@@ -9,6 +9,7 @@
 #pragma once
 
 #include "kmer_splitter.hpp"
+#include "kmer_segment_hash.hpp"
 #include "io/reads/read_stream_vector.hpp"
 #include "sequence/rtseq.hpp"
 #include "sequence/sequence.hpp"
@@ -25,40 +26,42 @@ class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
  protected:
   size_t read_buffer_size_;
  protected:
-  bool FillBufferFromSequence(const Sequence &seq,
+  // Buckets are assigned using the rolling segment hash, so the k-mer data is
+  // not rehashed for every position of the sequence
+  template<class Seq>
+  bool FillBufferFromSequence(const Seq &seq, RtSeq kmer,
                               unsigned thread_id) {
-      if (seq.size() < this->K_)
-        return false;
-
-      RtSeq kmer = seq.start<RtSeq>(this->K_) >> 'A';
+      kmer = kmer >> 'A';
+      kmer::RollingKMerHash hash(this->K_);
+      hash.reset(seq);
       bool stop = false;
       for (size_t j = this->K_ - 1; j < seq.size(); ++j) {
+        if (j >= this->K_)
+          hash.update(seq[j - this->K_], seq[j]);
         kmer <<= seq[j];
         if (!kmer_filter_.filter(kmer))
           continue;
 
-        stop |= this->push_back_internal(kmer, thread_id);
+        stop |= this->push_back_internal(kmer, hash.segment_hash(), thread_id);
       }
 
       return stop;
   }
 
-    bool FillBufferFromSequence(const RtSeq &seq,
-                                unsigned thread_id) {
+  bool FillBufferFromSequence(const Sequence &seq,
+                              unsigned thread_id) {
       if (seq.size() < this->K_)
         return false;
 
-      RtSeq kmer = seq.start(this->K_) >> 'A';
-      bool stop = false;
-      for (size_t j = this->K_ - 1; j < seq.size(); ++j) {
-        kmer <<= seq[j];
-        if (!kmer_filter_.filter(kmer))
-          continue;
+      return FillBufferFromSequence(seq, seq.start<RtSeq>(this->K_), thread_id);
+  }
 
-        stop |= this->push_back_internal(kmer, thread_id);
-      }
+  bool FillBufferFromSequence(const RtSeq &seq,
+                              unsigned thread_id) {
+      if (seq.size() < this->K_)
+        return false;
 
-      return stop;
+      return FillBufferFromSequence(seq, seq.start(this->K_), thread_id);
   }
 
  public:
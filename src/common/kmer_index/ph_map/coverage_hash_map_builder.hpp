@@ -7,6 +7,7 @@
 //***************************************************************************
 
 #include "perfect_hash_map_builder.hpp"
+#include "kmer_index/kmer_mph/kmer_segment_hash.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 #include "sequence/sequence.hpp"
 #include <cstdlib>
@@ -28,9 +29,17 @@ struct CoverageHashMapBuilder : public PerfectHashMapBuilder {
                 continue;
 
             typename Index::KeyWithHash kwh = index.ConstructKWH(seq.start<Kmer>(k) >> 'A');
+            kmer::RollingKMerHash hash(k);
+            hash.reset(seq);
             for (size_t j = k - 1; j < seq.size(); ++j) {
+                if (j >= k)
+                    hash.update(seq[j - k], seq[j]);
                 kwh <<= seq[j];
-                if (!kwh.is_minimal() || !index.valid(kwh))
+                if (!kwh.is_minimal())
+                    continue;
+
+                index.CountIdx(kwh, hash);
+                if (!index.valid(kwh))
                     continue;
 
 #                   pragma omp atomic
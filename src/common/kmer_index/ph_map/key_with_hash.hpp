@@ -48,6 +48,17 @@ public:
         return idx_;
     }
 
+    // The key which is passed to the hash function
+    const Key &hashed_key() const {
+        return key_;
+    }
+
+    // Sets the precomputed result of hash_.seq_idx(hashed_key())
+    void set_idx(IdxType idx) const {
+        ready_ = true;
+        idx_ = idx;
+    }
+
     SimpleKeyWithHash(const SimpleKeyWithHash &that) noexcept = default;
     SimpleKeyWithHash &operator=(const SimpleKeyWithHash &that) noexcept {
         if (this == &that)
@@ -159,6 +170,18 @@ private:
         return ready_;
     }
 
+    // The key which is passed to the hash function
+    Key hashed_key() const {
+        return is_minimal() ? key_ : !key_;
+    }
+
+    // Sets the precomputed result of hash_.seq_idx(hashed_key())
+    void set_idx(IdxType idx) const {
+        is_minimal_ = is_minimal();
+        ready_ = true;
+        idx_ = idx;
+    }
+
     InvertableKeyWithHash(const InvertableKeyWithHash &that) noexcept = default;
     InvertableKeyWithHash &operator=(const InvertableKeyWithHash &that) noexcept {
         this->key_= that.key_;
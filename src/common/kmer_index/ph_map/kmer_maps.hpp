@@ -91,6 +91,15 @@ public:
         return (typename traits_t::raw_create()(this->k(), *it));
     }
 
+    // Batched ConstructKWH, the stored keys are prefetched as well
+    void ConstructKWH(const KMer *keys, size_t n, std::vector<KeyWithHash> &kwhs) const {
+        base::ConstructKWH(keys, n, kwhs);
+        for (const auto &kwh : kwhs) {
+            if (base::valid(kwh))
+                __builtin_prefetch(&(*kmers_)[kwh.idx()]);
+        }
+    }
+
     void clear() {
         base::clear();
         kmers_.reset(nullptr);
@@ -16,6 +16,8 @@
 #include "io/binary/binary.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <cstdlib>
 
@@ -74,12 +76,24 @@ public:
         io::binary::BinRead(reader, k_);
         index_ptr_->deserialize(reader);
     }
+
+    void BinWriteMapped(std::ostream &os) const {
+        mmapped::write(os, uint64_t(k_));
+        index_ptr_->serialize_mapped(os);
+    }
+
+    void BinMap(const uint8_t *&data, const uint8_t *end, std::shared_ptr<void> holder) {
+        clear();
+        k_ = unsigned(mmapped::read<uint64_t>(data, end));
+        index_ptr_->map(data, end, std::move(holder));
+    }
 };
 
 template<class K, class V,
          class traits = kmers::kmer_index_traits<K>, class StoringType = SimpleStoring,
          class Container = std::vector<V>>
 class PerfectHashMap : public IndexWrapper<K, traits> {
+    static constexpr size_t LOOKUP_BATCH_SIZE = 16;
 public:
     typedef size_t IdxType;
     typedef K KeyType;
@@ -100,6 +114,39 @@ public:
         return KeyWithHash(key, *index_ptr_);
     }
 
+    // Computes the index of the key with the segment of the index determined
+    // from the rolling hash of the key (see kmer::RollingKMerHash), so only
+    // the perfect hash of the key has to be computed.
+    template<class RollingHash>
+    void CountIdx(const KeyWithHash &kwh, const RollingHash &hash) const {
+        kwh.set_idx(index_ptr_->seq_idx(kwh.hashed_key(), hash.segment_hash(kwh.is_minimal())));
+    }
+
+    // Batched ConstructKWH with indices computed in advance. Lookups are done
+    // by groups: all the keys of the group are hashed before any of them is
+    // resolved and then the value slots are prefetched, so the random memory
+    // accesses for the different keys overlap.
+    void ConstructKWH(const KeyType *keys, size_t n, std::vector<KeyWithHash> &kwhs) const {
+        kwhs.clear();
+        kwhs.reserve(n);
+
+        std::array<typename KMerIndexT::KMerHash, LOOKUP_BATCH_SIZE> hashes;
+        for (size_t start = 0; start < n; start += LOOKUP_BATCH_SIZE) {
+            size_t cnt = std::min(LOOKUP_BATCH_SIZE, n - start);
+            for (size_t i = 0; i < cnt; ++i) {
+                kwhs.push_back(ConstructKWH(keys[start + i]));
+                hashes[i] = index_ptr_->seq_hash(kwhs.back().hashed_key());
+            }
+
+            for (size_t i = 0; i < cnt; ++i) {
+                size_t idx = index_ptr_->seq_idx(hashes[i]);
+                kwhs[start + i].set_idx(idx);
+                if (KeyBase::valid(idx))
+                    __builtin_prefetch(&data_[idx]);
+            }
+        }
+    }
+
     bool valid(const KeyWithHash &kwh) const {
         return KeyBase::valid(kwh.idx());
     }
@@ -148,6 +195,31 @@ public:
         KeyBase::BinRead(reader);
     }
 
+    // Layout which is used in place by BinMap(): the index followed by the
+    // raw values
+    void BinWriteMapped(std::ostream &os) const {
+        static_assert(std::is_trivially_copyable<V>::value, "only trivially copyable values could be mapped");
+        KeyBase::BinWriteMapped(os);
+        mmapped::align(os);
+        mmapped::write(os, uint64_t(data_.size()));
+        mmapped::write(os, uint64_t(sizeof(V)));
+        os.write(raw_data(), raw_size());
+    }
+
+    // Uses the index and the values saved by BinWriteMapped() in place (the
+    // values are copied on write), requires the container supporting
+    // attach(). The mapping ends at end and is kept alive by the holder.
+    void BinMap(const uint8_t *&data, const uint8_t *end, std::shared_ptr<void> holder) {
+        KeyBase::BinMap(data, end, holder);
+        mmapped::align(data);
+        size_t sz = mmapped::read<uint64_t>(data, end);
+        size_t value_size = mmapped::read<uint64_t>(data, end);
+        CHECK_FATAL_ERROR(value_size == sizeof(V), "Incompatible values of the mapped k-mer index");
+        mmapped::check(data, end, sz, sizeof(V));
+        data_.attach(reinterpret_cast<V*>(const_cast<uint8_t*>(data)), sz, std::move(holder));
+        data += sz * sizeof(V);
+    }
+
     size_t size() const {
         return data_.size();
     }
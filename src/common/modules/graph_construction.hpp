@@ -51,7 +51,12 @@ KMerFiles ConstructGraphUsingExtensionIndex(const config::debruijn_config::const
     TRACE("... in parallel");
     kmers::DeBruijnExtensionIndex<> ext(k);
 
-    KMerFiles kmers = kmers::DeBruijnExtensionIndexBuilder().BuildExtensionIndexFromStream(workdir, ext, streams, params.read_buffer_size);
+    KMerFiles kmers = kmers::DeBruijnExtensionIndexBuilder().BuildExtensionIndexFromStream(workdir, ext, streams,
+                                                                                   params.read_buffer_size,
+                                                                                   params.in_memory_counting,
+                                                                                   params.compress_raw_kmers ?
+                                                                                   kmers::RawKMerCodec::DeltaZlib :
+                                                                                   kmers::RawKMerCodec::Plain);
 
     EarlyClipTips(params, ext);
 
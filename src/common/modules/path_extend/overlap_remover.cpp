@@ -8,12 +8,113 @@
 #include "overlap_remover.hpp"
 #include "path_extender.hpp" // FIXME: Temporary
 
+#include "utils/parallel/openmp_wrapper.h"
+
 namespace path_extend {
 
 static void PopFront(BidirectionalPath &path, size_t cnt) {
     path.GetConjPath()->PopBack(cnt);
 }
 
+// Polynomial hashing modulo the Mersenne prime 2^61 - 1
+static const uint64_t HASH_MOD = (uint64_t(1) << 61) - 1;
+static const uint64_t HASH_BASE = 0x1f3d5b79a2c4e687ULL % HASH_MOD;
+
+static uint64_t MulMod(uint64_t a, uint64_t b) {
+    __uint128_t prod = __uint128_t(a) * b;
+    uint64_t res = uint64_t(prod & HASH_MOD) + uint64_t(prod >> 61);
+    return res >= HASH_MOD ? res - HASH_MOD : res;
+}
+
+static uint64_t EdgeHash(EdgeId e, int gap) {
+    uint64_t h = e.int_id() * 0x9E3779B97F4A7C15ULL ^ uint32_t(gap);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 29;
+    return h % HASH_MOD;
+}
+
+PathSequenceIndex::PathSequenceIndex(const PathContainer &paths) {
+    std::vector<const BidirectionalPath*> indexed;
+    size_t max_size = 0;
+    for (const auto &path_pair : paths) {
+        for (const BidirectionalPath *path : { path_pair.first.get(), path_pair.second.get() }) {
+            bool regular = true;
+            for (size_t i = 0; i < path->Size() && regular; ++i)
+                regular = path->ShiftLength(i) != 0;
+            if (!regular)
+                continue;
+
+            indexed.push_back(path);
+            max_size = std::max(max_size, path->Size());
+        }
+    }
+
+    powers_.resize(max_size + 1);
+    powers_[0] = 1;
+    for (size_t i = 1; i < powers_.size(); ++i)
+        powers_[i] = MulMod(powers_[i - 1], HASH_BASE);
+
+    entries_.reserve(indexed.size());
+    std::vector<Entry*> entries;
+    for (const BidirectionalPath *path : indexed)
+        entries.push_back(&entries_[path]);
+
+#   pragma omp parallel for schedule(guided)
+    for (size_t i = 0; i < indexed.size(); ++i) {
+        const BidirectionalPath &path = *indexed[i];
+        Entry &entry = *entries[i];
+        entry.positions.reserve(path.Size());
+        entry.prefix_hash.resize(path.Size() + 1);
+        entry.prefix_hash[0] = 0;
+        for (size_t j = 0; j < path.Size(); ++j) {
+            entry.positions.emplace_back(path.At(j).int_id(), j);
+            uint64_t h = MulMod(entry.prefix_hash[j], HASH_BASE) + EdgeHash(path.At(j), path.GapAt(j).gap);
+            entry.prefix_hash[j + 1] = h >= HASH_MOD ? h - HASH_MOD : h;
+        }
+        std::sort(entry.positions.begin(), entry.positions.end());
+    }
+}
+
+uint64_t PathSequenceIndex::Hash(const Entry &entry, size_t from, size_t to) const {
+    uint64_t prefix = MulMod(entry.prefix_hash[from], powers_[to - from]);
+    uint64_t h = entry.prefix_hash[to] + HASH_MOD - prefix;
+    return h >= HASH_MOD ? h - HASH_MOD : h;
+}
+
+std::vector<size_t> PathSequenceIndex::Positions(const BidirectionalPath &path, EdgeId e) const {
+    const auto &positions = Get(path).positions;
+    auto it = std::lower_bound(positions.begin(), positions.end(), std::make_pair(e.int_id(), size_t(0)));
+    std::vector<size_t> answer;
+    for (; it != positions.end() && it->first == e.int_id(); ++it)
+        answer.push_back(it->second);
+    return answer;
+}
+
+bool PathSequenceIndex::Matches(const BidirectionalPath &path1,
+                                const BidirectionalPath &path2, size_t pos2, size_t len) const {
+    VERIFY(len > 0 && len <= path1.Size() && pos2 + len <= path2.Size());
+    return path1.At(0) == path2.At(pos2) &&
+           Hash(Get(path1), 1, len) == Hash(Get(path2), pos2 + 1, pos2 + len);
+}
+
+size_t PathSequenceIndex::CommonPrefix(const BidirectionalPath &path1,
+                                       const BidirectionalPath &path2, size_t pos2) const {
+    if (path1.Empty() || path1.At(0) != path2.At(pos2))
+        return 0;
+
+    const Entry &entry1 = Get(path1), &entry2 = Get(path2);
+    size_t lo = 1, hi = std::min(path1.Size(), path2.Size() - pos2);
+    while (lo < hi) {
+        size_t mid = (lo + hi + 1) / 2;
+        if (Hash(entry1, 1, mid) == Hash(entry2, pos2 + 1, pos2 + mid))
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return lo;
+}
+
 std::pair<Range, Range> OverlapFindingHelper::ComparePaths(const BidirectionalPath &path1,
                                                            const BidirectionalPath &path2,
                                                            size_t start2) const {
@@ -74,6 +175,15 @@ std::pair<Range, Range> OverlapFindingHelper::ComparePaths(const BidirectionalPa
 
 bool OverlapFindingHelper::IsSubpath(const BidirectionalPath &path,
                                      const BidirectionalPath &other) const {
+    if (Indexed(path, other)) {
+        for (size_t pos : index_->Positions(other, path.Front())) {
+            if (pos + path.Size() <= other.Size() &&
+                index_->Matches(path, other, pos, path.Size()))
+                return true;
+        }
+        return false;
+    }
+
     for (size_t j = 0; j < other.Size(); ++j) {
         auto range_pair = ComparePaths(path, other, j);
         if (range_pair.first.end_pos == path.Size()) {
@@ -86,6 +196,9 @@ bool OverlapFindingHelper::IsSubpath(const BidirectionalPath &path,
 //NB! Equality is not transitive if max_diff is > 0
 bool OverlapFindingHelper::IsEqual(const BidirectionalPath &path,
                                    const BidirectionalPath &other) const {
+    if (Indexed(path, other))
+        return path.Size() == other.Size() && index_->Matches(path, other, 0, path.Size());
+
     auto ends_pair = CommonPrefix(path, other);
     return ends_pair.first == path.Size() && ends_pair.second == other.Size();
 }
@@ -119,6 +232,23 @@ std::pair<Range, Range> OverlapFindingHelper::FindOverlap(const BidirectionalPat
                                                           bool end_start_only) const {
     size_t max_overlap = 0;
     std::pair<Range, Range> matching_ranges;
+    if (Indexed(path1, path2)) {
+        //only the positions of the first edge could give the overlap
+        for (size_t j : index_->Positions(path2, path1.Front())) {
+            size_t overlap_size = index_->CommonPrefix(path1, path2, j);
+            bool till_end = (j + overlap_size == path2.Size());
+            if (end_start_only && !till_end)
+                continue;
+
+            if (overlap_size > max_overlap ||
+                (overlap_size == max_overlap && till_end)) {
+                max_overlap = overlap_size;
+                matching_ranges = {Range(0, overlap_size), Range(j, j + overlap_size)};
+            }
+        }
+        return matching_ranges;
+    }
+
     for (size_t j = 0; j < path2.Size(); ++j) {
         auto range_pair = ComparePaths(path1, path2, j);
         VERIFY(range_pair.first.start_pos == 0);
@@ -155,9 +285,8 @@ std::vector<const BidirectionalPath*> OverlapFindingHelper::FindCandidatePaths(c
 }
 
 size_t OverlapRemover::AnalyzeOverlaps(const BidirectionalPath &path, const BidirectionalPath &other,
-                                       bool end_start_only, bool retain_one_copy) const {
-    VERIFY(!retain_one_copy || !end_start_only);
-    auto range_pair = helper_.FindOverlap(path, other, end_start_only);
+                                       const std::pair<Range, Range> &range_pair,
+                                       bool retain_one_copy) const {
     size_t overlap = range_pair.first.size();
     auto other_range = range_pair.second;
 
@@ -194,11 +323,23 @@ size_t OverlapRemover::AnalyzeOverlaps(const BidirectionalPath &path, const Bidi
     return overlap;
 }
 
-void OverlapRemover::MarkStartOverlaps(const BidirectionalPath &path, bool end_start_only, bool retain_one_copy) {
-    std::set<size_t> overlap_poss;
+OverlapRemover::Overlaps OverlapRemover::FindStartOverlaps(const BidirectionalPath &path,
+                                                           bool end_start_only) const {
+    Overlaps overlaps;
     for (const BidirectionalPath *candidate : helper_.FindCandidatePaths(path)) {
-        size_t overlap = AnalyzeOverlaps(path, *candidate,
-                                         end_start_only, retain_one_copy);
+        auto range_pair = helper_.FindOverlap(path, *candidate, end_start_only);
+        if (range_pair.first.size() > 0)
+            overlaps.emplace_back(candidate, range_pair);
+    }
+    return overlaps;
+}
+
+void OverlapRemover::MarkStartOverlaps(const BidirectionalPath &path, const Overlaps &overlaps,
+                                       bool retain_one_copy) {
+    std::set<size_t> overlap_poss;
+    for (const auto &candidate_overlap : overlaps) {
+        size_t overlap = AnalyzeOverlaps(path, *candidate_overlap.first,
+                                         candidate_overlap.second, retain_one_copy);
         if (overlap > 0)
             overlap_poss.insert(overlap);
     }
@@ -209,6 +350,23 @@ void OverlapRemover::MarkStartOverlaps(const BidirectionalPath &path, bool end_s
 }
 
 void OverlapRemover::InnerMarkOverlaps(bool end_start_only, bool retain_one_copy) {
+    VERIFY(!retain_one_copy || !end_start_only);
+    //The overlaps are found in parallel, the splits depend on the ones
+    //already marked, so they are marked in order of the paths
+    std::vector<const BidirectionalPath*> paths;
+    for (const auto &path_pair : paths_) {
+        if (path_pair.first->Size() > 0 && !path_pair.first->IsCycle()) {
+            paths.push_back(path_pair.first.get());
+            paths.push_back(path_pair.second.get());
+        }
+    }
+
+    std::vector<Overlaps> overlaps(paths.size());
+#   pragma omp parallel for schedule(guided)
+    for (size_t i = 0; i < paths.size(); ++i)
+        overlaps[i] = FindStartOverlaps(*paths[i], end_start_only);
+
+    size_t i = 0;
     for (auto &path_pair : paths_) {
         //TODO think if this "optimization" is necessary
         if (path_pair.first->Size() == 0)
@@ -220,8 +378,9 @@ void OverlapRemover::InnerMarkOverlaps(bool end_start_only, bool retain_one_copy
             if (overlapping > 0)
                 splits_[path_pair.first->GetId()].insert(overlapping);
         } else {
-            MarkStartOverlaps(*path_pair.first, end_start_only, retain_one_copy);
-            MarkStartOverlaps(*path_pair.second, end_start_only, retain_one_copy);
+            VERIFY(paths[i] == path_pair.first.get());
+            MarkStartOverlaps(*path_pair.first, overlaps[i++], retain_one_copy);
+            MarkStartOverlaps(*path_pair.second, overlaps[i++], retain_one_copy);
         }
     }
 }
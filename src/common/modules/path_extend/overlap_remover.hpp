@@ -11,12 +11,60 @@
 #include "assembly_graph/paths/bidirectional_path.hpp"
 #include "sequence/range.hpp"
 
+#include "parallel_hashmap/phmap.h"
+
+#include <memory>
+
 namespace path_extend {
 
 class GraphCoverageMap;
 class PathContainer;
 typedef std::unordered_map<uint64_t, std::set<size_t>> SplitsStorage;
 
+// Index of the edge sequences of the paths for the exact (max_diff = 0)
+// comparison. Keeps the positions of the edges of every path and the
+// polynomial hashes of its prefixes (edges together with the gaps), so the
+// common prefix of two paths is found by a binary search over the hashes
+// instead of the edge by edge comparison. The paths should not be changed
+// while the index is used.
+class PathSequenceIndex {
+    struct Entry {
+        // (edge id, position), sorted
+        std::vector<std::pair<uint64_t, size_t>> positions;
+        std::vector<uint64_t> prefix_hash;
+    };
+
+    phmap::flat_hash_map<const BidirectionalPath*, Entry> entries_;
+    std::vector<uint64_t> powers_;
+
+    // Hash of the edges [from, to) of the path together with the gaps before them
+    uint64_t Hash(const Entry &entry, size_t from, size_t to) const;
+    const Entry &Get(const BidirectionalPath &path) const {
+        return entries_.find(&path)->second;
+    }
+
+public:
+    explicit PathSequenceIndex(const PathContainer &paths);
+
+    // The paths with zero shift lengths are not indexed: edges could be
+    // skipped while comparing them, see OverlapFindingHelper::ComparePaths()
+    bool contains(const BidirectionalPath &path) const {
+        return entries_.count(&path);
+    }
+
+    // Positions of the edge in the path in increasing order
+    std::vector<size_t> Positions(const BidirectionalPath &path, debruijn_graph::EdgeId e) const;
+
+    // Checks if first len edges of path1 coincide with the ones of path2
+    // starting from pos2. The gap before the first edge is not compared.
+    bool Matches(const BidirectionalPath &path1,
+                 const BidirectionalPath &path2, size_t pos2, size_t len) const;
+
+    // Longest len such that Matches(path1, path2, pos2, len)
+    size_t CommonPrefix(const BidirectionalPath &path1,
+                        const BidirectionalPath &path2, size_t pos2) const;
+};
+
 //TODO think about symmetry and what if it breaks?
 class OverlapFindingHelper {
     const debruijn_graph::Graph &g_;
@@ -24,6 +72,11 @@ class OverlapFindingHelper {
     const size_t min_edge_len_;
     const size_t max_diff_;
     const bool try_extend_;
+    std::unique_ptr<const PathSequenceIndex> index_;
+
+    bool Indexed(const BidirectionalPath &path1, const BidirectionalPath &path2) const {
+        return index_ && !path1.Empty() && index_->contains(path1) && index_->contains(path2);
+    }
 
     //TODO think of the cases when (gap + length) < 0
     //Changes second argument on success
@@ -43,16 +96,21 @@ class OverlapFindingHelper {
                                          const BidirectionalPath &path2,
                                          size_t start2) const;
 public:
+    //If paths are provided and max_diff is 0, the comparison of the paths
+    //from the container is done via PathSequenceIndex
     OverlapFindingHelper(const debruijn_graph::Graph &g,
                          const GraphCoverageMap &coverage_map,
                          size_t min_edge_len,
-                         size_t max_diff) :
+                         size_t max_diff,
+                         const PathContainer *paths = nullptr) :
             g_(g),
             coverage_map_(coverage_map),
             min_edge_len_(min_edge_len),
             max_diff_(max_diff),
             //had to enable try_extend, otherwise equality lost symmetry
             try_extend_(max_diff_ > 0) {
+        if (paths && max_diff_ == 0)
+            index_ = std::make_unique<const PathSequenceIndex>(*paths);
     }
 
     bool IsSubpath(const BidirectionalPath &path,
@@ -94,10 +152,15 @@ class OverlapRemover {
         return false;
     }
 
+    typedef std::vector<std::pair<const BidirectionalPath*, std::pair<Range, Range>>> Overlaps;
+
     //NB! This can only be launched over paths taken from path container!
     size_t AnalyzeOverlaps(const BidirectionalPath &path, const BidirectionalPath &other,
-                           bool end_start_only, bool retain_one_copy) const;
-    void MarkStartOverlaps(const BidirectionalPath &path, bool end_start_only, bool retain_one_copy);
+                           const std::pair<Range, Range> &range_pair,
+                           bool retain_one_copy) const;
+    Overlaps FindStartOverlaps(const BidirectionalPath &path, bool end_start_only) const;
+    void MarkStartOverlaps(const BidirectionalPath &path, const Overlaps &overlaps,
+                           bool retain_one_copy);
     void InnerMarkOverlaps(bool end_start_only, bool retain_one_copy);
 
 public:
@@ -108,7 +171,7 @@ public:
                    size_t max_diff) // = 0)
             :  paths_(paths),
                helper_(g, coverage_map,
-                       min_edge_len, max_diff) {
+                       min_edge_len, max_diff, &paths) {
     }
 
     //Note that during start/end removal all repeat instance have to be cut
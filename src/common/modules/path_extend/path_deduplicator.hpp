@@ -18,8 +18,10 @@ class PathDeduplicator {
     const bool equal_only_;
     const OverlapFindingHelper helper_;
 
-    bool IsRedundant(const BidirectionalPath &path) const {
+    //Paths containing the given one
+    std::vector<const BidirectionalPath*> FindContainers(const BidirectionalPath &path) const {
         TRACE("Checking if path redundant " << path.GetId());
+        std::vector<const BidirectionalPath*> containers;
         for (const BidirectionalPath *candidate : helper_.FindCandidatePaths(path)) {
             TRACE("Considering candidate " << candidate->GetId());
 //                VERIFY(candidate != path && candidate != path->GetConjPath());
@@ -28,9 +30,9 @@ class PathDeduplicator {
                 continue;
 
             if (equal_only_ ? helper_.IsEqual(path, *candidate) : helper_.IsSubpath(path, *candidate))
-                return true;
+                containers.push_back(candidate);
         }
-        return false;
+        return containers;
     }
 public:
     PathDeduplicator(const Graph &g,
@@ -41,13 +43,27 @@ public:
                      bool equal_only) :
             paths_(paths),
             equal_only_(equal_only),
-            helper_(g, coverage_map, min_edge_len, max_diff) {}
+            helper_(g, coverage_map, min_edge_len, max_diff, &paths) {}
 
     //TODO use path container filtering?
+    //The containers are found in parallel. The path is redundant if one of
+    //its containers has not been cleared before, so the paths are cleared
+    //in order
     void Deduplicate() {
-        for (auto & path_pair : paths_) {
-            auto &path = path_pair.first;
-            if (IsRedundant(*path)) {
+        std::vector<BidirectionalPath*> paths;
+        for (auto & path_pair : paths_)
+            paths.push_back(path_pair.first.get());
+
+        std::vector<std::vector<const BidirectionalPath*>> containers(paths.size());
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < paths.size(); ++i)
+            containers[i] = FindContainers(*paths[i]);
+
+        for (size_t i = 0; i < paths.size(); ++i) {
+            auto &path = paths[i];
+            bool redundant = std::any_of(containers[i].begin(), containers[i].end(),
+                                         [](const BidirectionalPath *container) { return !container->Empty(); });
+            if (redundant) {
                 TRACE("Clearing path " << path->str());
                 path->Clear();
             }
@@ -17,6 +17,8 @@
 #include "assembly_graph/graph_support/detail_coverage.hpp"
 
 #include <cmath>
+#include <functional>
+#include <memory>
 
 namespace path_extend {
 
@@ -353,7 +355,7 @@ public:
     bool InExistingLoop(const BidirectionalPath& path) {
         DEBUG("Checking existing loops");
         for (const auto &entry : visited_cycles_coverage_map_.GetEdgePaths(path.Back())) {
-            const BidirectionalPath &cycle = *entry.first;
+            const BidirectionalPath &cycle = *entry.path;
             DEBUG("checking  cycle ");
             int pos = path.FindLast(cycle);
             if (pos == -1)
@@ -407,6 +409,24 @@ public:
         DEBUG("add cycle");
         p.first.PrintDEBUG();
     }
+
+    size_t cycles_count() const {
+        return path_storage_.size();
+    }
+
+    // Makes the visited cycles the same as of the other detector
+    void CopyCycles(const InsertSizeLoopDetector &other) {
+        for (auto it = path_storage_.begin(); it != path_storage_.end(); ++it) {
+            visited_cycles_coverage_map_.Remove(it.get());
+            visited_cycles_coverage_map_.Remove(it.getConjugate());
+        }
+        path_storage_.clear();
+        for (auto it = other.path_storage_.begin(); it != other.path_storage_.end(); ++it) {
+            auto p = path_storage_.AddPair(BidirectionalPath::clone(it.get()),
+                                           BidirectionalPath::clone(it.getConjugate()));
+            visited_cycles_coverage_map_.Subscribe(p);
+        }
+    }
 };
 
 class PathExtender {
@@ -417,6 +437,12 @@ public:
     virtual ~PathExtender() = default;
     virtual bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage = nullptr) = 0;
 
+    // The state carried by the extender from one path to another (besides the
+    // coverage map and the used edges). Version is changed on every update
+    virtual size_t SharedStateVersion() const { return 0; }
+    // Makes the state the same as of the other extender of the same kind
+    virtual void SyncSharedState(const PathExtender &/*other*/) {}
+
 protected:
     const Graph &g_;
     DECL_LOGGER("PathExtender")
@@ -424,29 +450,81 @@ protected:
 
 
 class CompositeExtender {
+public:
+    typedef std::vector<std::shared_ptr<PathExtender>> Extenders;
+    // Creates the extenders working against the given coverage map and used
+    // edge storage. The extenders should be the same as the main ones.
+    typedef std::function<Extenders(const GraphCoverageMap&, UsedUniqueStorage&)> ExtendersFactory;
+
 private:
-    bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage);
+    // Thread-local state for the speculative seed extension
+    struct Worker {
+        Worker(const Graph &g, const UsedUniqueStorage &used_storage)
+                : cover_map(g), used_storage(&used_storage) {}
+
+        GraphCoverageMap cover_map;
+        UsedUniqueStorage used_storage;
+        Extenders extenders;
+    };
+
+    struct Speculation;
+
+    static bool MakeGrowStep(const Extenders &extenders, BidirectionalPath& path, PathContainer* paths_storage);
+    static void GrowPath(const Extenders &extenders, BidirectionalPath& path, PathContainer* paths_storage) {
+        while (MakeGrowStep(extenders, path, paths_storage)) { }
+    }
+    static size_t SharedStateVersion(const Extenders &extenders);
+
+    bool IsSeedUsed(const BidirectionalPath &seed, UsedUniqueStorage &used_storage) const;
+    void GrowSeed(const Extenders &extenders, BidirectionalPath &path, PathContainer &result) const;
+    void ExtendSeed(const BidirectionalPath &seed, PathContainer &result);
+    void ReportProgress(size_t i, size_t total) const;
+
+    void Speculate(Worker &worker, const BidirectionalPath &seed, size_t version, Speculation &speculation) const;
+    void Commit(Speculation &speculation, PathContainer &result);
+
     void GrowAllPaths(PathContainer& paths, PathContainer& result);
+    void GrowAllPathsParallel(PathContainer& paths, PathContainer& result);
 
 public:
     CompositeExtender(const Graph &g, GraphCoverageMap& cov_map,
                       UsedUniqueStorage &unique,
-                      const std::vector<std::shared_ptr<PathExtender>> &pes)
+                      const Extenders &pes)
             : g_(g),
               cover_map_(cov_map),
               used_storage_(unique),
               extenders_(pes) {}
 
+    // Seeds are grown speculatively by the threads each with its own
+    // extenders. The results are committed in the order of seeds, the
+    // extensions made against the outdated state are redone, so the paths
+    // are the same as grown by the serial version.
+    CompositeExtender(const Graph &g, GraphCoverageMap& cov_map,
+                      UsedUniqueStorage &unique,
+                      const Extenders &pes,
+                      const ExtendersFactory &factory, size_t threads)
+            : CompositeExtender(g, cov_map, unique, pes) {
+        for (size_t i = 0; threads > 1 && i < threads; ++i) {
+            workers_.push_back(std::make_unique<Worker>(g, used_storage_));
+            workers_.back()->extenders = factory(workers_.back()->cover_map,
+                                                 workers_.back()->used_storage);
+            VERIFY(workers_.back()->extenders.size() == extenders_.size());
+        }
+    }
+
     void GrowAll(PathContainer& paths, PathContainer& result);
     void GrowPath(BidirectionalPath& path, PathContainer* paths_storage) {
-        while (MakeGrowStep(path, paths_storage)) { }
+        GrowPath(extenders_, path, paths_storage);
     }
 
 private:
     const Graph &g_;
     GraphCoverageMap &cover_map_;
     UsedUniqueStorage &used_storage_;
-    std::vector<std::shared_ptr<PathExtender>> extenders_;
+    Extenders extenders_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    DECL_LOGGER("CompositeExtender");
 };
 
 
@@ -496,6 +574,14 @@ public:
     bool TryToResolveHairpin(BidirectionalPath& path);
     bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage) override;
 
+    size_t SharedStateVersion() const override {
+        return is_detector_.cycles_count();
+    }
+
+    void SyncSharedState(const PathExtender &other) override {
+        is_detector_.CopyCycles(dynamic_cast<const LoopDetectingPathExtender&>(other).is_detector_);
+    }
+
 private:
     bool ResolveShortLoop(BidirectionalPath& p) {
         if (use_short_loop_cov_resolver_) {
@@ -7,21 +7,38 @@
 
 #include "path_extender.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <unordered_map>
+
 namespace path_extend {
 
+struct CompositeExtender::Speculation {
+    bool grown = false;
+    // The shared state of the extenders was outdated or modified
+    bool dirty = false;
+    UsedUniqueStorage::Claims claims;
+    // The grown path followed by the paths created during the growth
+    PathContainer paths;
+};
+
 void CompositeExtender::GrowAll(PathContainer& paths, PathContainer& result) {
     result.clear();
-    GrowAllPaths(paths, result);
+    if (workers_.empty())
+        GrowAllPaths(paths, result);
+    else
+        GrowAllPathsParallel(paths, result);
     result.FilterEmptyPaths();
 }
 
-bool CompositeExtender::MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage) {
+bool CompositeExtender::MakeGrowStep(const Extenders &extenders, BidirectionalPath& path,
+                                     PathContainer* paths_storage) {
     DEBUG("make grow step composite extender");
 
     size_t current = 0;
-    while (current < extenders_.size()) {
-        DEBUG("step " << current << " of total " << extenders_.size());
-        if (extenders_[current]->MakeGrowStep(path, paths_storage)) {
+    while (current < extenders.size()) {
+        DEBUG("step " << current << " of total " << extenders.size());
+        if (extenders[current]->MakeGrowStep(path, paths_storage)) {
             return true;
         }
         ++current;
@@ -29,50 +46,147 @@ bool CompositeExtender::MakeGrowStep(BidirectionalPath& path, PathContainer* pat
     return false;
 }
 
+size_t CompositeExtender::SharedStateVersion(const Extenders &extenders) {
+    size_t version = 0;
+    for (const auto &extender : extenders)
+        version += extender->SharedStateVersion();
+    return version;
+}
+
+//In 2015 modes do not use a seed already used in paths.
+//FIXME what is the logic here?
+bool CompositeExtender::IsSeedUsed(const BidirectionalPath &seed, UsedUniqueStorage &used_storage) const {
+    if (!used_storage.UniqueCheckEnabled())
+        return false;
+
+    for (size_t ind =0; ind < seed.Size(); ind++) {
+        EdgeId eid = seed.At(ind);
+        auto path_id = seed.GetId();
+        if (used_storage.IsUsedAndUnique(eid, path_id)) {
+            DEBUG("Used edge " << g_.int_id(eid));
+            return true;
+        } else {
+            used_storage.insert(eid, path_id);
+        }
+    }
+    return false;
+}
+
+void CompositeExtender::GrowSeed(const Extenders &extenders, BidirectionalPath &path, PathContainer &result) const {
+    size_t count_trying = 0;
+    size_t current_path_len = 0;
+    do {
+        current_path_len = path.Length();
+        count_trying++;
+        GrowPath(extenders, path, &result);
+        GrowPath(extenders, *path.GetConjPath(), &result);
+    } while (count_trying < 10 && (path.Length() != current_path_len));
+    DEBUG("result path " << path.GetId());
+    path.PrintDEBUG();
+}
+
+void CompositeExtender::ReportProgress(size_t i, size_t total) const {
+    VERBOSE_POWER_T2(i, 100, "Processed " << i << " paths from " << total << " (" << i * 100 / total << "%)");
+    if (total > 10 && i % (total / 10 + 1) == 0) {
+        INFO("Processed " << i << " paths from " << total << " (" << i * 100 / total << "%)");
+    }
+}
+
+void CompositeExtender::ExtendSeed(const BidirectionalPath &seed, PathContainer &result) {
+    if (IsSeedUsed(seed, used_storage_)) {
+        DEBUG("skipping already used seed");
+        return;
+    }
+
+    if (!cover_map_.IsCovered(seed)) {
+        BidirectionalPath &path = CreatePath(result, cover_map_, seed);
+        GrowSeed(extenders_, path, result);
+    }
+}
+
 void CompositeExtender::GrowAllPaths(PathContainer& paths, PathContainer& result) {
     for (size_t i = 0; i < paths.size(); ++i) {
-        VERBOSE_POWER_T2(i, 100, "Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
-        if (paths.size() > 10 && i % (paths.size() / 10 + 1) == 0) {
-            INFO("Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
+        ReportProgress(i, paths.size());
+        ExtendSeed(paths.Get(i), result);
+    }
+}
+
+void CompositeExtender::Speculate(Worker &worker, const BidirectionalPath &seed, size_t version,
+                                  Speculation &speculation) const {
+    // The worker state differs from the committed one after the failed speculations
+    speculation.dirty = SharedStateVersion(worker.extenders) != version;
+    // Coverage by the committed paths could only increase, so the covered seed is skipped for sure
+    if (!IsSeedUsed(seed, worker.used_storage) && !cover_map_.IsCovered(seed)) {
+        BidirectionalPath &path = CreatePath(speculation.paths, worker.cover_map, seed);
+        GrowSeed(worker.extenders, path, speculation.paths);
+        worker.cover_map.Remove(path);
+        worker.cover_map.Remove(*path.GetConjPath());
+        speculation.grown = true;
+    }
+    speculation.claims = worker.used_storage.TakeClaims();
+    speculation.dirty |= SharedStateVersion(worker.extenders) != version;
+}
+
+void CompositeExtender::Commit(Speculation &speculation, PathContainer &result) {
+    // The committed paths are the copies with the new ids, the claims made by
+    // the speculative paths are replayed on behalf of the copies
+    std::unordered_map<size_t, size_t> ids;
+    for (auto it = speculation.paths.begin(); speculation.grown && it != speculation.paths.end(); ++it) {
+        auto p = result.AddPair(BidirectionalPath::clone(it.get()),
+                                BidirectionalPath::clone(it.getConjugate()));
+        ids[it.get().GetId()] = p.first.GetId();
+        ids[it.getConjugate().GetId()] = p.second.GetId();
+        // Only the grown path is subscribed to the coverage map
+        if (it == speculation.paths.begin())
+            cover_map_.Subscribe(p);
+    }
+
+    for (auto &entry : speculation.claims.inserted) {
+        auto id = ids.find(entry.second);
+        if (id != ids.end())
+            entry.second = id->second;
+    }
+    used_storage_.Commit(speculation.claims);
+}
+
+void CompositeExtender::GrowAllPathsParallel(PathContainer& paths, PathContainer& result) {
+    const size_t round_size = workers_.size() * 16;
+    size_t redone = 0;
+    for (size_t start = 0; start < paths.size(); start += round_size) {
+        size_t end = std::min(paths.size(), start + round_size);
+        size_t version = SharedStateVersion(extenders_);
+
+        std::vector<Speculation> speculations(end - start);
+#       pragma omp parallel for schedule(dynamic) num_threads(workers_.size())
+        for (size_t i = start; i < end; ++i) {
+            Speculate(*workers_[omp_get_thread_num()], paths.Get(i), version, speculations[i - start]);
         }
-        //In 2015 modes do not use a seed already used in paths.
-        //FIXME what is the logic here?
-        if (used_storage_.UniqueCheckEnabled()) {
-            bool was_used = false;
-            const BidirectionalPath &p = paths.Get(i);
-            for (size_t ind =0; ind < p.Size(); ind++) {
-                EdgeId eid = p.At(ind);
-                auto path_id = p.GetId();
-                if (used_storage_.IsUsedAndUnique(eid, path_id)) {
-                    DEBUG("Used edge " << g_.int_id(eid));
-                    was_used = true;
-                    break;
-                } else {
-                    used_storage_.insert(eid, path_id);
-                }
-            }
-            if (was_used) {
-                DEBUG("skipping already used seed");
-                continue;
+
+        for (size_t i = start; i < end; ++i) {
+            ReportProgress(i, paths.size());
+            Speculation &speculation = speculations[i - start];
+            // The seed covered by the paths committed after the speculation
+            // is skipped by the serial version, so its claims are void
+            if (speculation.dirty ||
+                SharedStateVersion(extenders_) != version ||
+                used_storage_.Outdated(speculation.claims) ||
+                (speculation.grown && cover_map_.IsCovered(paths.Get(i)))) {
+                ++redone;
+                ExtendSeed(paths.Get(i), result);
+            } else {
+                Commit(speculation, result);
             }
         }
 
-        if (!cover_map_.IsCovered(paths.Get(i))) {
-            BidirectionalPath &path = CreatePath(result, cover_map_,
-                                                 paths.Get(i));
-
-            size_t count_trying = 0;
-            size_t current_path_len = 0;
-            do {
-                current_path_len = path.Length();
-                count_trying++;
-                GrowPath(path, &result);
-                GrowPath(*path.GetConjPath(), &result);
-            } while (count_trying < 10 && (path.Length() != current_path_len));
-                DEBUG("result path " << path.GetId());
-                path.PrintDEBUG();
+        bool changed = SharedStateVersion(extenders_) != version;
+        for (auto &worker : workers_) {
+            if (!changed && SharedStateVersion(worker->extenders) == version)
+                continue;
+            for (size_t j = 0; j < extenders_.size(); ++j)
+                worker->extenders[j]->SyncSharedState(*extenders_[j]);
         }
     }
+    INFO("Seeds extended in parallel, " << redone << " of " << paths.size() << " extensions redone");
 }
 
 bool LoopDetectingPathExtender::TryUseEdge(BidirectionalPath &path, EdgeId e, const Gap &gap) {
@@ -13,8 +13,14 @@
 #include "assembly_graph/paths/bidirectional_path.hpp"
 #include "assembly_graph/paths/bidirectional_path_container.hpp"
 
-#include "adt/flat_map.hpp"
-#include "parallel_hashmap/phmap.h"
+#include "adt/small_pod_vector.hpp"
+
+#include <folly/synchronization/PicoSpinLock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 namespace path_extend {
 
@@ -22,33 +28,81 @@ using namespace debruijn_graph;
 
 // Handles all paths in PathContainer.
 // For each edge output all paths  that _traverse_ this path. If path contains multiple instances - count them. Position of the edge is not reported.
+// The paths of an edge are kept in a small inline array in a vector indexed
+// by the edge id. In the concurrent mode the edges could be added / removed
+// and the coverage could be queried from several threads.
 class GraphCoverageMap: public PathListener {
 public:
-    typedef adt::flat_map<BidirectionalPath*, size_t> MapDataT;
+    struct PathCount {
+        BidirectionalPath *path;
+        size_t count;
+    };
+    // Paths in order of addition
+    typedef adt::SmallPODVector<PathCount, adt::impl::HybridAllocatedStorage<PathCount, 1>> MapDataT;
 
 private:
+    typedef std::unique_lock<folly::PicoSpinLock<uint16_t>> Guard;
+    static constexpr size_t LOCK_STRIPES = 1 << 12;
+
     const Graph& g_;
 
-    phmap::parallel_flat_hash_map<EdgeId, MapDataT> edge_coverage_;
+    // Allocated on the first addition, unless concurrent
+    std::vector<MapDataT> edge_coverage_;
+    std::atomic<size_t> covered_edges_;
+    mutable std::vector<folly::PicoSpinLock<uint16_t>> locks_;
     const MapDataT empty_;
 
+    Guard Lock(EdgeId e) const {
+        if (locks_.empty())
+            return Guard();
+        return Guard(locks_[e.int_id() & (LOCK_STRIPES - 1)]);
+    }
+
+    const MapDataT &Paths(EdgeId e) const {
+        return e.int_id() < edge_coverage_.size() ? edge_coverage_[e.int_id()] : empty_;
+    }
+
+    template<class Paths>
+    static auto Find(Paths &paths, const BidirectionalPath &path) {
+        return std::find_if(paths.begin(), paths.end(),
+                            [&](const PathCount &entry) { return entry.path == &path; });
+    }
+
     void EdgeAdded(EdgeId e, BidirectionalPath &path) {
-        edge_coverage_[e][&path] += 1;
+        if (e.int_id() >= edge_coverage_.size()) {
+            VERIFY_MSG(locks_.empty(), "Graph was changed while coverage map is used concurrently");
+            edge_coverage_.resize(std::max(g_.max_eid(), size_t(e.int_id() + 1)));
+        }
+
+        Guard lock = Lock(e);
+        auto &paths = edge_coverage_[e.int_id()];
+        auto entry = Find(paths, path);
+        if (entry != paths.end()) {
+            entry->count += 1;
+            return;
+        }
+        if (paths.empty())
+            covered_edges_.fetch_add(1, std::memory_order_relaxed);
+        paths.push_back({&path, 1});
     }
 
     void EdgeRemoved(EdgeId e, BidirectionalPath &path) {
-        auto iter = edge_coverage_.find(e);
-        if (iter == edge_coverage_.end())
+        if (e.int_id() >= edge_coverage_.size())
             return;
 
-        auto entry = iter->second.find(&path);
-        if (entry == iter->second.end()) {
+        Guard lock = Lock(e);
+        auto &paths = edge_coverage_[e.int_id()];
+        auto entry = Find(paths, path);
+        if (entry == paths.end()) {
             DEBUG("Error erasing path from coverage map");
         } else {
-            if (entry->second > 1)
-                entry->second -= 1;
-            else
-                iter->second.erase(entry);
+            if (entry->count > 1)
+                entry->count -= 1;
+            else {
+                paths.erase(entry);
+                if (paths.empty())
+                    covered_edges_.fetch_sub(1, std::memory_order_relaxed);
+            }
         }
     }
 
@@ -65,11 +119,20 @@ public:
     GraphCoverageMap(const GraphCoverageMap&) = delete;
     GraphCoverageMap& operator=(const GraphCoverageMap&) = delete;
 
-    GraphCoverageMap(GraphCoverageMap&&) = default;
-
-    explicit GraphCoverageMap(const Graph& g) : g_(g) {
-        //FIXME heavy constructor
-        edge_coverage_.reserve(g_.e_size());
+    GraphCoverageMap(GraphCoverageMap &&that)
+            : g_(that.g_),
+              edge_coverage_(std::move(that.edge_coverage_)),
+              covered_edges_(that.covered_edges_.load()),
+              locks_(std::move(that.locks_)) {}
+
+    explicit GraphCoverageMap(const Graph& g, bool concurrent = false)
+            : g_(g), covered_edges_(0) {
+        if (concurrent) {
+            edge_coverage_.resize(g_.max_eid());
+            locks_.resize(LOCK_STRIPES);
+            for (auto &lock : locks_)
+                lock.init(0);
+        }
     }
 
     GraphCoverageMap(const Graph& g, const PathContainer& paths, bool subscribe = false) :
@@ -95,6 +158,13 @@ public:
         ProcessPath(ppair.second, true);
     }
 
+    // Forgets the edges of the path. The path should not be modified afterwards
+    void Remove(BidirectionalPath &path) {
+        for (size_t i = 0; i < path.Size(); ++i) {
+            EdgeRemoved(path.At(i), path);
+        }
+    }
+
     //Inherited from PathListener
     void FrontEdgeAdded(EdgeId e, BidirectionalPath &path, const Gap&) override {
         EdgeAdded(e, path);
@@ -115,26 +185,21 @@ public:
         EdgeRemoved(e, path);
     }
 
+    // Not guarded in the concurrent mode
     const MapDataT &GetEdgePaths(EdgeId e) const {
-        auto iter = edge_coverage_.find(e);
-        if (iter != edge_coverage_.end()) {
-            return iter->second;
-        }
-        return empty_;
+        return Paths(e);
     }
 
     size_t Count(EdgeId e, const BidirectionalPath &path) const {
-        auto entry = edge_coverage_.find(e);
-        if (entry == edge_coverage_.end())
-            return 0;
-
-        auto cov = entry->second.find(const_cast<BidirectionalPath*>(&path));
-        return (cov == entry->second.end() ? 0 : cov->second);
+        Guard lock = Lock(e);
+        const auto &paths = Paths(e);
+        auto entry = Find(paths, path);
+        return (entry == paths.end() ? 0 : entry->count);
     }
 
     size_t GetCoverage(EdgeId e) const {
-        auto iter = edge_coverage_.find(e);
-        return (iter != edge_coverage_.end() ? iter->second.size() : 0);
+        Guard lock = Lock(e);
+        return Paths(e).size();
     }
 
     bool IsCovered(EdgeId e) const {
@@ -151,26 +216,16 @@ public:
 
     BidirectionalPathSet GetCoveringPaths(EdgeId e) const {
         BidirectionalPathSet res;
-        auto iter = edge_coverage_.find(e);
-        if (iter == edge_coverage_.end())
-            return res;
-
-        for (const auto &entry : iter->second)
-            res.insert(entry.first);
+        Guard lock = Lock(e);
+        for (const auto &entry : Paths(e))
+            res.insert(entry.path);
 
         return res;
     }
 
-    auto begin() const {
-        return edge_coverage_.begin();
-    }
-
-    auto end() const {
-        return edge_coverage_.end();
-    }
-
+    // Number of the covered edges
     size_t size() const {
-        return edge_coverage_.size();
+        return covered_edges_.load(std::memory_order_relaxed);
     }
 
     const Graph& graph() const {
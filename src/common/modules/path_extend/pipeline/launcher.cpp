@@ -19,6 +19,7 @@
 #include "alignment/rna/ss_coverage.hpp"
 #include "assembly_graph/core/basic_graph_stats.hpp"
 #include "assembly_graph/graph_support/coverage_uniformity_analyzer.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include <unordered_set>
 
@@ -321,7 +322,7 @@ void PathExtendLauncher::AddScaffUniqueStorage(size_t uniqe_edge_len) {
     additional_edge_analyzer.FillUniqueEdgeStorage(unique_data_.unique_storages_.back());
 }
 
-Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &generator) {
+void PathExtendLauncher::AddScaffUniqueStorages() {
     const pe_config::ParamSetT &pset = params_.pset;
 
     size_t cur_length = unique_data_.min_unique_length_ - pset.scaffolding2015.unique_length_step;
@@ -336,8 +337,6 @@ Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &gen
         INFO("Will add final extenders for length " << lower_bound);
         AddScaffUniqueStorage(lower_bound);
     }
-
-    return generator.MakeMPExtenders();
 }
 
 void PathExtendLauncher::FillPathContainer(size_t lib_index, size_t size_threshold) {
@@ -409,44 +408,57 @@ void  PathExtendLauncher::FillPBUniqueEdgeStorages() {
     INFO(unique_data_.unique_pb_storage_.size() << " unique edges");
 }
 
-Extenders PathExtendLauncher::ConstructPBExtenders(const ExtendersGenerator &generator) {
-    FillPBUniqueEdgeStorages();
-    return generator.MakePBScaffoldingExtenders();
+bool PathExtendLauncher::UsePBExtenders() const {
+    return !config::PipelineHelper::IsPlasmidPipeline(params_.mode) && support_.HasLongReads() &&
+           params_.pset.sm != scaffolding_mode::sm_old;
 }
 
+bool PathExtendLauncher::UseMPExtenders() const {
+    return support_.HasMPReads() && params_.pset.sm != scaffolding_mode::sm_old;
+}
 
 Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_map,
                                                  UsedUniqueStorage &used_unique_storage) {
     INFO("Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
     if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) &&  (support_.SingleReadsMapped() || support_.HasLongReads()))
         FillLongReadsCoverageMaps();
-    ExtendersGenerator generator(dataset_info_, params_, gp_, cover_map,
-                                 unique_data_, used_unique_storage, support_);
-    Extenders extenders = generator.MakeBasicExtenders();
-    DEBUG("Total number of basic extenders is " << extenders.size());
 
     //long reads scaffolding extenders.
-
     if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) && support_.HasLongReads()) {
-        if (params_.pset.sm == scaffolding_mode::sm_old) {
+        if (UsePBExtenders())
+            FillPBUniqueEdgeStorages();
+        else
             INFO("Will not use new long read scaffolding algorithm in this mode");
-        } else {
-            utils::push_back_all(extenders, ConstructPBExtenders(generator));
-        }
     }
 
     if (support_.HasMPReads()) {
-        if (params_.pset.sm == scaffolding_mode::sm_old) {
+        if (UseMPExtenders())
+            AddScaffUniqueStorages();
+        else
             INFO("Will not use mate-pairs is this mode");
-        } else {
-            utils::push_back_all(extenders, ConstructMPExtenders(generator));
-        }
     }
 
+    Extenders extenders = MakeExtenders(cover_map, used_unique_storage);
+    INFO("Total number of extenders is " << extenders.size());
+    return extenders;
+}
+
+Extenders PathExtendLauncher::MakeExtenders(const GraphCoverageMap &cover_map,
+                                            UsedUniqueStorage &used_unique_storage) const {
+    ExtendersGenerator generator(dataset_info_, params_, gp_, cover_map,
+                                 unique_data_, used_unique_storage, support_);
+    Extenders extenders = generator.MakeBasicExtenders();
+    DEBUG("Total number of basic extenders is " << extenders.size());
+
+    if (UsePBExtenders())
+        utils::push_back_all(extenders, generator.MakePBScaffoldingExtenders());
+
+    if (UseMPExtenders())
+        utils::push_back_all(extenders, generator.MakeMPExtenders());
+
     if (params_.pset.use_coordinated_coverage)
         utils::push_back_all(extenders, generator.MakeCoverageExtenders());
 
-    INFO("Total number of extenders is " << extenders.size());
     return extenders;
 }
 
@@ -632,9 +644,16 @@ void PathExtendLauncher::Launch() {
         GraphCoverageMap cover_map(graph_);
         UsedUniqueStorage used_unique_storage(unique_data_.main_unique_storage_, graph_);
         Extenders extenders = ConstructExtenders(cover_map, used_unique_storage);
+        size_t threads = params_.pe_cfg.extension_threads;
+        threads = threads ? std::min<size_t>(threads, omp_get_max_threads()) : omp_get_max_threads();
         CompositeExtender composite_extender(graph_, cover_map,
                                              used_unique_storage,
-                                             extenders);
+                                             extenders,
+                                             [this](const GraphCoverageMap &worker_cover_map,
+                                                    UsedUniqueStorage &worker_used_storage) {
+                                                 return MakeExtenders(worker_cover_map, worker_used_storage);
+                                             },
+                                             threads);
 
         auto paths = resolver.ExtendSeeds(seeds, composite_extender);
         seeds.clear();
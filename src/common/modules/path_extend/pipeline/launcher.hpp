@@ -73,13 +73,17 @@ class PathExtendLauncher {
 
     void PolishPaths(const PathContainer &paths, PathContainer &result, const GraphCoverageMap &cover_map) const;
 
+    bool UsePBExtenders() const;
+
+    bool UseMPExtenders() const;
+
     Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage);
 
-    Extenders ConstructMPExtenders(const ExtendersGenerator &generator);
+    Extenders MakeExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage) const;
 
     void AddScaffUniqueStorage(size_t uniqe_edge_len);
 
-    Extenders ConstructPBExtenders(const ExtendersGenerator &generator);
+    void AddScaffUniqueStorages();
 
     void FilterPaths(PathContainer& paths);
 
@@ -18,6 +18,8 @@
 
 #include <unordered_set>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace path_extend {
 typedef debruijn_graph::EdgeId EdgeId;
@@ -120,11 +122,23 @@ public:
 };
 
 class UsedUniqueStorage {
+public:
+    // Outcome of the speculative usage: the edges found unused in the base
+    // storage and the insertions to be replayed
+    struct Claims {
+        std::vector<EdgeId> unused;
+        std::vector<std::pair<EdgeId, size_t>> inserted;
+    };
+
+private:
     std::unordered_set<EdgeId> used_;
     std::unordered_map<size_t, std::unordered_set<EdgeId>> used_by_paths_; // for fast check 'whether the path contains the edge'
     const ScaffoldingUniqueEdgeStorage& unique_;
     const debruijn_graph::ConjugateDeBruijnGraph &g_;
 
+    const UsedUniqueStorage *base_;
+    mutable Claims claims_;
+
 public:
     UsedUniqueStorage(const UsedUniqueStorage&) = delete;
     UsedUniqueStorage& operator=(const UsedUniqueStorage&) = delete;
@@ -135,6 +149,15 @@ public:
                                const debruijn_graph::ConjugateDeBruijnGraph &g)
         : unique_(unique)
         , g_(g) 
+        , base_(nullptr)
+    {}
+
+    // Speculative storage: the base storage is only read, all the changes are
+    // kept locally and recorded, see TakeClaims()
+    explicit UsedUniqueStorage(const UsedUniqueStorage *base)
+        : unique_(base->unique_)
+        , g_(base->g_)
+        , base_(base)
     {}
 
     void insert(EdgeId e, size_t path_id) {
@@ -145,15 +168,26 @@ public:
         used_.insert(g_.conjugate(e));
         used_by_paths_[path_id].insert(e);
         used_by_paths_[path_id].insert(g_.conjugate(e));
+        if (base_)
+            claims_.inserted.emplace_back(e, path_id);
     }
 
     bool IsUsed(EdgeId e, size_t path_id) const {
         auto it = used_by_paths_.find(path_id);
-        return it != used_by_paths_.end() && it->second.find(e) != it->second.end();
+        if (it != used_by_paths_.end() && it->second.find(e) != it->second.end())
+            return true;
+        return base_ && base_->IsUsed(e, path_id);
     }
 
     bool IsUsed(EdgeId e) const {
-        return used_.find(e) != used_.end();
+        if (used_.find(e) != used_.end())
+            return true;
+        if (!base_)
+            return false;
+        if (base_->IsUsed(e))
+            return true;
+        claims_.unused.push_back(e);
+        return false;
     }
 
     bool IsUsedAndUnique(EdgeId e, size_t path_id) const {
@@ -186,6 +220,28 @@ public:
         return true;
     }
 
+    // Resets the speculative storage returning the claims made since the last call
+    Claims TakeClaims() {
+        VERIFY(base_);
+        used_.clear();
+        used_by_paths_.clear();
+        return std::exchange(claims_, Claims());
+    }
+
+    // Whether the claims were made against the outdated state of the storage
+    bool Outdated(const Claims &claims) const {
+        for (EdgeId e : claims.unused) {
+            if (IsUsed(e))
+                return true;
+        }
+        return false;
+    }
+
+    void Commit(const Claims &claims) {
+        for (const auto &entry : claims.inserted)
+            insert(entry.first, entry.second);
+    }
+
 };
 
 //FIXME rename
@@ -236,28 +236,10 @@ class AlternativesAnalyzer {
     }
 
 
-public:
-    AlternativesAnalyzer(const Graph& g, double max_coverage, size_t max_length,
-                         double max_relative_coverage, size_t max_delta,
-                         double max_relative_delta, size_t max_edge_cnt,
-                         size_t dijkstra_vertex_limit, double min_identity) :
-                         g_(g),
-                         max_coverage_(max_coverage),
-                         max_length_(max_length),
-                         max_relative_coverage_(max_relative_coverage),
-                         max_delta_(max_delta),
-                         max_relative_delta_(max_relative_delta),
-                         max_edge_cnt_(max_edge_cnt),
-                         dijkstra_vertex_limit_(dijkstra_vertex_limit),
-                         min_identity_(min_identity) {
-        DEBUG("Created alternatives analyzer max_length=" << max_length
-        << " max_coverage=" << max_coverage
-        << " max_relative_coverage=" << max_relative_coverage
-        << " max_delta=" << max_delta
-        << " max_relative_delta=" << max_relative_delta);
-    }
+    std::vector<EdgeId> FindAlternative(EdgeId e, std::vector<VertexId> *explored) const {
+        if (explored)
+            explored->push_back(g_.EdgeStart(e));
 
-    std::vector<EdgeId> operator()(EdgeId e) const {
         if (g_.length(e) > max_length_ || math::gr(g_.coverage(e), max_coverage_)) {
             return EmptyPath();
         }
@@ -278,6 +260,10 @@ public:
         PathProcessor<Graph> processor(g_, start, max_path_len, dijkstra_vertex_limit_);
         processor.Process(end, (g_.length(e) > delta) ? g_.length(e) - delta : 0,
                           max_path_len, path_chooser, max_edge_cnt_);
+        if (explored) {
+            for (const auto &entry : processor.reached())
+                explored->push_back(entry.first);
+        }
 
         const std::vector<EdgeId> &path = path_chooser.most_covered_path();
         if (!path.empty()) {
@@ -302,6 +288,40 @@ public:
         }
     }
 
+public:
+    AlternativesAnalyzer(const Graph& g, double max_coverage, size_t max_length,
+                         double max_relative_coverage, size_t max_delta,
+                         double max_relative_delta, size_t max_edge_cnt,
+                         size_t dijkstra_vertex_limit, double min_identity) :
+                         g_(g),
+                         max_coverage_(max_coverage),
+                         max_length_(max_length),
+                         max_relative_coverage_(max_relative_coverage),
+                         max_delta_(max_delta),
+                         max_relative_delta_(max_relative_delta),
+                         max_edge_cnt_(max_edge_cnt),
+                         dijkstra_vertex_limit_(dijkstra_vertex_limit),
+                         min_identity_(min_identity) {
+        DEBUG("Created alternatives analyzer max_length=" << max_length
+        << " max_coverage=" << max_coverage
+        << " max_relative_coverage=" << max_relative_coverage
+        << " max_delta=" << max_delta
+        << " max_relative_delta=" << max_relative_delta);
+    }
+
+    std::vector<EdgeId> operator()(EdgeId e) const {
+        return FindAlternative(e, nullptr);
+    }
+
+    /**
+     * Also collects the vertices the result depends on: the result stays the
+     * same until an edge adjacent to one of them is added or removed
+     * (provided e itself is not removed, the start of e is always collected).
+     */
+    std::vector<EdgeId> operator()(EdgeId e, std::vector<VertexId> &explored) const {
+        return FindAlternative(e, &explored);
+    }
+
     double max_coverage() const {
         return max_coverage_;
     }
@@ -314,6 +334,162 @@ private:
     DECL_LOGGER("AlternativesAnalyzer");
 };
 
+/**
+ * Searches for the alternatives of the edges which are next in the processing
+ * queue speculatively: in parallel, on the current graph, while the edges are
+ * still processed (and the bulges glued) one by one in the queue order.
+ * The speculative result is used only if no edge adjacent to the vertices
+ * explored by the search was added or removed since, otherwise the search is
+ * repeated. Thus the outcome is the same as the one of the serial search
+ * regardless of the number of threads.
+ * Should be attached to the graph for the time of processing only.
+ */
+template<class Graph>
+class SpeculativeAlternativesFinder : public GraphActionHandler<Graph> {
+    typedef GraphActionHandler<Graph> base;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
+
+    struct Speculation {
+        size_t epoch = 0;
+        bool searched = false;
+        std::vector<EdgeId> alternative;
+        std::vector<VertexId> explored;
+    };
+
+    const AlternativesAnalyzer<Graph> &analyzer_;
+    const size_t batch_size_;
+    phmap::flat_hash_map<EdgeId, Speculation> speculated_;
+    // Vertices to the epoch of their last modification, the modifications
+    // made after the speculation of the given epoch have this epoch
+    phmap::flat_hash_map<VertexId, size_t> modified_;
+    size_t epoch_;
+    size_t used_cnt_, repeated_cnt_;
+
+    bool Actual(const Speculation &speculation) const {
+        if (!speculation.searched)
+            return false;
+        for (VertexId v : speculation.explored) {
+            auto it = modified_.find(v);
+            if (it != modified_.end() && it->second >= speculation.epoch)
+                return false;
+        }
+        return true;
+    }
+
+    void Speculate(const std::vector<EdgeId> &upcoming) {
+        // Forget the stale speculations from time to time
+        if (speculated_.size() > 4 * batch_size_) {
+            speculated_.clear();
+            modified_.clear();
+        }
+
+        std::vector<EdgeId> edges;
+        for (EdgeId e : upcoming) {
+            auto it = speculated_.find(e);
+            if (it == speculated_.end() || !Actual(it->second))
+                edges.push_back(e);
+        }
+
+        epoch_ += 1;
+        std::vector<Speculation> speculations(edges.size());
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t i = 0; i < edges.size(); ++i) {
+            EdgeId e = edges[i];
+            Speculation &speculation = speculations[i];
+            speculation.epoch = epoch_;
+            // Otherwise the search is not launched at all
+            if (!HasAlternatives(this->g(), e))
+                continue;
+            speculation.searched = true;
+            speculation.alternative = analyzer_(e, speculation.explored);
+        }
+
+        for (size_t i = 0; i < edges.size(); ++i)
+            speculated_[edges[i]] = std::move(speculations[i]);
+        TRACE("Speculatively searched " << edges.size() << " edges");
+    }
+
+    void AccountModification(VertexId v) {
+        modified_[v] = epoch_;
+    }
+
+    void AccountModification(EdgeId e) {
+        AccountModification(this->g().EdgeStart(e));
+        AccountModification(this->g().EdgeEnd(e));
+    }
+
+public:
+    SpeculativeAlternativesFinder(const Graph &g,
+                                  const AlternativesAnalyzer<Graph> &analyzer,
+                                  size_t batch_size)
+            : base(g, "SpeculativeAlternativesFinder"),
+              analyzer_(analyzer), batch_size_(batch_size),
+              epoch_(0), used_cnt_(0), repeated_cnt_(0) {
+        this->Detach();
+    }
+
+    bool enabled() const {
+        return batch_size_ > 1;
+    }
+
+    /**
+     * upcoming(cnt) should return up to cnt edges to be processed next,
+     * starting with e
+     */
+    template<class UpcomingF>
+    std::vector<EdgeId> operator()(EdgeId e, const UpcomingF &upcoming) {
+        if (!enabled())
+            return analyzer_(e);
+
+        VERIFY(this->IsAttached());
+        auto it = speculated_.find(e);
+        if (it == speculated_.end() || !Actual(it->second)) {
+            Speculate(upcoming(batch_size_));
+            it = speculated_.find(e);
+        }
+
+        if (it != speculated_.end()) {
+            Speculation speculation = std::move(it->second);
+            speculated_.erase(it);
+            if (Actual(speculation)) {
+                used_cnt_ += 1;
+                return std::move(speculation.alternative);
+            }
+        }
+
+        repeated_cnt_ += 1;
+        return analyzer_(e);
+    }
+
+    void Reset() {
+        DEBUG("Speculative results used " << used_cnt_ << " times, searches repeated " << repeated_cnt_ << " times");
+        speculated_.clear();
+        modified_.clear();
+        epoch_ = 0;
+        used_cnt_ = repeated_cnt_ = 0;
+    }
+
+    void HandleAdd(VertexId v) override {
+        AccountModification(v);
+    }
+
+    void HandleAdd(EdgeId e) override {
+        AccountModification(e);
+    }
+
+    void HandleDelete(VertexId v) override {
+        AccountModification(v);
+    }
+
+    void HandleDelete(EdgeId e) override {
+        AccountModification(e);
+    }
+
+private:
+    DECL_LOGGER("SpeculativeAlternativesFinder");
+};
+
 template<class Graph>
 func::TypedPredicate<typename Graph::EdgeId>
 NecessaryBulgeCondition(const Graph& g, size_t max_length, double max_coverage) {
@@ -363,7 +539,7 @@ protected:
             return false;
         }
 
-        auto alternative = alternatives_analyzer_(e);
+        auto alternative = speculative_finder_(e, [this](size_t cnt) { return this->UpcomingElements(cnt); });
         if (!alternative.empty()) {
             gluer_(e, alternative);
             return true;
@@ -375,23 +551,42 @@ public:
 
     typedef std::function<bool(EdgeId edge, const std::vector<EdgeId> &path)> BulgeCallbackF;
 
+    /**
+     * With speculation_batch > 1 the alternatives are searched in advance for
+     * that many next edges in parallel (see SpeculativeAlternativesFinder)
+     */
     BulgeRemover(Graph& g, size_t chunk_cnt,
             const AlternativesAnalyzer<Graph>& alternatives_analyzer,
             BulgeCallbackF opt_callback = 0,
             std::function<void(EdgeId)> removal_handler = 0,
-            bool track_changes = true) :
+            bool track_changes = true,
+            size_t speculation_batch = 0) :
             base(g,
                  BulgeCandidateFinder(g, alternatives_analyzer, chunk_cnt),
                  /*canonical_only*/true,
                  CoverageComparator<Graph>(g),
                  track_changes),
             alternatives_analyzer_(alternatives_analyzer),
-            gluer_(g, opt_callback, removal_handler) {
+            gluer_(g, opt_callback, removal_handler),
+            speculative_finder_(g, alternatives_analyzer_, speculation_batch) {
+    }
+
+    size_t Run(bool force_primary_launch = false,
+               double iter_run_progress = 1.) override {
+        if (!speculative_finder_.enabled())
+            return base::Run(force_primary_launch, iter_run_progress);
+
+        speculative_finder_.Attach();
+        size_t triggered = base::Run(force_primary_launch, iter_run_progress);
+        speculative_finder_.Reset();
+        speculative_finder_.Detach();
+        return triggered;
     }
 
 private:
     AlternativesAnalyzer<Graph> alternatives_analyzer_;
     BulgeGluer<Graph> gluer_;
+    SpeculativeAlternativesFinder<Graph> speculative_finder_;
 private:
     DECL_LOGGER("BulgeRemover")
 };
@@ -411,6 +606,7 @@ private:
     double buff_cov_rel_diff_;
     AlternativesAnalyzer<Graph> alternatives_analyzer_;
     BulgeGluer<Graph> gluer_;
+    SpeculativeAlternativesFinder<Graph> speculative_finder_;
     CandidateFinderPtr interesting_edge_finder_;
     //todo remove
     bool tracking_;
@@ -615,7 +811,7 @@ private:
         for (; !edges.IsEnd(); ++edges) {
             EdgeId e = *edges;
             TRACE("Processing edge " << this->g().str(e));
-            std::vector<EdgeId> alternative = alternatives_analyzer_(e);
+            std::vector<EdgeId> alternative = speculative_finder_(e, [&edges](size_t cnt) { return edges.Upcoming(cnt); });
             if (!alternative.empty()) {
                 gluer_(e, alternative);
                 triggered++;
@@ -657,7 +853,8 @@ public:
                          const AlternativesAnalyzer<Graph>& alternatives_analyzer,
                          BulgeCallbackF opt_callback = 0,
                          std::function<void(EdgeId)> removal_handler = 0,
-                         bool track_changes = true) :
+                         bool track_changes = true,
+                         size_t speculation_batch = 0) :
 
                          PersistentAlgorithmBase<Graph>(g),
                          buff_size_(buff_size),
@@ -665,6 +862,7 @@ public:
                          buff_cov_rel_diff_(buff_cov_rel_diff),
                          alternatives_analyzer_(alternatives_analyzer),
                          gluer_(g, opt_callback, removal_handler),
+                         speculative_finder_(g, alternatives_analyzer_, speculation_batch),
                          interesting_edge_finder_(BulgeCandidateFinder(g, alternatives_analyzer, chunk_cnt)),
                          tracking_(track_changes),
                          it_(g, /*add new*/true,
@@ -697,6 +895,9 @@ public:
             DEBUG(it_.size() << " edges to process");
         }
 
+        if (speculative_finder_.enabled())
+            speculative_finder_.Attach();
+
         size_t triggered = 0;
         bool proceed = true;
         while (proceed) {
@@ -731,6 +932,11 @@ public:
         if (!tracking_)
             it_.Detach();
 
+        if (speculative_finder_.enabled()) {
+            speculative_finder_.Reset();
+            speculative_finder_.Detach();
+        }
+
         return triggered;
     }
 
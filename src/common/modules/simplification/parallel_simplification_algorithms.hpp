@@ -18,6 +18,8 @@
 #include "assembly_graph/graph_support/marks_and_locks.hpp"
 #include "compressor.hpp"
 
+#include <optional>
+
 namespace debruijn {
 
 namespace simplification {
@@ -26,7 +28,7 @@ template<class Graph>
 class ParallelTipClippingFunctor {
     typedef typename Graph::EdgeId EdgeId;
     typedef typename Graph::VertexId VertexId;
-    typedef omnigraph::GraphElementLock<VertexId> VertexLockT;
+    typedef omnigraph::VertexTransaction<Graph> VertexLockT;
 
     Graph& g_;
     size_t length_bound_;
@@ -34,12 +36,12 @@ class ParallelTipClippingFunctor {
     omnigraph::EdgeRemovalHandlerF<Graph> handler_f_;
 
     size_t LockingIncomingCount(VertexId v) const {
-        VertexLockT lock(v);
+        VertexLockT lock(g_, {v});
         return g_.IncomingEdgeCount(v);
     }
 
     size_t LockingOutgoingCount(VertexId v) const {
-        VertexLockT lock(v);
+        VertexLockT lock(g_, {v});
         return g_.OutgoingEdgeCount(v);
     }
 
@@ -49,9 +51,7 @@ class ParallelTipClippingFunctor {
     }
 
     void RemoveEdge(EdgeId e) {
-        //even full tip locking can't lead to deadlock
-        VertexLockT lock1(g_.EdgeStart(e));
-        VertexLockT lock2(g_.EdgeEnd(e));
+        VertexLockT lock(g_, {g_.EdgeStart(e), g_.EdgeEnd(e)});
         g_.DeleteEdge(e);
     }
 
@@ -103,7 +103,7 @@ template<class Graph>
 class ParallelSimpleBRFunctor {
     typedef typename Graph::EdgeId EdgeId;
     typedef typename Graph::VertexId VertexId;
-    typedef omnigraph::GraphElementLock<VertexId> VertexLockT;
+    typedef omnigraph::VertexTransaction<Graph> VertexLockT;
 
     Graph& g_;
     size_t max_length_;
@@ -179,7 +179,7 @@ class ParallelSimpleBRFunctor {
     }
 
     bool CheckVertex(VertexId v) const {
-        VertexLockT lock(v);
+        VertexLockT lock(g_, {v});
         return MultiEdgeDestinations(v).size() == 1 && MultiEdgeDestinations(g_.conjugate(v)).size() == 0;
     }
 
@@ -209,15 +209,14 @@ public:
         std::vector<VertexId> multi_dest;
 
         {
-            VertexLockT lock(v);
+            VertexLockT lock(g_, {v});
             multi_dest = MultiEdgeDestinations(v);
         }
 
         if (multi_dest.size() == 1 && IsMinimal(v, multi_dest.front())) {
             VertexId dest = multi_dest.front();
             if (CheckVertex(v) && CheckVertex(g_.conjugate(dest))) {
-                VertexLockT lock1(v);
-                VertexLockT lock2(dest);
+                VertexLockT lock(g_, {v, dest});
                 RemoveBulges(v);
             }
         }
@@ -286,7 +285,7 @@ template<class Graph>
 class ParallelLowCoverageFunctor {
     typedef typename Graph::EdgeId EdgeId;
     typedef typename Graph::VertexId VertexId;
-    typedef omnigraph::GraphElementLock<VertexId> VertexLockT;
+    typedef omnigraph::VertexTransaction<Graph> VertexLockT;
 
     Graph& g_;
     typename Graph::HelperT helper_;
@@ -298,7 +297,7 @@ class ParallelLowCoverageFunctor {
 
     void UnlinkEdgeFromStart(EdgeId e) {
         VertexId start = g_.EdgeStart(e);
-        VertexLockT lock(start);
+        VertexLockT lock(g_, {start});
         helper_.DeleteLink(start, e);
     }
 
@@ -346,241 +345,100 @@ private:
     DECL_LOGGER("ParallelLowCoverageFunctor");
 };
 
+/**
+ * Condenses the maximal non-branching paths of the graph in parallel. The
+ * paths are found and their merged sequences are built by all the threads
+ * on the unchanged graph. Then the merges are applied concurrently (the
+ * paths only share their branching ends, which are locked) and the handlers
+ * are notified in bulk once all the merges are done.
+ * Isolated cycles and the paths conjugate to themselves are left to
+ * omnigraph::CompressAllVertices.
+ */
 template<class Graph>
 class ParallelCompressor {
     typedef typename Graph::EdgeId EdgeId;
     typedef typename Graph::EdgeData EdgeData;
     typedef typename Graph::VertexId VertexId;
-    typedef omnigraph::GraphElementLock<VertexId> VertexLockT;
 
-    Graph& g_;
-    typename Graph::HelperT helper_;
-    std::unique_ptr<restricted::IdSegmentStorage> segment_storage_;
+    Graph &g_;
+    size_t chunk_cnt_;
+    bool safe_merging_;
 
     bool IsBranching(VertexId v) const {
-//        VertexLockT lock(v);
         return !g_.CheckUniqueOutgoingEdge(v) || !g_.CheckUniqueIncomingEdge(v);
     }
 
-    size_t LockingIncomingCount(VertexId v) const {
-        VertexLockT lock(v);
-        return g_.IncomingEdgeCount(v);
-    }
-
-    size_t LockingOutgoingCount(VertexId v) const {
-        VertexLockT lock(v);
-        return g_.OutgoingEdgeCount(v);
-    }
-
-    std::vector<VertexId> LockingNextVertices(VertexId v) const {
-        VertexLockT lock(v);
-        std::vector<VertexId> answer;
-        for (EdgeId e : g_.OutgoingEdges(v)) {
-            answer.push_back(g_.EdgeEnd(e));
-        }
-        return answer;
-    }
-
-    std::vector<VertexId> FilterBranchingVertices(const std::vector<VertexId> &vertices) const {
-        std::vector<VertexId> answer;
-        for (VertexId v : vertices) {
-            VertexLockT lock(v);
-            if (!IsBranching(v)) {
-                answer.push_back(v);
-            }
-        }
-        return answer;
-    }
-
-    //correctly handles self-conjugate case
-    bool IsMinimal(VertexId v1, VertexId v2) const {
-        return !(g_.conjugate(v2) < v1);
-    }
-
-    //true if need to go further, false if stop on any reason!
-    //to_compress is not empty only if compression needs to be done
-    //don't need additional checks for v == init | conjugate(init), because init is branching!
-    //fixme what about plasmids?! =)
-    bool ProcessNextAndGo(VertexId& v, VertexId init, std::vector<VertexId> &to_compress) {
-        VertexLockT lock(v);
-        if (!CheckConsistent(v)) {
-            to_compress.clear();
-            return false;
-        }
-        if (IsBranching(v)) {
-            if (!IsMinimal(init, v)) {
-                to_compress.clear();
-            }
-            return false;
-        } else {
-            to_compress.push_back(v);
-            v = g_.EdgeEnd(g_.GetUniqueOutgoingEdge(v));
-            return true;
-        }
-    }
-
-    void UnlinkEdge(VertexId v, EdgeId e) {
-        VertexLockT lock(v);
-        helper_.DeleteLink(v, e);
-    }
-
-    void UnlinkEdges(VertexId v) {
-        VertexLockT lock(v);
-        helper_.DeleteLink(v, g_.GetUniqueOutgoingEdge(v));
-        helper_.DeleteLink(g_.conjugate(v), g_.GetUniqueOutgoingEdge(g_.conjugate(v)));
-    }
-
-    //fixme duplication with abstract conj graph
-    //not locking!
-    std::vector<EdgeId> EdgesToDelete(const std::vector<EdgeId> &path) const {
-        std::set<EdgeId> edgesToDelete;
-        edgesToDelete.insert(path[0]);
-        for (size_t i = 0; i + 1 < path.size(); i++) {
-            EdgeId e = path[i + 1];
-            if (edgesToDelete.find(g_.conjugate(e)) == edgesToDelete.end())
-                edgesToDelete.insert(e);
-        }
-        return std::vector<EdgeId>(edgesToDelete.begin(), edgesToDelete.end());
-    }
-
-    //not locking!
-    //fixme duplication with abstract conj graph
-    std::vector<VertexId> VerticesToDelete(const std::vector<EdgeId> &path) const {
-        std::set<VertexId> verticesToDelete;
-        for (size_t i = 0; i + 1 < path.size(); i++) {
-            EdgeId e = path[i + 1];
-            VertexId v = g_.EdgeStart(e);
-            if (verticesToDelete.find(g_.conjugate(v)) == verticesToDelete.end())
-                verticesToDelete.insert(v);
-        }
-        return std::vector<VertexId>(verticesToDelete.begin(), verticesToDelete.end());
-    }
-    //todo end duplication with abstract conj graph
-
-    //not locking!
-    std::vector<EdgeId> CollectEdges(const std::vector<VertexId> &to_compress) const {
-        std::vector<EdgeId> answer;
-        answer.push_back(g_.GetUniqueIncomingEdge(to_compress.front()));
-        for (VertexId v : to_compress) {
-            answer.push_back(g_.GetUniqueOutgoingEdge(v));
-        }
-        return answer;
-    }
+    //path starting with the edge going out of the branching vertex,
+    //empty if there is nothing to merge or the conjugate path is to be merged instead
+    std::vector<EdgeId> CollectPath(EdgeId e) const {
+        std::vector<EdgeId> path = {e};
+        for (VertexId v = g_.EdgeEnd(e); !IsBranching(v); v = g_.EdgeEnd(path.back()))
+            path.push_back(g_.GetUniqueOutgoingEdge(v));
 
-    void CallHandlers(const std::vector<EdgeId> &edges, EdgeId new_edge) const {
-        g_.FireMerge(edges, new_edge);
-        g_.FireDeletePath(EdgesToDelete(edges), VerticesToDelete(edges));
-        g_.FireAddEdge(new_edge);
-    }
-
-    EdgeData MergedData(const std::vector<EdgeId> &edges) const {
-        std::vector<const EdgeData *> to_merge;
-        std::vector<uint32_t> overlaps;
-        for (auto it1 = edges.begin(), it2 = std::next(edges); it2 != edges.end(); ++it1, ++it2) {
-            to_merge.push_back(&(g_.data(*it1)));
-            uint32_t overlap = g_.data(g_.EdgeEnd(*it1));
-            overlaps.push_back(overlap);
-        }
-        to_merge.push_back(&(g_.data(edges.back())));
-        return g_.master().MergeData(to_merge, overlaps);
-    }
-
-    EdgeId SyncAddEdge(VertexId v1, VertexId v2, const EdgeData& data, restricted::IdDistributor& id_distributor) {
-        EdgeId new_edge = helper_.AddEdge(data, id_distributor);
-        {
-            VertexLockT lock(v1);
-            helper_.LinkOutgoingEdge(v1, new_edge);
-        }
-        if (g_.conjugate(new_edge) != new_edge) {
-            VertexLockT lock(v2);
-            helper_.LinkIncomingEdge(v2, new_edge);
-        }
-        return new_edge;
+        if (path.size() == 1 || !(path.front() < g_.conjugate(path.back())))
+            return {};
+        return path;
     }
 
-    void ProcessBranching(VertexId next, VertexId init, size_t idx) {
-        std::vector<VertexId> to_compress;
-        while (ProcessNextAndGo(next, init, to_compress)) {
-        }
-
-        if (!to_compress.empty()) {
-            //here we are sure that we are the ones to process the path
-            //so we can collect edges without any troubles (and actually without locks todo check!)
-            auto edges = CollectEdges(to_compress);
-
-            auto id_distributor = segment_storage_->GetSegmentIdDistributor(2 * idx, 2 * idx + 1);
-
-            EdgeId new_edge = SyncAddEdge(g_.EdgeStart(edges.front()), g_.EdgeEnd(edges.back()),
-                                          MergeSequences(g_, edges), id_distributor);
-
-            CallHandlers(edges, new_edge);
-
-            VertexId final = g_.EdgeEnd(edges.back());
-            UnlinkEdge(init, edges.front());
-            for (VertexId v : VerticesToDelete(edges/*to_compress*/)) {
-                UnlinkEdges(v);
-            }
-
-            if (g_.conjugate(new_edge) != new_edge) {
-                UnlinkEdge(g_.conjugate(final), g_.conjugate(edges.back()));
-            }
-
-            for (EdgeId e : EdgesToDelete(edges)) {
-                helper_.DeleteUnlinkedEdge(e);
+    std::vector<std::vector<EdgeId>> CollectPaths() const {
+        auto chunks = omnigraph::IterationHelper<Graph, VertexId>(g_).Chunks(chunk_cnt_);
+        std::vector<std::vector<std::vector<EdgeId>>> chunk_paths(chunks.size() - 1);
+        #pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < chunks.size() - 1; ++i) {
+            for (auto it = chunks[i]; it != chunks[i + 1]; ++it) {
+                VertexId v = *it;
+                if (!IsBranching(v))
+                    continue;
+                for (EdgeId e : g_.OutgoingEdges(v)) {
+                    auto path = CollectPath(e);
+                    if (!path.empty())
+                        chunk_paths[i].push_back(std::move(path));
+                }
             }
         }
-    }
-
-    //vertex is not consistent if the path has already been compressed or under compression right now
-    //not needed here, but could check if vertex is fully isolated
-    bool CheckConsistent(VertexId v) const {
-        //todo change to incoming edge count
-        return g_.OutgoingEdgeCount(g_.conjugate(v)) > 0;
-    }
-
-    //long, but safe way to get left neighbour
-    //heavily relies on the current graph structure!
-    VertexId LockingGetInit(VertexId v) {
-        VertexLockT lock(v);
-        if (!CheckConsistent(v))
-            return VertexId();
 
-        //works even if this edge is already unlinked from the vertex =)
-        VERIFY(g_.CheckUniqueIncomingEdge(v));
-        return g_.EdgeStart(g_.GetUniqueIncomingEdge(v));
+        std::vector<std::vector<EdgeId>> paths;
+        for (auto &chunk : chunk_paths)
+            std::move(chunk.begin(), chunk.end(), std::back_inserter(paths));
+        return paths;
     }
 
 public:
+    ParallelCompressor(Graph &g, size_t chunk_cnt, bool safe_merging = true)
+            : g_(g), chunk_cnt_(chunk_cnt), safe_merging_(safe_merging) {}
 
-    ParallelCompressor(Graph& g)
-            : g_(g),
-              helper_(g_.GetConstructionHelper()) {
+    //returns the number of merged paths
+    size_t Run() {
+        auto paths = CollectPaths();
+        DEBUG("Paths to merge: " << paths.size());
+        if (paths.empty())
+            return 0;
 
-    }
-
-    //returns true iff v is the "leftmost" vertex to compress in the chain
-    bool IsOfInterest(VertexId v) const {
-        return !IsBranching(v) && IsBranching(g_.EdgeStart(g_.GetUniqueIncomingEdge(v)));
-    }
-
-    void PrepareForProcessing(size_t interesting_cnt) {
-        segment_storage_ = std::make_unique<restricted::IdSegmentStorage>(g_.GetGraphIdDistributor().Reserve(interesting_cnt * 2));
-    }
+        std::vector<std::optional<EdgeData>> merged(paths.size());
+        #pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < paths.size(); ++i)
+            merged[i].emplace(g_.MergedData(paths[i], safe_merging_));
 
-    bool Process(VertexId v, size_t idx) {
-        VertexId init = LockingGetInit(v);
-        if (init != VertexId())
-            ProcessBranching(v, init, idx);
-        return false;
-    }
+        //new edges and their conjugates should not relocate the storage
+        g_.ereserve(g_.max_eid() + 2 * paths.size());
+        g_.StartConcurrentModification();
+        #pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < paths.size(); ++i) {
+            const auto &path = paths[i];
+            omnigraph::VertexTransaction<Graph> lock(g_, {g_.EdgeStart(path.front()), g_.EdgeEnd(path.back())},
+                                                     /*flush events*/false);
+            g_.ReplacePath(path, std::move(*merged[i]));
+            merged[i].reset();
+        }
+        g_.FinishConcurrentModification();
 
-    bool ShouldFilterConjugate() const {
-        return false;
+        return paths.size();
     }
 
+private:
+    DECL_LOGGER("ParallelCompressor");
 };
 
-
 //todo add conjugate filtration
 template<class Graph, class ElementType>
 class AlgorithmRunner {
@@ -728,13 +586,11 @@ bool RunEdgeAlgorithm(Graph& g, AlgoRunner& runner, Algo& algo, size_t chunk_cnt
     return runner.RunFromChunkIterators(algo, omnigraph::IterationHelper<Graph, typename Graph::EdgeId>(g).Chunks(chunk_cnt));
 }
 
-//Deprecated
 template<class Graph>
 void ParallelCompress(Graph &g, size_t chunk_cnt, bool loop_post_compression = true) {
     INFO("Parallel compression");
-    debruijn::simplification::ParallelCompressor<Graph> compressor(g);
-    TwoStepAlgorithmRunner<Graph, typename Graph::VertexId> runner(g, false);
-    RunVertexAlgorithm(g, runner, compressor, chunk_cnt);
+    size_t merged = debruijn::simplification::ParallelCompressor<Graph>(g, chunk_cnt).Run();
+    INFO(merged << " paths merged");
 
     //have to call cleaner to get rid of new isolated vertices
     omnigraph::Cleaner<Graph>(g, chunk_cnt).Run();
@@ -759,7 +615,9 @@ bool ParallelClipTips(Graph &g,
 
     AlgorithmRunner<Graph, typename Graph::VertexId> runner(g);
 
+    g.StartConcurrentModification();
     RunVertexAlgorithm(g, runner, tip_clipper, chunk_cnt);
+    g.FinishConcurrentModification();
 
     ParallelCompress(g, chunk_cnt);
     //Cleaner is launched inside ParallelCompression
@@ -817,7 +675,9 @@ bool ParallelEC(Graph &g,
 
     TwoStepAlgorithmRunner<Graph, typename Graph::EdgeId> runner(g, true);
 
+    g.StartConcurrentModification();
     RunEdgeAlgorithm(g, runner, ec_remover, chunk_cnt);
+    g.FinishConcurrentModification();
 
     critical_marker.ClearMarks();
 
@@ -25,6 +25,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include "index_point.hpp"
+#include "histogram_kernels.hpp"
 
 namespace omnigraph {
 
@@ -84,19 +85,33 @@ public:
         min_value_ = rounded_d(point);
         max_value_ = rounded_d(points_.back());
         size_t begin = 0;
+        std::vector<int> dists;
+        std::vector<double> weights, table, vals;
         for (size_t i = 0; i < points_.size(); ++i) {
             if (i == points_.size() - 1 || IsANewCluster(i)) {
                 int low_val = rounded_d(points_[begin]);
                 int high_val = rounded_d(points_[i]);
                 size_t new_begin = new_data.size();
                 VERIFY(low_val <= high_val);
-                for (int j = low_val; j <= high_val; ++j) {
-                    double val = 0.;
-                    for (size_t k = begin; k <= i; ++k) {
-                        val += points_[k].weight * weight_f(j - rounded_d(points_[k]));
-                    }
-                    new_data.emplace_back(ep.first, ep.second, j, val, 0.);
+
+                // Tabulate the weight function over all the differences
+                // between the points of the cluster and convolve densely
+                int span = high_val - low_val;
+                table.resize(2 * span + 1);
+                for (int t = -span; t <= span; ++t)
+                    table[t + span] = weight_f(t);
+                dists.clear();
+                weights.clear();
+                for (size_t k = begin; k <= i; ++k) {
+                    dists.push_back(rounded_d(points_[k]));
+                    weights.push_back(points_[k].weight);
                 }
+                vals.resize(span + 1);
+                kernels::ConvolveWeights(dists.data(), weights.data(), dists.size(),
+                                         table.data(), -span, low_val, vals.size(), vals.data());
+
+                for (int j = low_val; j <= high_val; ++j)
+                    new_data.emplace_back(ep.first, ep.second, j, vals[j - low_val], 0.);
                 size_t new_end = new_data.size();
                 answer.emplace_back(new_begin, new_end);
 
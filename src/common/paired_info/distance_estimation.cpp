@@ -24,24 +24,31 @@ std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, Edg
 }
 
 void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
-    std::vector<size_t> path_lower_bounds;
+    if (snapshot_)
+        FillGraphDistancesLengths(*snapshot_, e1, second_edges);
+    else
+        FillGraphDistancesLengths(graph_, e1, second_edges);
+}
+
+template<class G>
+void GraphDistanceFinder::FillGraphDistancesLengths(const G &g, EdgeId e1, LengthMap &second_edges) const {
     size_t path_upper_bound = PairInfoPathLengthUpperBound(graph_.k(), insert_size_, delta_);
-    PathProcessor <Graph> paths_proc(graph_, graph_.EdgeEnd(e1), path_upper_bound);
+    PathProcessor<G> paths_proc(g, g.EdgeEnd(e1), path_upper_bound);
 
     for (auto &entry : second_edges) {
         EdgeId e2 = entry.first;
-        size_t path_lower_bound = PairInfoPathLengthLowerBound(graph_.k(), graph_.length(e1),
-                                                               graph_.length(e2), gap_, delta_);
+        size_t path_lower_bound = PairInfoPathLengthLowerBound(graph_.k(), g.length(e1),
+                                                               g.length(e2), gap_, delta_);
 
         TRACE("Bounds for paths are " << path_lower_bound << " " << path_upper_bound);
 
-        DistancesLengthsCallback<Graph> callback(graph_);
-        paths_proc.Process(graph_.EdgeStart(e2), path_lower_bound, path_upper_bound, callback);
+        DistancesLengthsCallback<G> callback(g);
+        paths_proc.Process(g.EdgeStart(e2), path_lower_bound, path_upper_bound, callback);
         GraphLengths lengths = callback.distances();
         for (size_t j = 0; j < lengths.size(); ++j) {
-            lengths[j] += graph_.length(e1);
+            lengths[j] += g.length(e1);
             TRACE("Resulting distance set for " <<
-                                                " edge " << graph_.int_id(e2) <<
+                                                " edge " << g.int_id(e2) <<
                                                 " #" << j << " length " << lengths[j]);
         }
 
@@ -9,10 +9,12 @@
 #ifndef DISTANCE_ESTIMATION_HPP_
 #define DISTANCE_ESTIMATION_HPP_
 
+#include "frozen_paired_info.hpp"
 #include "paired_info.hpp"
 #include "pair_info_bounds.hpp"
 
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/core/graph_snapshot.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 
 #include "math/xmath.h"
@@ -28,8 +30,12 @@ class GraphDistanceFinder {
     typedef std::map<debruijn_graph::EdgeId, GraphLengths> LengthMap;
 
 public:
-    GraphDistanceFinder(const debruijn_graph::Graph &graph, size_t insert_size, size_t read_length, size_t delta) :
-            graph_(graph), insert_size_(insert_size), gap_((int) (insert_size - 2 * read_length)),
+    typedef GraphSnapshot<debruijn_graph::Graph> Snapshot;
+
+    // Paths are searched in the snapshot of the graph if it is provided
+    GraphDistanceFinder(const debruijn_graph::Graph &graph, size_t insert_size, size_t read_length, size_t delta,
+                        const Snapshot *snapshot = nullptr) :
+            graph_(graph), snapshot_(snapshot), insert_size_(insert_size), gap_((int) (insert_size - 2 * read_length)),
             delta_((double) delta) { }
 
     std::vector<size_t> GetGraphDistancesLengths(debruijn_graph::EdgeId e1, debruijn_graph::EdgeId e2) const;
@@ -38,8 +44,12 @@ public:
     void FillGraphDistancesLengths(debruijn_graph::EdgeId e1, LengthMap &second_edges) const;
 
 private:
+    template<class Graph>
+    void FillGraphDistancesLengths(const Graph &g, debruijn_graph::EdgeId e1, LengthMap &second_edges) const;
+
     DECL_LOGGER("GraphDistanceFinder");
     const debruijn_graph::Graph &graph_;
+    const Snapshot *snapshot_;
     const size_t insert_size_;
     const int gap_;
     const double delta_;
@@ -47,7 +57,7 @@ private:
 
 class AbstractDistanceEstimator {
 protected:
-    typedef UnclusteredPairedInfoIndexT<debruijn_graph::Graph> InPairedIndex;
+    typedef FrozenUnclusteredPairedInfoIndexT<debruijn_graph::Graph> InPairedIndex;
     typedef PairedInfoIndexT<debruijn_graph::Graph> OutPairedIndex;
     typedef typename InPairedIndex::HistProxy InHistogram;
     typedef typename OutPairedIndex::Histogram OutHistogram;
@@ -80,7 +80,7 @@ void RefinePairedInfo(PairedInfoIndexT<Graph>& clustered_index, const Graph& gra
 
 void EstimateScaffoldingDistances(PairedInfoIndexT<Graph> &scaffolding_index,
                                   const Graph &graph, const io::SequencingLibrary<config::LibraryData> &lib,
-                                  const UnclusteredPairedInfoIndexT<Graph> &paired_index,
+                                  const FrozenUnclusteredPairedInfoIndexT<Graph> &paired_index,
                                   const debruijn_graph::config::smoothing_distance_estimator &ade,
                                   const debruijn_graph::config::distance_estimator &de_config) {
     INFO("Filling scaffolding index");
@@ -88,9 +88,10 @@ void EstimateScaffoldingDistances(PairedInfoIndexT<Graph> &scaffolding_index,
     double is_var = lib.data().insert_size_deviation;
     size_t delta = size_t(is_var);
     size_t linkage_distance = size_t(de_config.linkage_distance_coeff * is_var);
+    GraphDistanceFinder::Snapshot snapshot(graph);
     GraphDistanceFinder dist_finder(graph,
                                     (size_t) math::round(lib.data().mean_insert_size),
-                                    lib.data().unmerged_read_length, delta);
+                                    lib.data().unmerged_read_length, delta, &snapshot);
     size_t max_distance = size_t(de_config.max_distance_coeff_scaff * is_var);
 
     DEBUG("Retaining insert size distribution for it");
@@ -120,12 +121,14 @@ void EstimateScaffoldingDistances(PairedInfoIndexT<Graph> &scaffolding_index,
 void EstimatePairedDistances(PairedInfoIndexT<Graph> &clustered_index,
                              const Graph &graph,
                              const io::SequencingLibrary<config::LibraryData> &lib,
-                             const UnclusteredPairedInfoIndexT<Graph> &paired_index,
+                             const FrozenUnclusteredPairedInfoIndexT<Graph> &paired_index,
                              size_t max_repeat_length,
                              const debruijn_graph::config::distance_estimator &de_config) {
     size_t delta = size_t(lib.data().insert_size_deviation);
     size_t linkage_distance = size_t(de_config.linkage_distance_coeff * lib.data().insert_size_deviation);
-    GraphDistanceFinder dist_finder(graph, (size_t)math::round(lib.data().mean_insert_size), lib.data().unmerged_read_length, delta);
+    GraphDistanceFinder::Snapshot snapshot(graph);
+    GraphDistanceFinder dist_finder(graph, (size_t)math::round(lib.data().mean_insert_size), lib.data().unmerged_read_length, delta,
+                                    &snapshot);
     size_t max_distance = size_t(de_config.max_distance_coeff * lib.data().insert_size_deviation);
 
     PairInfoWeightChecker<Graph> checker(graph, de_config.clustered_filter_threshold);
@@ -20,7 +20,7 @@ namespace distance_estimation {
 using omnigraph::de::AbstractDistanceEstimator;
 using omnigraph::de::AbstractPairInfoChecker;
 using omnigraph::de::PairedInfoIndexT;
-using omnigraph::de::UnclusteredPairedInfoIndexT;
+using omnigraph::de::FrozenUnclusteredPairedInfoIndexT;
 
 void EstimateWithEstimator(PairedInfoIndexT<debruijn_graph::Graph> &clustered_index,
                            const AbstractDistanceEstimator &estimator,
@@ -32,7 +32,7 @@ void RefinePairedInfo(PairedInfoIndexT<debruijn_graph::Graph>& clustered_index,
 void EstimateScaffoldingDistances(PairedInfoIndexT<debruijn_graph::Graph> &scaffolding_index,
                                   const debruijn_graph::Graph &graph,
                                   const io::SequencingLibrary<debruijn_graph::config::LibraryData> &lib,
-                                  const UnclusteredPairedInfoIndexT<debruijn_graph::Graph> &paired_index,
+                                  const FrozenUnclusteredPairedInfoIndexT<debruijn_graph::Graph> &paired_index,
                                   const debruijn_graph::config::smoothing_distance_estimator &ade,
                                   const debruijn_graph::config::distance_estimator &de_config =
                                   debruijn_graph::config::distance_estimator());
@@ -40,7 +40,7 @@ void EstimateScaffoldingDistances(PairedInfoIndexT<debruijn_graph::Graph> &scaff
 void EstimatePairedDistances(PairedInfoIndexT<debruijn_graph::Graph> &clustered_index,
                              const debruijn_graph::Graph &graph,
                              const io::SequencingLibrary<debruijn_graph::config::LibraryData> &lib,
-                             const UnclusteredPairedInfoIndexT<debruijn_graph::Graph> &paired_index,
+                             const FrozenUnclusteredPairedInfoIndexT<debruijn_graph::Graph> &paired_index,
                              size_t max_repeat_length = std::numeric_limits<size_t>::max(),
                              const debruijn_graph::config::distance_estimator &de_config =
                              debruijn_graph::config::distance_estimator());
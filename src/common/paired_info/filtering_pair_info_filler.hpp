@@ -0,0 +1,344 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "pair_info_filler.hpp"
+
+#include "utils/filesystem/file_limit.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+namespace debruijn_graph {
+
+/**
+ * Fills the paired index in a single pass over the library dropping the edge
+ * pairs supported by at most filter_threshold occurrences. The condition is
+ * the same as the one checked by LatePairedIndexFiller with the edge pair
+ * filter (see paired_info::FillEdgePairFilter), but the counts are exact and
+ * no separate mapping pass is needed.
+ *
+ * Points are collected into per-thread buffers keyed by the canonical edge
+ * pair. Full buffers are sorted and spilled to disk as runs, which are merged
+ * in the end. Every run is split into partitions by the first edge of the
+ * pair, so the partitions are merged in parallel. Every thread keeps at most
+ * max_merged_runs runs open, if there are more runs, they are merged into the
+ * larger ones first.
+ */
+class FilteringPairedIndexFiller : public SequenceMapperListener {
+    typedef std::pair<EdgeId, EdgeId> EdgePair;
+    typedef omnigraph::de::RawPointTraits Traits;
+
+    // Point stored for the canonical edge pair, distance is relative to the
+    // end of the first edge of the pair the point was added for, i.e. the
+    // same inner point the paired index stores.
+    struct Entry {
+        EdgeId e1, e2;
+        omnigraph::de::DEGap gap;
+        uint32_t part;
+
+        bool operator<(const Entry &other) const {
+            return std::tie(part, e1, e2) < std::tie(other.part, other.e1, other.e2);
+        }
+
+        bool same_pair(const Entry &other) const {
+            return e1 == other.e1 && e2 == other.e2;
+        }
+    };
+
+    // Open files besides the runs (reads, logs, etc.)
+    static constexpr size_t RESERVED_FILES = 64;
+
+    struct Run {
+        fs::TmpFile file;
+        std::vector<size_t> starts; // offsets of partitions in entries, parts + 1 values
+    };
+
+  public:
+    FilteringPairedIndexFiller(const Graph &graph,
+                               unsigned filter_threshold, unsigned round_distance,
+                               omnigraph::de::UnclusteredPairedInfoIndexT<Graph> &paired_index,
+                               fs::TmpDir workdir,
+                               size_t buffer_size = 1 << 20,
+                               size_t max_merged_runs = 64)
+            : graph_(graph),
+              filter_threshold_(filter_threshold),
+              round_distance_(round_distance),
+              paired_index_(paired_index),
+              buffer_pi_(graph),
+              workdir_(std::move(workdir)),
+              buffer_size_(buffer_size),
+              max_merged_runs_(max_merged_runs),
+              parts_(0) {
+        VERIFY(max_merged_runs_ > 1);
+    }
+
+    void StartProcessLibrary(size_t threads_count) override {
+        buffer_pi_.clear();
+        runs_.clear();
+        buffers_.clear();
+        buffers_.resize(threads_count);
+        parts_ = 16 * threads_count;
+    }
+
+    void StopProcessLibrary() override {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < buffers_.size(); ++i)
+            Spill(buffers_[i]);
+        buffers_.clear();
+
+        INFO("Merging " << runs_.size() << " runs of edge pairs");
+        CompactRuns(MergedRunsLimit());
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (size_t part = 0; part < parts_; ++part)
+            Merge(part);
+
+        runs_.clear();
+        paired_index_.MoveAssign(buffer_pi_);
+        buffer_pi_.clear();
+    }
+
+    void ProcessPairedRead(size_t idx,
+                           const io::PairedRead& r,
+                           const MappingPath<EdgeId>& read1,
+                           const MappingPath<EdgeId>& read2) override {
+        ProcessPairedRead(buffers_[idx], read1, read2, r.distance());
+    }
+
+    void ProcessPairedRead(size_t idx,
+                           const io::PairedReadSeq& r,
+                           const MappingPath<EdgeId>& read1,
+                           const MappingPath<EdgeId>& read2) override {
+        ProcessPairedRead(buffers_[idx], read1, read2, r.distance());
+    }
+
+  private:
+    void ProcessPairedRead(std::vector<Entry> &buffer,
+                           const MappingPath<EdgeId>& path1,
+                           const MappingPath<EdgeId>& path2, size_t read_distance) {
+        for (size_t i = 0; i < path1.size(); ++i) {
+            const auto &mapping_edge_1 = path1[i];
+            for (size_t j = 0; j < path2.size(); ++j) {
+                const auto &mapping_edge_2 = path2[j];
+                int edge_distance = PairedEdgeDistance(graph_, mapping_edge_1, mapping_edge_2,
+                                                       read_distance, round_distance_);
+
+                EdgeId e1 = mapping_edge_1.first, e2 = mapping_edge_2.first;
+                EdgePair ep(e1, e2), conj(graph_.conjugate(e2), graph_.conjugate(e1));
+                const EdgePair &canonical = std::min(ep, conj);
+                auto sp = Traits::Shrink(omnigraph::de::RawPoint(edge_distance, 1.),
+                                         omnigraph::de::DEDistance(graph_.length(e1)));
+                buffer.push_back({ canonical.first, canonical.second, sp.d, 0 });
+            }
+        }
+
+        if (buffer.size() >= buffer_size_)
+            Spill(buffer);
+    }
+
+    uint32_t Partition(EdgeId e) const {
+        return uint32_t(e.hash() % parts_);
+    }
+
+    void Spill(std::vector<Entry> &buffer) {
+        if (buffer.empty())
+            return;
+
+        for (auto &entry : buffer)
+            entry.part = Partition(entry.e1);
+        std::sort(buffer.begin(), buffer.end());
+
+        Run run;
+        run.file = fs::tmp::make_temp_file("pairs", workdir_);
+        run.starts.reserve(parts_ + 1);
+        for (size_t part = 0, pos = 0; part <= parts_; ++part) {
+            while (pos < buffer.size() && buffer[pos].part < part)
+                pos += 1;
+            run.starts.push_back(pos);
+        }
+
+        std::ofstream os(run.file->file(), std::ios::binary);
+        os.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(Entry));
+        CHECK_FATAL_ERROR(os, "Failed to write edge pairs into " << run.file->file());
+        os.close();
+        buffer.clear();
+
+        std::lock_guard<std::mutex> lock(runs_mutex_);
+        runs_.push_back(std::move(run));
+    }
+
+    // Sequential reader of the partitions [from, to) of a run
+    class RunReader {
+        static constexpr size_t CHUNK_SIZE = 1 << 12;
+
+      public:
+        RunReader(const Run &run, size_t from, size_t to)
+                : is_(run.file->file(), std::ios::binary),
+                  left_(run.starts[to] - run.starts[from]), pos_(0) {
+            CHECK_FATAL_ERROR(is_, "Failed to open edge pairs file " << run.file->file());
+            is_.seekg(std::streamoff(run.starts[from] * sizeof(Entry)));
+            Fetch();
+        }
+
+        bool empty() const { return pos_ == chunk_.size(); }
+        const Entry &top() const { return chunk_[pos_]; }
+
+        void pop() {
+            if (++pos_ == chunk_.size())
+                Fetch();
+        }
+
+      private:
+        void Fetch() {
+            chunk_.resize(std::min(left_, CHUNK_SIZE));
+            is_.read(reinterpret_cast<char*>(chunk_.data()), chunk_.size() * sizeof(Entry));
+            VERIFY(is_);
+            left_ -= chunk_.size();
+            pos_ = 0;
+        }
+
+        std::ifstream is_;
+        std::vector<Entry> chunk_;
+        size_t left_;
+        size_t pos_;
+    };
+
+    // Number of the runs every thread could keep open, raises the open file
+    // limit if needed
+    size_t MergedRunsLimit() const {
+        size_t nthreads = omp_get_max_threads();
+        size_t needed = std::min(runs_.size(), max_merged_runs_);
+        size_t file_limit = nthreads * needed + RESERVED_FILES;
+        size_t res = utils::limit_file(file_limit);
+        if (res >= file_limit)
+            return max_merged_runs_;
+
+        WARN("Failed to setup necessary limit for number of open files, runs of edge pairs will be merged in more steps");
+        WARN("Do 'ulimit -n " << file_limit << "' in the console to overcome the limit");
+        return std::max<size_t>(2, (res - std::min<size_t>(res, RESERVED_FILES)) / nthreads);
+    }
+
+    // Merges the partitions [from, to) of the runs [first, last) passing the
+    // entries to the handler in order
+    template<class Handler>
+    void MergeRuns(size_t first, size_t last, size_t from, size_t to, Handler &&handler) const {
+        std::vector<RunReader> readers;
+        readers.reserve(last - first);
+        for (size_t i = first; i < last; ++i) {
+            if (runs_[i].starts[from] != runs_[i].starts[to])
+                readers.emplace_back(runs_[i], from, to);
+        }
+
+        auto greater = [&](size_t a, size_t b) { return readers[b].top() < readers[a].top(); };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> queue(greater);
+        for (size_t i = 0; i < readers.size(); ++i)
+            queue.push(i);
+
+        while (!queue.empty()) {
+            size_t i = queue.top();
+            queue.pop();
+            handler(readers[i].top());
+            readers[i].pop();
+            if (!readers[i].empty())
+                queue.push(i);
+        }
+    }
+
+    // Merges the runs [first, last) into a single one
+    Run MergeRuns(size_t first, size_t last) const {
+        Run run;
+        run.file = fs::tmp::make_temp_file("pairs", workdir_);
+        run.starts.reserve(parts_ + 1);
+        std::ofstream os(run.file->file(), std::ios::binary);
+
+        std::vector<Entry> chunk;
+        size_t written = 0;
+        auto write = [&]() {
+            os.write(reinterpret_cast<const char*>(chunk.data()), chunk.size() * sizeof(Entry));
+            written += chunk.size();
+            chunk.clear();
+        };
+        MergeRuns(first, last, 0, parts_, [&](const Entry &entry) {
+            if (chunk.size() == buffer_size_)
+                write();
+            while (run.starts.size() <= entry.part)
+                run.starts.push_back(written + chunk.size());
+            chunk.push_back(entry);
+        });
+        write();
+        while (run.starts.size() <= parts_)
+            run.starts.push_back(written);
+
+        CHECK_FATAL_ERROR(os, "Failed to write edge pairs into " << run.file->file());
+        return run;
+    }
+
+    // Merges the runs until there are at most max_runs of them
+    void CompactRuns(size_t max_runs) {
+        while (runs_.size() > max_runs) {
+            size_t n = (runs_.size() + max_runs - 1) / max_runs;
+            INFO("Merging " << runs_.size() << " runs of edge pairs into " << n);
+            std::vector<Run> runs(n);
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (size_t i = 0; i < n; ++i)
+                runs[i] = MergeRuns(i * max_runs, std::min(runs_.size(), (i + 1) * max_runs));
+            runs_ = std::move(runs);
+        }
+    }
+
+    void Merge(size_t part) {
+        std::vector<Entry> group;
+        MergeRuns(0, runs_.size(), part, part + 1, [&](const Entry &entry) {
+            if (!group.empty() && !group.back().same_pair(entry)) {
+                Flush(group);
+                group.clear();
+            }
+            group.push_back(entry);
+        });
+        Flush(group);
+    }
+
+    void Flush(const std::vector<Entry> &group) {
+        if (group.empty())
+            return;
+
+        EdgeId e1 = group.front().e1, e2 = group.front().e2;
+        // Edge pair filter counts every occurrence for the pair and its
+        // conjugate, which is the same pair if the pair is self-conjugate
+        size_t count = group.size() * (e1 == graph_.conjugate(e2) ? 2 : 1);
+        if (count <= filter_threshold_)
+            return;
+
+        omnigraph::de::DEDistance offset(graph_.length(e1));
+        for (const auto &entry : group)
+            buffer_pi_.Add(e1, e2, Traits::Expand(Traits::Gapped(entry.gap, 1.), offset));
+    }
+
+    const Graph &graph_;
+    unsigned filter_threshold_;
+    unsigned round_distance_;
+    omnigraph::de::UnclusteredPairedInfoIndexT<Graph> &paired_index_;
+    omnigraph::de::ConcurrentPairedInfoBuffer<Graph> buffer_pi_;
+    fs::TmpDir workdir_;
+    size_t buffer_size_;
+    size_t max_merged_runs_;
+    size_t parts_;
+
+    std::vector<std::vector<Entry>> buffers_;
+    std::vector<Run> runs_;
+    std::mutex runs_mutex_;
+
+    DECL_LOGGER("FilteringPairedIndexFiller");
+};
+
+}
@@ -0,0 +1,421 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "paired_info.hpp"
+
+#include "utils/verify.hpp"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace omnigraph {
+
+namespace de {
+
+/**
+ * @brief Immutable compressed (CSR-like) copy of the paired index used when
+ *        the index is completely filled, e.g. during distance estimation.
+ * @detail All the data is stored in a few contiguous arrays:
+ *         - the neighbourhoods of the first edges indexed by their ids;
+ *         - the sorted second edges of every neighbourhood along with the
+ *           spans of their histograms;
+ *         - the points of all the histograms.
+ *         Points of conjugate pairs are stored once, just like the source index
+ *         shares the histograms between them. Histograms of canonical pairs
+ *         are laid out in the order of their first edges, so traversing half
+ *         neighbourhoods of the edges in id order is sequential in memory.
+ *         The read API is the same as the one of PairedIndex.
+ */
+template<typename G, typename Traits>
+class FrozenPairedIndex {
+    typedef typename Traits::Gapped InnerPoint;
+    typedef omnigraph::de::StrongWeakPtr<omnigraph::de::Histogram<InnerPoint>> InnerHistPtr;
+
+  public:
+    typedef G Graph;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef std::pair<EdgeId, EdgeId> EdgePair;
+    typedef typename Traits::Expanded Point;
+    typedef omnigraph::de::Histogram<Point> Histogram;
+
+  private:
+    struct Column {
+        EdgeId edge;
+        size_t offset; // of the first point of the histogram
+        size_t size;
+
+        bool operator<(const Column &other) const {
+            return edge < other.edge;
+        }
+    };
+
+    typedef typename std::vector<Column>::const_iterator ColumnIterator;
+
+  public:
+    /**
+     * @brief Proxy set of points between two edges, see PairedIndex::HistProxy.
+     */
+    class HistProxy {
+      public:
+        class Iterator: public boost::iterator_facade<Iterator, Point, boost::random_access_traversal_tag, Point> {
+          public:
+            Iterator(const InnerPoint *ptr, DEDistance offset)
+                    : ptr_(ptr), offset_(offset) {}
+
+          private:
+            friend class boost::iterator_core_access;
+
+            Point dereference() const {
+                return Traits::Expand(*ptr_, offset_);
+            }
+
+            void increment() { ++ptr_; }
+            void decrement() { --ptr_; }
+            void advance(ptrdiff_t n) { ptr_ += n; }
+            ptrdiff_t distance_to(const Iterator &other) const { return other.ptr_ - ptr_; }
+
+            bool equal(const Iterator &other) const {
+                return ptr_ == other.ptr_;
+            }
+
+            const InnerPoint *ptr_;
+            DEDistance offset_;
+        };
+
+        HistProxy(const InnerPoint *begin = nullptr, const InnerPoint *end = nullptr, DEDistance offset = 0)
+                : begin_(begin), end_(end), offset_(offset) {}
+
+        Iterator begin() const { return Iterator(begin_, offset_); }
+        Iterator end() const { return Iterator(end_, offset_); }
+
+        /**
+         * @brief Finds the point with the minimal distance.
+         */
+        Point min() const {
+            VERIFY(!empty());
+            return *begin();
+        }
+
+        /**
+         * @brief Finds the point with the maximal distance.
+         */
+        Point max() const {
+            VERIFY(!empty());
+            return *--end();
+        }
+
+        /**
+         * @brief Returns the copy of all points in a simple flat histogram.
+         */
+        Histogram Unwrap() const {
+            return Histogram(begin(), end());
+        }
+
+        size_t size() const { return end_ - begin_; }
+        bool empty() const { return begin_ == end_; }
+
+      private:
+        const InnerPoint *begin_;
+        const InnerPoint *end_;
+        DEDistance offset_;
+    };
+
+    typedef typename HistProxy::Iterator HistIterator;
+
+    using EdgeHist = std::pair<EdgeId, HistProxy>;
+
+    /**
+     * @brief Proxy map of the neighbourhood of an edge, see PairedIndex::EdgeProxy.
+     */
+    class EdgeProxy {
+      public:
+        class Iterator: public boost::iterator_facade<Iterator, EdgeHist, boost::forward_traversal_tag, EdgeHist> {
+          public:
+            Iterator(const FrozenPairedIndex &index, ColumnIterator iter, ColumnIterator stop, EdgeId edge, bool half)
+                    : index_(&index), iter_(iter), stop_(stop), edge_(edge), half_(half) {
+                Skip();
+            }
+
+          private:
+            friend class boost::iterator_core_access;
+
+            void Skip() { //For a half iterator, skip conjugate pairs
+                while (half_ && iter_ != stop_ && !index_->IsCanonical(edge_, iter_->edge))
+                    ++iter_;
+            }
+
+            void increment() {
+                ++iter_;
+                Skip();
+            }
+
+            bool equal(const Iterator &other) const {
+                return iter_ == other.iter_;
+            }
+
+            EdgeHist dereference() const {
+                return std::make_pair(iter_->edge, index_->MakeProxy(*iter_, edge_));
+            }
+
+            const FrozenPairedIndex *index_;
+            ColumnIterator iter_, stop_;
+            EdgeId edge_;
+            bool half_;
+        };
+
+        EdgeProxy(const FrozenPairedIndex &index, ColumnIterator begin, ColumnIterator end,
+                  EdgeId edge, bool half = false)
+                : index_(index), begin_(begin), end_(end), edge_(edge), half_(half) {}
+
+        Iterator begin() const {
+            return Iterator(index_, begin_, end_, edge_, half_);
+        }
+
+        Iterator end() const {
+            return Iterator(index_, end_, end_, edge_, half_);
+        }
+
+        HistProxy operator[](EdgeId e2) const {
+            if (half_ && !index_.IsCanonical(edge_, e2))
+                return HistProxy();
+            return index_.Get(edge_, e2);
+        }
+
+        bool empty() const {
+            return begin_ == end_;
+        }
+
+      private:
+        const FrozenPairedIndex &index_;
+        ColumnIterator begin_, end_;
+        EdgeId edge_;
+        bool half_;
+    };
+
+    typedef typename EdgeProxy::Iterator EdgeIterator;
+
+    explicit FrozenPairedIndex(const Graph &graph)
+            : graph_(graph), size_(0) {
+        clear();
+    }
+
+    template<template<typename, typename> class Container>
+    explicit FrozenPairedIndex(const PairedIndex<G, Traits, Container> &index)
+            : FrozenPairedIndex(index.graph()) {
+        Freeze(index);
+    }
+
+    /**
+     * @brief Replaces the contents with the copy of the index.
+     */
+    template<template<typename, typename> class Container>
+    void Freeze(const PairedIndex<G, Traits, Container> &index) {
+        clear();
+
+        // Count the neighbours of every edge
+        std::vector<EdgeId> firsts;
+        for (auto i = index.data_begin(); i != index.data_end(); ++i) {
+            firsts.push_back(i->first);
+            size_t id = Row(i->first);
+            if (id + 2 > rows_.size())
+                rows_.resize(id + 2, 0);
+            rows_[id + 1] += i->second.size();
+        }
+        std::partial_sum(rows_.begin(), rows_.end(), rows_.begin());
+
+        // Place the columns, histogram spans are resolved below
+        std::vector<const InnerHistPtr*> hists(rows_.back());
+        columns_.resize(rows_.back());
+        std::vector<size_t> pos(rows_.begin(), rows_.end() - 1);
+        for (auto i = index.data_begin(); i != index.data_end(); ++i) {
+            size_t &p = pos[Row(i->first)];
+            for (const auto &entry : i->second) {
+                hists[p] = &entry.second;
+                columns_[p++] = { entry.first, 0, 0 };
+            }
+        }
+
+        size_t points = 0;
+        for (size_t r = 0; r + 1 < rows_.size(); ++r) {
+            // Columns of unordered containers need to be sorted along with their histograms
+            if (!std::is_sorted(columns_.begin() + rows_[r], columns_.begin() + rows_[r + 1])) {
+                std::vector<std::pair<Column, const InnerHistPtr*>> row;
+                for (size_t c = rows_[r]; c < rows_[r + 1]; ++c)
+                    row.emplace_back(columns_[c], hists[c]);
+                std::sort(row.begin(), row.end(),
+                          [](const auto &a, const auto &b) { return a.first < b.first; });
+                for (size_t c = rows_[r], j = 0; c < rows_[r + 1]; ++c, ++j)
+                    std::tie(columns_[c], hists[c]) = row[j];
+            }
+
+            for (size_t c = rows_[r]; c < rows_[r + 1]; ++c)
+                if (hists[c]->owning())
+                    points += (*hists[c])->size();
+        }
+
+        // Copy the owned histograms in the order of rows
+        points_.reserve(points);
+        for (size_t c = 0; c < columns_.size(); ++c) {
+            if (!hists[c]->owning())
+                continue;
+            const auto &hist = **hists[c];
+            columns_[c].offset = points_.size();
+            columns_[c].size = hist.size();
+            points_.insert(points_.end(), hist.begin(), hist.end());
+        }
+
+        // Views share the histograms with their conjugate pairs
+        for (EdgeId e1 : firsts) {
+            size_t r = Row(e1);
+            for (size_t c = rows_[r]; c < rows_[r + 1]; ++c) {
+                if (hists[c]->owning())
+                    continue;
+                auto conj = ConjugatePair(e1, columns_[c].edge);
+                auto it = Find(conj.first, conj.second);
+                VERIFY_MSG(it != columns_.end(), "Index has no owning histogram for a view");
+                columns_[c].offset = it->offset;
+                columns_[c].size = it->size;
+            }
+        }
+
+        size_ = index.size();
+    }
+
+    /**
+     * @brief Clears the whole index.
+     */
+    void clear() {
+        std::vector<size_t>().swap(rows_);
+        std::vector<Column>().swap(columns_);
+        std::vector<InnerPoint>().swap(points_);
+        rows_.push_back(0);
+        size_ = 0;
+    }
+
+    /**
+     * Returns the graph the index is based on.
+     */
+    const Graph &graph() const { return graph_; }
+
+    /**
+     * @brief Returns the physical index size (total count of all histograms).
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Returns the number of bytes used by the index data.
+     */
+    size_t mem_size() const {
+        return rows_.capacity() * sizeof(size_t) +
+               columns_.capacity() * sizeof(Column) +
+               points_.capacity() * sizeof(InnerPoint);
+    }
+
+    EdgePair ConjugatePair(EdgeId e1, EdgeId e2) const {
+        return std::make_pair(graph_.conjugate(e2), graph_.conjugate(e1));
+    }
+
+    EdgePair ConjugatePair(EdgePair ep) const {
+        return ConjugatePair(ep.first, ep.second);
+    }
+
+    bool IsCanonical(EdgeId e1, EdgeId e2) const {
+        auto ep = std::make_pair(e1, e2);
+        return ep <= this->ConjugatePair(ep);
+    }
+
+    /**
+     * @brief Returns a whole proxy map to the neighbourhood of some edge.
+     */
+    EdgeProxy Get(EdgeId e) const {
+        auto range = RowRange(e);
+        return EdgeProxy(*this, range.first, range.second, e);
+    }
+
+    /**
+     * @brief Returns a half proxy map to the neighbourhood of some edge.
+     */
+    EdgeProxy GetHalf(EdgeId e) const {
+        auto range = RowRange(e);
+        return EdgeProxy(*this, range.first, range.second, e, true);
+    }
+
+    EdgeProxy operator[](EdgeId e) const {
+        return Get(e);
+    }
+
+    /**
+     * @brief Returns a histogram proxy for all points between two edges.
+     */
+    HistProxy Get(EdgeId e1, EdgeId e2) const {
+        auto it = Find(e1, e2);
+        if (it == columns_.end())
+            return HistProxy();
+        return MakeProxy(*it, e1);
+    }
+
+    HistProxy operator[](EdgePair p) const {
+        return Get(p.first, p.second);
+    }
+
+    /**
+     * @brief Checks if an edge (or its conjugated twin) is consisted in the index.
+     */
+    bool contains(EdgeId edge) const {
+        auto range = RowRange(edge), conj_range = RowRange(graph_.conjugate(edge));
+        return range.first != range.second || conj_range.first != conj_range.second;
+    }
+
+    /**
+     * @brief Checks if there is a histogram for two edges.
+     */
+    bool contains(EdgeId e1, EdgeId e2) const {
+        return Find(e1, e2) != columns_.end();
+    }
+
+  private:
+    size_t Row(EdgeId e) const {
+        return size_t(graph_.int_id(e));
+    }
+
+    std::pair<ColumnIterator, ColumnIterator> RowRange(EdgeId e) const {
+        size_t r = Row(e);
+        if (r + 1 >= rows_.size())
+            return { columns_.end(), columns_.end() };
+        return { columns_.begin() + rows_[r], columns_.begin() + rows_[r + 1] };
+    }
+
+    ColumnIterator Find(EdgeId e1, EdgeId e2) const {
+        auto range = RowRange(e1);
+        auto it = std::lower_bound(range.first, range.second, Column{ e2, 0, 0 });
+        if (it == range.second || it->edge != e2)
+            return columns_.end();
+        return it;
+    }
+
+    HistProxy MakeProxy(const Column &column, EdgeId e1) const {
+        const InnerPoint *begin = points_.data() + column.offset;
+        return HistProxy(begin, begin + column.size, DEDistance(graph_.length(e1)));
+    }
+
+    const Graph &graph_;
+    std::vector<size_t> rows_; // offsets of the neighbourhoods in columns, indexed by edge ids
+    std::vector<Column> columns_;
+    std::vector<InnerPoint> points_;
+    size_t size_;
+};
+
+template<class Graph>
+using FrozenUnclusteredPairedInfoIndexT = FrozenPairedIndex<Graph, RawPointTraits>;
+
+}
+
+}
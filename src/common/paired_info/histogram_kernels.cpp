@@ -0,0 +1,122 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "histogram_kernels.hpp"
+
+#include "math/xmath.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DE_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace omnigraph {
+namespace de {
+namespace kernels {
+
+namespace scalar {
+
+void ConvolveWeights(const int *dists, const double *weights, size_t n,
+                     const double *table, int table_low,
+                     int low, size_t len, double *out) {
+    std::fill(out, out + len, 0.);
+    for (size_t k = 0; k < n; ++k) {
+        const double *row = table + (low - dists[k] - table_low);
+        double w = weights[k];
+        for (size_t j = 0; j < len; ++j)
+            out[j] += w * row[j];
+    }
+}
+
+size_t FuzzyArgMax(const double *values, size_t n, size_t start) {
+    size_t res = start;
+    for (size_t j = 0; j < n; ++j)
+        if (math::ls(values[res], values[j]))
+            res = j;
+    return res;
+}
+
+}
+
+#ifdef DE_KERNELS_AVX2
+namespace avx2 {
+
+// Multiplication and addition are not fused to keep the results the same as
+// the scalar ones
+__attribute__((target("avx2")))
+static void ConvolveWeights(const int *dists, const double *weights, size_t n,
+                            const double *table, int table_low,
+                            int low, size_t len, double *out) {
+    std::fill(out, out + len, 0.);
+    for (size_t k = 0; k < n; ++k) {
+        const double *row = table + (low - dists[k] - table_low);
+        double w = weights[k];
+        __m256d wv = _mm256_set1_pd(w);
+        size_t j = 0;
+        for (; j + 4 <= len; j += 4) {
+            __m256d prod = _mm256_mul_pd(wv, _mm256_loadu_pd(row + j));
+            _mm256_storeu_pd(out + j, _mm256_add_pd(_mm256_loadu_pd(out + j), prod));
+        }
+        for (; j < len; ++j)
+            out[j] += w * row[j];
+    }
+}
+
+// Candidate could only be replaced by a strictly greater value, so the blocks
+// without such values are skipped as a whole
+__attribute__((target("avx2")))
+static size_t FuzzyArgMax(const double *values, size_t n, size_t start) {
+    size_t res = start;
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m256d gt = _mm256_cmp_pd(_mm256_loadu_pd(values + j), _mm256_set1_pd(values[res]), _CMP_GT_OQ);
+        if (!_mm256_movemask_pd(gt))
+            continue;
+        for (size_t i = j; i < j + 4; ++i)
+            if (math::ls(values[res], values[i]))
+                res = i;
+    }
+    for (; j < n; ++j)
+        if (math::ls(values[res], values[j]))
+            res = j;
+    return res;
+}
+
+}
+#endif
+
+bool UseAVX2() {
+#ifdef DE_KERNELS_AVX2
+    static const bool res = __builtin_cpu_supports("avx2");
+    return res;
+#else
+    return false;
+#endif
+}
+
+void ConvolveWeights(const int *dists, const double *weights, size_t n,
+                     const double *table, int table_low,
+                     int low, size_t len, double *out) {
+#ifdef DE_KERNELS_AVX2
+    if (UseAVX2())
+        return avx2::ConvolveWeights(dists, weights, n, table, table_low, low, len, out);
+#endif
+    scalar::ConvolveWeights(dists, weights, n, table, table_low, low, len, out);
+}
+
+size_t FuzzyArgMax(const double *values, size_t n, size_t start) {
+#ifdef DE_KERNELS_AVX2
+    if (UseAVX2())
+        return avx2::FuzzyArgMax(values, n, start);
+#endif
+    return scalar::FuzzyArgMax(values, n, start);
+}
+
+}
+}
+}
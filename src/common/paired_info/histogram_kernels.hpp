@@ -0,0 +1,58 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <cstddef>
+
+namespace omnigraph {
+
+namespace de {
+
+/**
+ * Kernels over dense distance arrays used by distance estimators. The
+ * dispatching versions use AVX2 when the CPU supports it and fall back to the
+ * scalar ones otherwise; both give exactly the same results.
+ */
+namespace kernels {
+
+/**
+ * @brief Convolves the points with the weight function:
+ *        out[j] = sum_k weights[k] * table[low + j - dists[k] - table_low], j < len.
+ *        The points are summed in the given order. The table should cover all
+ *        the differences between the output distances and the points.
+ */
+void ConvolveWeights(const int *dists, const double *weights, size_t n,
+                     const double *table, int table_low,
+                     int low, size_t len, double *out);
+
+/**
+ * @brief Finds the maximum scanning the values from left to right starting
+ *        with the candidate: the candidate is replaced by every value greater
+ *        than it (see math::ls). Returns the position of the maximum.
+ */
+size_t FuzzyArgMax(const double *values, size_t n, size_t start);
+
+/**
+ * @brief Returns true if the AVX2 versions of the kernels are used.
+ */
+bool UseAVX2();
+
+namespace scalar {
+
+void ConvolveWeights(const int *dists, const double *weights, size_t n,
+                     const double *table, int table_low,
+                     int low, size_t len, double *out);
+
+size_t FuzzyArgMax(const double *values, size_t n, size_t start);
+
+}
+
+}
+
+}
+
+}
@@ -10,6 +10,7 @@
 #define PAIR_INFO_FILLER_HPP_
 
 #include "paired_info/concurrent_pair_info_buffer.hpp"
+#include "paired_info/sharded_pair_info_buffer.hpp"
 
 #include "alignment/sequence_mapper_notifier.hpp"
 
@@ -18,6 +19,32 @@ namespace debruijn_graph {
 using omnigraph::MappingPath;
 using omnigraph::MappingRange;
 
+/**
+ * Distance between the starts of the edges the mates of the pair are mapped
+ * to. round_distance equal to the max unsigned value means that distance is
+ * replaced with the length of the first edge, values > 1 round the distance
+ * to the multiple of round_distance.
+ */
+inline int PairedEdgeDistance(const Graph &graph,
+                              const std::pair<EdgeId, MappingRange> &mapping_edge_1,
+                              const std::pair<EdgeId, MappingRange> &mapping_edge_2,
+                              size_t read_distance, unsigned round_distance) {
+    size_t kmer_distance = read_distance
+                           + mapping_edge_2.second.initial_range.end_pos
+                           - mapping_edge_1.second.initial_range.start_pos;
+    int edge_distance = (int) kmer_distance
+                        + (int) mapping_edge_1.second.mapped_range.start_pos
+                        - (int) mapping_edge_2.second.mapped_range.end_pos;
+
+    // Additionally round, if necessary
+    if (round_distance == std::numeric_limits<decltype(round_distance)>::max())
+        edge_distance = int(graph.length(mapping_edge_1.first));
+    else if (round_distance > 1)
+        edge_distance = int(std::round(edge_distance / double(round_distance))) * round_distance;
+
+    return edge_distance;
+}
+
 /**
  * As for now it ignores sophisticated case of repeated consecutive
  * occurrence of edge in path due to gaps in mapping
@@ -79,18 +106,8 @@ private:
 
                 // Add only if weight is non-zero
                 if (math::gr(weight, 0.0f)) {
-                    size_t kmer_distance = read_distance
-                                           + mapping_edge_2.second.initial_range.end_pos
-                                           - mapping_edge_1.second.initial_range.start_pos;
-                    int edge_distance = (int) kmer_distance
-                                        + (int) mapping_edge_1.second.mapped_range.start_pos
-                                        - (int) mapping_edge_2.second.mapped_range.end_pos;
-
-                    // Additionally round, if necessary
-                    if (round_distance_ == std::numeric_limits<decltype(round_distance_)>::max())
-                        edge_distance = int(graph_.length(mapping_edge_1.first));
-                    else if (round_distance_ > 1)
-                        edge_distance = int(std::round(edge_distance / double(round_distance_))) * round_distance_;
+                    int edge_distance = PairedEdgeDistance(graph_, mapping_edge_1, mapping_edge_2,
+                                                           read_distance, round_distance_);
 
                     buffer_pi_.Add(mapping_edge_1.first, mapping_edge_2.first,
                                    omnigraph::de::RawPoint(edge_distance, weight));
@@ -110,6 +127,87 @@ private:
     DECL_LOGGER("LatePairedIndexFiller");
 };
 
+/**
+ * Same as LatePairedIndexFiller, but the points are collected into the
+ * per-thread sharded buffer, so the threads do not contend for the locks of
+ * the shared map. The buffer of the thread is compacted on every merge, all
+ * the buffers are reduced in parallel in the end of the library.
+ */
+class ShardedPairedIndexFiller : public SequenceMapperListener {
+public:
+    typedef LatePairedIndexFiller::WeightF WeightF;
+
+    ShardedPairedIndexFiller(const Graph &graph, WeightF weight_f,
+                             unsigned round_distance,
+                             omnigraph::de::UnclusteredPairedInfoIndexT<Graph>& paired_index)
+            : graph_(graph),
+              weight_f_(std::move(weight_f)),
+              paired_index_(paired_index),
+              buffer_pi_(graph),
+              round_distance_(round_distance) {}
+
+    void StartProcessLibrary(size_t threads_count) override {
+        buffer_pi_.clear(threads_count);
+    }
+
+    void StopProcessLibrary() override {
+        buffer_pi_.Reduce();
+        paired_index_.MoveAssign(buffer_pi_);
+        buffer_pi_.clear();
+    }
+
+    void MergeBuffer(size_t thread_index) override {
+        buffer_pi_.Compact(thread_index);
+    }
+
+    void ProcessPairedRead(size_t thread_index,
+                           const io::PairedRead& r,
+                           const MappingPath<EdgeId>& read1,
+                           const MappingPath<EdgeId>& read2) override {
+        ProcessPairedRead(thread_index, read1, read2, r.distance());
+    }
+
+    void ProcessPairedRead(size_t thread_index,
+                           const io::PairedReadSeq& r,
+                           const MappingPath<EdgeId>& read1,
+                           const MappingPath<EdgeId>& read2) override {
+        ProcessPairedRead(thread_index, read1, read2, r.distance());
+    }
+
+private:
+    void ProcessPairedRead(size_t thread_index,
+                           const MappingPath<EdgeId>& path1,
+                           const MappingPath<EdgeId>& path2, size_t read_distance) {
+        for (size_t i = 0; i < path1.size(); ++i) {
+            std::pair<EdgeId, MappingRange> mapping_edge_1 = path1[i];
+            for (size_t j = 0; j < path2.size(); ++j) {
+                std::pair<EdgeId, MappingRange> mapping_edge_2 = path2[j];
+
+                omnigraph::de::DEWeight weight =
+                        weight_f_({mapping_edge_1.first, mapping_edge_2.first},
+                                  mapping_edge_1.second, mapping_edge_2.second);
+
+                // Add only if weight is non-zero
+                if (math::gr(weight, 0.0f)) {
+                    int edge_distance = PairedEdgeDistance(graph_, mapping_edge_1, mapping_edge_2,
+                                                           read_distance, round_distance_);
+
+                    buffer_pi_.Add(thread_index, mapping_edge_1.first, mapping_edge_2.first,
+                                   omnigraph::de::RawPoint(edge_distance, weight));
+                }
+            }
+        }
+    }
+
+    const Graph &graph_;
+    WeightF weight_f_;
+    omnigraph::de::UnclusteredPairedInfoIndexT<Graph>& paired_index_;
+    omnigraph::de::ShardedPairedInfoBuffer<Graph> buffer_pi_;
+    unsigned round_distance_;
+
+    DECL_LOGGER("ShardedPairedIndexFiller");
+};
+
 
 }
 
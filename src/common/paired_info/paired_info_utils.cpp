@@ -7,6 +7,7 @@
 
 #include "paired_info_utils.hpp"
 
+#include "filtering_pair_info_filler.hpp"
 #include "is_counter.hpp"
 #include "pair_info_filler.hpp"
 
@@ -131,7 +132,7 @@ void FillPairedIndex(const Graph &graph,
                      SequencingLib &reads,
                      PairedIndex &index,
                      std::unique_ptr<PairedInfoFilter> filter, unsigned filter_threshold,
-                     unsigned round_thr, bool use_binary) {
+                     unsigned round_thr, bool use_binary, bool sharded_buffer) {
     const auto &data = reads.data();
 
     SequenceMapperNotifier notifier;
@@ -153,8 +154,12 @@ void FillPairedIndex(const Graph &graph,
         };
     }
 
-    LatePairedIndexFiller pif(graph, weight, round_thr, index);
-    notifier.Subscribe(&pif);
+    std::unique_ptr<SequenceMapperListener> pif;
+    if (sharded_buffer)
+        pif = std::make_unique<ShardedPairedIndexFiller>(graph, weight, round_thr, index);
+    else
+        pif = std::make_unique<LatePairedIndexFiller>(graph, weight, round_thr, index);
+    notifier.Subscribe(pif.get());
 
     if (use_binary) {
         auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
@@ -167,6 +172,30 @@ void FillPairedIndex(const Graph &graph,
     }
 }
 
+void FillFilteredPairedIndex(const Graph &graph,
+                             const SequenceMapperNotifier::SequenceMapperT &mapper,
+                             SequencingLib &reads,
+                             PairedIndex &index,
+                             const std::filesystem::path &workdir,
+                             unsigned filter_threshold, unsigned round_thr) {
+    const auto &data = reads.data();
+
+    SequenceMapperNotifier notifier;
+    INFO("Left insert size quantile " << data.insert_size_left_quantile <<
+         ", right insert size quantile " << data.insert_size_right_quantile <<
+         ", filtering threshold " << filter_threshold <<
+         ", rounding threshold " << round_thr);
+
+    FilteringPairedIndexFiller pif(graph, filter_threshold, round_thr, index,
+                                   fs::tmp::make_temp_dir(workdir, "paired_info"));
+    notifier.Subscribe(&pif);
+
+    VERIFY(reads.data().unmerged_read_length != 0);
+    auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
+                                                /*include merged*/true);
+    notifier.ProcessLibrary(paired_streams, mapper);
+}
+
 class DEFilter : public SequenceMapperListener {
   public:
     DEFilter(paired_info::PairedInfoFilter &filter, const Graph &g)
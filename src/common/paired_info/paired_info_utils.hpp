@@ -15,6 +15,8 @@
 #include "library/library_data.hpp"
 #include "library/library_fwd.hpp"
 
+#include <filesystem>
+
 namespace paired_info {
 
 using SequencingLib = io::SequencingLibrary<debruijn_graph::config::LibraryData>;
@@ -32,7 +34,18 @@ void FillPairedIndex(const debruijn_graph::Graph &gp,
                      SequencingLib &reads,
                      PairedIndex &index,
                      std::unique_ptr<PairedInfoFilter> filter, unsigned filter_threshold,
-                     unsigned round_thr = 0, bool use_binary = true);
+                     unsigned round_thr = 0, bool use_binary = true,
+                     bool sharded_buffer = false);
+
+// Fills the index in a single mapping pass dropping the edge pairs which occur
+// at most filter_threshold times. Equivalent to FillPairedIndex() with the
+// filter produced by FillEdgePairFilter(), but the pair counts are exact.
+void FillFilteredPairedIndex(const debruijn_graph::Graph &gp,
+                             const debruijn_graph::SequenceMapper<debruijn_graph::Graph> &mapper,
+                             SequencingLib &reads,
+                             PairedIndex &index,
+                             const std::filesystem::path &workdir,
+                             unsigned filter_threshold, unsigned round_thr = 0);
 
 std::unique_ptr<PairedInfoFilter> FillEdgePairFilter(const debruijn_graph::Graph &gp,
                                                      const debruijn_graph::SequenceMapper<debruijn_graph::Graph> &mapper,
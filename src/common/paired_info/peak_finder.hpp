@@ -18,6 +18,7 @@
 
 #include "utils/verify.hpp"
 #include "data_divider.hpp"
+#include "histogram_kernels.hpp"
 #include "paired_info.hpp"
 #include <stdio.h>
 #include <stdlib.h>
@@ -70,6 +71,7 @@ class PeakFinder {
     VERIFY(data_len_ > 0);
     if (data_len_ == 1) {
       hist_[0] = y_[0];
+      SyncSmoothed();
       return;
     }
     InitBaseline();
@@ -86,6 +88,7 @@ class PeakFinder {
 
     FFTBackward(hist_);
     AddBaseline();
+    SyncSmoothed();
   }
 
   bool IsPeak(int dist, size_t range) const {
@@ -166,7 +169,7 @@ class PeakFinder {
         int left_bound = (x_left_ > (index - 20) ? x_left_ : (index - 20));
         int right_bound = (x_right_ < (index + 1 + 20) ? x_right_ : (index + 1 + 20));
         for (int i = left_bound; i < right_bound; ++i)
-          weight_ += hist_[i - x_left_].real();
+          weight_ += smoothed_[i - x_left_];
         TRACE("WEIGHT counted");
         std::pair<int, double> tmp_pair(index, 100. * weight_);
         if (!peaks_.count(index)) {
@@ -208,6 +211,7 @@ private:
   size_t data_size_, data_len_;
   int x_left_, x_right_;
   std::vector<complex_t> hist_;
+  std::vector<double> smoothed_; // real parts of hist_ used for peak detection
 
   size_t Rev(size_t num, size_t lg_n) {
     size_t res = 0;
@@ -228,9 +232,11 @@ private:
       ++n;
     }
 
-    for (size_t i = 0; i < n; ++i)
-      if (i < Rev(i, lg_n))
-        swap(vect[i], vect[Rev(i, lg_n)]);
+    for (size_t i = 0; i < n; ++i) {
+      size_t rev = Rev(i, lg_n);
+      if (i < rev)
+        swap(vect[i], vect[rev]);
+    }
 
     for (size_t len = 2; len < 1 + n; len <<= 1) {
       double ang = 2 * M_PI / (double) len * (invert ? -1 : 1);
@@ -324,6 +330,13 @@ private:
     x_right_ = x_[data_size_ - 1] + 1;
     data_len_ = x_right_ - x_left_;
     ExtendLinear(hist_);
+    SyncSmoothed();
+  }
+
+  void SyncSmoothed() {
+    smoothed_.resize(data_len_);
+    for (size_t i = 0; i < data_len_; ++i)
+      smoothed_[i] = hist_[i].real();
   }
 
   bool IsInRange(int peak) const {
@@ -332,17 +345,17 @@ private:
 
   double LeftDerivative(int dist) const {
     VERIFY(dist > x_left_);
-    return hist_[dist - x_left_].real() - hist_[dist - x_left_ - 1].real();
+    return smoothed_[dist - x_left_] - smoothed_[dist - x_left_ - 1];
   }
 
   double RightDerivative(int dist) const {
     VERIFY(dist < x_right_ - 1);
-    return hist_[dist - x_left_ + 1].real() - hist_[dist - x_left_].real();
+    return smoothed_[dist - x_left_ + 1] - smoothed_[dist - x_left_];
   }
 
   double MiddleDerivative(int dist) const {
     VERIFY(dist > x_left_ && dist < x_right_ - 1);
-    return .5 * (hist_[dist - x_left_ + 1].real() - hist_[dist - x_left_ - 1].real());
+    return .5 * (smoothed_[dist - x_left_ + 1] - smoothed_[dist - x_left_ - 1]);
   }
 
   double Derivative(int dist) const {
@@ -358,12 +371,11 @@ private:
 
     DEBUG("Is local maximum :  peak " << peak << " range " << range
        << " bounds " << left_bound << " " << right_bound << " delta " << delta);
-    int index_max = peak;
+    VERIFY(x_left_ <= left_bound && left_bound <= peak && peak < right_bound && right_bound <= x_right_);
     TRACE("Looking for the maximum");
-    for (int j = left_bound; j < right_bound; ++j)
-      if (math::ls(hist_[index_max - x_left_].real(), hist_[j - x_left_].real())) {
-        index_max = j;
-      }// else if (j < i && hist_[index_max - x_left_][0] == hist_[j - x_left][0] ) index_max = j;
+    int index_max = left_bound + (int) kernels::FuzzyArgMax(smoothed_.data() + (left_bound - x_left_),
+                                                            (size_t) (right_bound - left_bound),
+                                                            (size_t) (peak - left_bound));
     TRACE("Maximum is " << index_max);
 
     if  ((size_t)abs(index_max - peak) <= delta)
@@ -0,0 +1,276 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "histogram.hpp"
+#include "histptr.hpp"
+#include "paired_info.hpp"
+
+#include "adt/iterator_range.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace omnigraph {
+
+namespace de {
+
+/**
+ * @brief Buffer of paired info filled concurrently without any shared state.
+ *        Every thread appends the points to its own vectors sharded by the
+ *        first edge of the canonical edge pair. Compact() sorts the new points
+ *        of the thread into a run merging the points with the same distance
+ *        and merges the runs of comparable sizes, Reduce()
+ *        merges the shards of all the threads in parallel and builds the
+ *        histograms. After that the buffer could be moved or merged into the
+ *        index just like ConcurrentPairedBuffer (see PairedIndex::MoveAssign).
+ *        The result is the same as adding all the points to the index.
+ */
+template<typename G, typename Traits, template<typename, typename> class Container>
+class ShardedPairedBuffer {
+  public:
+    typedef G Graph;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef std::pair<EdgeId, EdgeId> EdgePair;
+    typedef typename Traits::Expanded Point;
+
+  protected:
+    typedef typename Traits::Gapped InnerPoint;
+    typedef omnigraph::de::Histogram<InnerPoint> InnerHistogram;
+    typedef omnigraph::de::StrongWeakPtr<InnerHistogram> InnerHistPtr;
+
+  public:
+    typedef Container<EdgeId, InnerHistPtr> InnerMap;
+    typedef std::vector<std::pair<EdgeId, InnerMap>> Table;
+    typedef adt::iterator_range<typename Table::iterator> locked_table;
+
+  private:
+    // Point of the canonical edge pair
+    struct Entry {
+        EdgeId e1, e2;
+        InnerPoint p;
+
+        bool operator<(const Entry &other) const {
+            if (e1 != other.e1)
+                return e1 < other.e1;
+            if (e2 != other.e2)
+                return e2 < other.e2;
+            return p < other.p;
+        }
+
+        bool same_pair(const Entry &other) const {
+            return e1 == other.e1 && e2 == other.e2;
+        }
+    };
+
+    struct Shard {
+        std::vector<Entry> entries;
+        std::vector<size_t> runs; // ends of the sorted and reduced runs
+    };
+
+    // Histogram of the edge pair, owning for canonical pairs
+    struct HistEntry {
+        EdgePair ep;
+        InnerHistogram *hist;
+        bool owning;
+
+        bool operator<(const HistEntry &other) const {
+            return ep < other.ep;
+        }
+    };
+
+  public:
+    ShardedPairedBuffer(const Graph &g, size_t nthreads = omp_get_max_threads(), size_t nshards = 0)
+            : graph_(g) {
+        clear(nthreads, nshards);
+    }
+
+    /**
+     * @brief Clears the buffer and prepares it to be filled by given number of threads.
+     */
+    void clear(size_t nthreads, size_t nshards = 0) {
+        if (!nshards)
+            nshards = 4 * nthreads;
+        local_.assign(nthreads, std::vector<Shard>(nshards));
+        table_.clear();
+        size_ = 0;
+    }
+
+    void clear() {
+        clear(local_.size(), shards());
+    }
+
+    const Graph &graph() const { return graph_; }
+
+    /**
+     * @brief Returns the physical size of the reduced buffer (total count of all histograms).
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Adds a point between two edges to the buffer of the thread.
+     */
+    void Add(size_t thread, EdgeId e1, EdgeId e2, Point p) {
+        InnerPoint sp = Traits::Shrink(p, graph_.length(e1));
+        EdgePair ep(e1, e2), conj(graph_.conjugate(e2), graph_.conjugate(e1));
+        const EdgePair &minep = std::min(ep, conj);
+
+        auto &entries = local_[thread][Partition(minep.first)].entries;
+        entries.push_back({ minep.first, minep.second, sp });
+        if (ep == conj) // Index doubles the weight of self-conjugate pairs
+            entries.push_back({ minep.first, minep.second, sp });
+    }
+
+    /**
+     * @brief Sorts and reduces the points added by the thread since the previous call.
+     */
+    void Compact(size_t thread) {
+        for (auto &shard : local_[thread]) {
+            auto &entries = shard.entries;
+            auto &runs = shard.runs;
+            size_t sorted = runs.empty() ? 0 : runs.back();
+            if (sorted == entries.size())
+                continue;
+
+            std::sort(entries.begin() + sorted, entries.end());
+            entries.erase(ReducePoints(entries.begin() + sorted, entries.end()), entries.end());
+            runs.push_back(entries.size());
+
+            // Merge the last run into the previous one only when they are of
+            // comparable sizes, so every point is merged O(log n) times
+            while (runs.size() > 1) {
+                size_t n = runs.size();
+                size_t begin = n > 2 ? runs[n - 3] : 0, mid = runs[n - 2];
+                if (mid - begin > 2 * (entries.size() - mid))
+                    break;
+
+                std::inplace_merge(entries.begin() + begin, entries.begin() + mid, entries.end());
+                entries.erase(ReducePoints(entries.begin() + begin, entries.end()), entries.end());
+                runs.pop_back();
+                runs.back() = entries.size();
+            }
+        }
+    }
+
+    /**
+     * @brief Merges the points of all the threads and builds the histograms.
+     *        No points could be added after that until the buffer is cleared.
+     */
+    void Reduce() {
+        size_t nshards = shards();
+
+        // Merge the shards of all the threads and build the histograms of
+        // canonical pairs, then route the views of conjugate pairs to the
+        // shards of their first edges
+        std::vector<std::vector<HistEntry>> hists(nshards);
+        std::vector<std::vector<std::vector<HistEntry>>> views(nshards, std::vector<std::vector<HistEntry>>(nshards));
+        size_t total = 0;
+#       pragma omp parallel for schedule(dynamic, 1) reduction(+ : total)
+        for (size_t s = 0; s < nshards; ++s) {
+            std::vector<Entry> entries;
+            for (auto &local : local_) {
+                auto &shard = local[s];
+                entries.insert(entries.end(), shard.entries.begin(), shard.entries.end());
+                std::vector<Entry>().swap(shard.entries);
+                shard.runs.clear();
+            }
+            std::sort(entries.begin(), entries.end());
+            entries.erase(ReducePoints(entries.begin(), entries.end()), entries.end());
+
+            std::vector<InnerPoint> points;
+            for (auto i = entries.begin(); i != entries.end(); ) {
+                auto j = i;
+                points.clear();
+                for (; j != entries.end() && j->same_pair(*i); ++j)
+                    points.push_back(j->p);
+
+                EdgePair ep(i->e1, i->e2), conj(graph_.conjugate(ep.second), graph_.conjugate(ep.first));
+                auto *hist = new InnerHistogram(points.begin(), points.end());
+                hists[s].push_back({ ep, hist, true });
+                if (ep != conj) {
+                    views[s][Partition(conj.first)].push_back({ conj, hist, false });
+                    total += 2 * hist->size();
+                } else
+                    total += hist->size();
+                i = j;
+            }
+        }
+
+        // Build the maps of the first edges
+        std::vector<Table> tables(nshards);
+#       pragma omp parallel for schedule(dynamic, 1)
+        for (size_t s = 0; s < nshards; ++s) {
+            auto &entries = hists[s];
+            for (auto &routed : views)
+                entries.insert(entries.end(), routed[s].begin(), routed[s].end());
+            std::sort(entries.begin(), entries.end());
+
+            auto &table = tables[s];
+            for (const auto &entry : entries) {
+                if (table.empty() || table.back().first != entry.ep.first)
+                    table.emplace_back(entry.ep.first, InnerMap());
+                auto &map = table.back().second;
+                map.insert(map.end(), std::make_pair(entry.ep.second, InnerHistPtr(entry.hist, entry.owning)));
+            }
+            std::vector<HistEntry>().swap(entries);
+        }
+
+        table_.clear();
+        for (auto &table : tables)
+            std::move(table.begin(), table.end(), std::back_inserter(table_));
+        size_ = total;
+    }
+
+    /**
+     * @brief Returns the reduced contents of the buffer: first edges along with
+     *        the maps of second edges to the histograms.
+     */
+    locked_table lock_table() {
+        return adt::make_range(table_.begin(), table_.end());
+    }
+
+  private:
+    size_t shards() const {
+        return local_.empty() ? 0 : local_.front().size();
+    }
+
+    size_t Partition(EdgeId e) const {
+        return e.hash() % shards();
+    }
+
+    // Merges consecutive points of the same edge pair with the same distance
+    template<class It>
+    static It ReducePoints(It begin, It end) {
+        if (begin == end)
+            return end;
+
+        It res = begin;
+        for (It i = std::next(begin); i != end; ++i) {
+            if (res->same_pair(*i) && res->p == i->p)
+                res->p = res->p + i->p;
+            else
+                *++res = *i;
+        }
+
+        return ++res;
+    }
+
+    const Graph &graph_;
+    std::vector<std::vector<Shard>> local_;
+    Table table_;
+    size_t size_;
+};
+
+template<class Graph>
+using ShardedPairedInfoBuffer = ShardedPairedBuffer<Graph, RawPointTraits, btree_map>;
+
+} // namespace de
+
+} // namespace omnigraph
@@ -0,0 +1,126 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Slab allocator for the long-living nucleotide buffers (e.g. the graph edge
+// sequences). The buffers are bump-allocated from the aligned slabs, so the
+// slab of a buffer is found by its address. A slab is freed once all its
+// buffers are released and the arena has moved on (see Renew()), so the
+// buffers may outlive the arena. Allocation is thread-safe.
+class NuclArena {
+  public:
+    static constexpr size_t SLAB_SIZE = size_t(1) << 20;
+    // Larger buffers should be allocated on the heap
+    static constexpr size_t MAX_ALLOC = SLAB_SIZE / 16;
+    static constexpr size_t ALIGNMENT = alignof(uint64_t);
+
+  private:
+    struct alignas(64) Slab {
+        std::atomic<size_t> used;
+        // Number of the live buffers + 1 while the slab belongs to the arena
+        std::atomic<size_t> refs;
+        std::atomic<size_t> live;
+
+        Slab()
+                : used(sizeof(Slab)), refs(1), live(0) {}
+    };
+
+    static Slab *create_slab() {
+        void *mem = ::operator new(SLAB_SIZE, std::align_val_t(SLAB_SIZE));
+        return new (mem) Slab();
+    }
+
+    static void unref(Slab *slab) {
+        if (slab->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            slab->~Slab();
+            ::operator delete(slab, std::align_val_t(SLAB_SIZE));
+        }
+    }
+
+    static size_t aligned(size_t bytes) {
+        return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    static Slab *slab(const void *p) {
+        return reinterpret_cast<Slab*>(uintptr_t(p) & ~uintptr_t(SLAB_SIZE - 1));
+    }
+
+    std::atomic<Slab*> current_;
+    std::vector<Slab*> slabs_;
+    std::mutex mutex_;
+
+  public:
+    NuclArena()
+            : current_(nullptr) {}
+
+    NuclArena(const NuclArena&) = delete;
+    NuclArena &operator=(const NuclArena&) = delete;
+
+    ~NuclArena() {
+        Renew();
+    }
+
+    void *allocate(size_t bytes) {
+        VERIFY(bytes <= MAX_ALLOC);
+        bytes = aligned(bytes);
+        while (true) {
+            Slab *s = current_.load(std::memory_order_acquire);
+            if (s) {
+                size_t offset = s->used.fetch_add(bytes, std::memory_order_relaxed);
+                if (offset + bytes <= SLAB_SIZE) {
+                    s->refs.fetch_add(1, std::memory_order_relaxed);
+                    s->live.fetch_add(bytes, std::memory_order_relaxed);
+                    return reinterpret_cast<char*>(s) + offset;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (current_.load(std::memory_order_relaxed) == s) {
+                slabs_.push_back(create_slab());
+                current_.store(slabs_.back(), std::memory_order_release);
+            }
+        }
+    }
+
+    // bytes should be the same as requested in allocate()
+    static void release(void *p, size_t bytes) {
+        bytes = aligned(bytes);
+        Slab *s = slab(p);
+        s->live.fetch_sub(bytes, std::memory_order_relaxed);
+        unref(s);
+    }
+
+    // Starts allocating from the new slabs. The current ones are freed as
+    // soon as their buffers are released. Not thread-safe w.r.t. allocate()
+    void Renew() {
+        current_.store(nullptr);
+        for (Slab *s : slabs_)
+            unref(s);
+        slabs_.clear();
+    }
+
+    // Memory taken by the slabs of the arena
+    size_t reserved() const {
+        return slabs_.size() * SLAB_SIZE;
+    }
+
+    // Memory taken by the live buffers allocated from the slabs of the arena
+    size_t live() const {
+        size_t res = 0;
+        for (const Slab *s : slabs_)
+            res += s->live.load(std::memory_order_relaxed);
+        return res;
+    }
+};
@@ -10,12 +10,14 @@
 
 #include "seq.hpp"
 #include "rtseq.hpp"
+#include "nucl_arena.hpp"
 
 #include "utils/verify.hpp"
 
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/Support/TrailingObjects.h>
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <memory>
@@ -35,13 +37,18 @@ class Sequence {
     // Number of bits in STN (for faster div and mod)
     const static size_t STNBits = log_<STN, 2>::value;
 
-    class ManagedNuclBuffer final : public llvm::ThreadSafeRefCountedBase<ManagedNuclBuffer>,
-                                    protected llvm::TrailingObjects<ManagedNuclBuffer, ST> {
+    class ManagedNuclBuffer final : protected llvm::TrailingObjects<ManagedNuclBuffer, ST> {
         friend TrailingObjects;
 
-        ManagedNuclBuffer() {}
+        mutable std::atomic<uint32_t> ref_cnt_;
+        // Size of the allocation if it was taken from an arena, 0 otherwise
+        uint32_t arena_bytes_;
 
-        ManagedNuclBuffer(size_t nucls, ST *buf) {
+        ManagedNuclBuffer(uint32_t arena_bytes = 0)
+                : ref_cnt_(0), arena_bytes_(arena_bytes) {}
+
+        ManagedNuclBuffer(size_t nucls, ST *buf)
+                : ManagedNuclBuffer() {
             std::uninitialized_copy(buf, buf + Sequence::DataSize(nucls), data());
         }
 
@@ -58,6 +65,30 @@ class Sequence {
             return new (mem) ManagedNuclBuffer(nucls, data);
         }
 
+        // The buffer is taken from the arena unless it is too large
+        static ManagedNuclBuffer *create(size_t nucls, NuclArena &arena) {
+            size_t bytes = totalSizeToAlloc<ST>(Sequence::DataSize(nucls));
+            if (bytes > NuclArena::MAX_ALLOC)
+                return create(nucls);
+            return new (arena.allocate(bytes)) ManagedNuclBuffer(uint32_t(bytes));
+        }
+
+        void Retain() const { ref_cnt_.fetch_add(1, std::memory_order_relaxed); }
+
+        void Release() const {
+            if (ref_cnt_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+
+            if (arena_bytes_) {
+                uint32_t bytes = arena_bytes_;
+                this->~ManagedNuclBuffer();
+                NuclArena::release(const_cast<ManagedNuclBuffer*>(this), bytes);
+            } else
+                delete this;
+        }
+
+        bool in_arena() const { return arena_bytes_; }
+
         const ST *data() const { return getTrailingObjects<ST>(); }
         ST *data() { return getTrailingObjects<ST>(); }
     };
@@ -176,8 +207,21 @@ public:
     Sequence(const Sequence &s)
             : Sequence(s, s.from_, s.size_, s.rtl_) {}
 
+    /**
+     * Copy of the sequence (only the nucleotides it spans) placed into the arena
+     */
+    Sequence(const Sequence &s, NuclArena &arena)
+            : size_(s.size_), from_(s.size_ ? s.from_ & (STN - 1) : 0), rtl_(s.rtl_),
+              data_(ManagedNuclBuffer::create(from_ + size_, arena)) {
+        std::copy_n(s.data_->data() + (s.from_ >> STNBits), DataSize(from_ + size_), data_->data());
+    }
+
     Sequence(Sequence &&) noexcept = default;
 
+    bool in_arena() const {
+        return data_->in_arena();
+    }
+
     const Sequence &operator=(const Sequence &rhs) {
         if (&rhs == this)
             return *this;
@@ -236,10 +236,15 @@ public:
         using Splitter =  kmers::DeBruijnReadKMerSplitter<io::SingleReadSeq,
                                                           kmers::StoringTypeFilter<storing_type>>;
 
-        kmers::KMerDiskCounter<RtSeq>
-                counter(storage().workdir,
-                        Splitter(storage().workdir, index.k() + 1, merge_streams, buffer_size));
-        auto kmers = counter.Count(10 * nthreads, nthreads);
+        Splitter splitter(storage().workdir, index.k() + 1, merge_streams, buffer_size);
+        if (storage().params.compress_raw_kmers)
+            splitter.set_raw_kmer_codec(kmers::RawKMerCodec::DeltaZlib);
+        std::unique_ptr<kmers::KMerCounter<RtSeq>> counter;
+        if (storage().params.in_memory_counting)
+            counter.reset(new kmers::KMerMemoryCounter<RtSeq>(storage().workdir, std::move(splitter)));
+        else
+            counter.reset(new kmers::KMerDiskCounter<RtSeq>(storage().workdir, std::move(splitter)));
+        auto kmers = counter->Count(10 * nthreads, nthreads);
         storage().kmers.reset(new kmers::KMerDiskStorage<RtSeq>(std::move(kmers)));
     }
 
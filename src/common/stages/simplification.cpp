@@ -400,6 +400,8 @@ public:
         size_t iteration = 0;
         auto message_callback = [&] () {
             INFO("PROCEDURE == Simplification cycle, iteration " << ++iteration);
+            // Sequences of the edges removed by the previous cycles
+            g_.CompactSequences();
         };
 
         CompositeAlgorithm<Graph> algo(g_, message_callback);
@@ -484,7 +486,12 @@ void Simplification::run(graph_pack::GraphPack &gp, const char*) {
                                nullptr/*removal_handler_f*/,
                                printer);
     simplifier.SimplifyGraph();
-    CompressAllVertices(gp.get_mutable<Graph>());
+
+    auto &graph = gp.get_mutable<Graph>();
+    debruijn::simplification::ParallelCompressor<Graph>(graph, info_container.chunk_cnt()).Run();
+    //cycles are left by parallel compressor
+    CompressAllVertices(graph);
+    graph.CompactSequences();
 }
 
 void SimplificationCleanup::run(graph_pack::GraphPack &gp, const char*) {
@@ -652,7 +652,8 @@ AlgoPtr<Graph> BRInstance(Graph &g,
                 alternatives_analyzer,
                 callback,
                 removal_handler,
-                /*track_changes*/true);
+                /*track_changes*/true,
+                br_config.speculation_batch);
     } else {
         INFO("Creating br instance");
         return std::make_shared<omnigraph::BulgeRemover<Graph>>(g,
@@ -660,7 +661,8 @@ AlgoPtr<Graph> BRInstance(Graph &g,
                 alternatives_analyzer,
                 callback,
                 removal_handler,
-                /*track_changes*/true);
+                /*track_changes*/true,
+                br_config.speculation_batch);
     }
 }
 
@@ -14,7 +14,6 @@
 #include "adt/hll.hpp"
 
 #include "io/reads/read_processor.hpp"
-#include "io/reads/ireadstream.hpp"
 #include "io/kmers/kmer_iterator.hpp"
 
 #include "kmer_index/kmer_mph/kmer_index_builder.hpp"
@@ -62,17 +61,16 @@ class BufferFiller {
   BufferFiller(HammerFilteringKMerSplitter &splitter)
       : splitter_(splitter) {}
 
-  bool operator()(std::unique_ptr<Read> r) {
+  bool operator()(Read &r) {
     int trim_quality = cfg::get().input_trim_quality;
 
-    Read cr = *r;
-    size_t sz = cr.trimNsAndBadQuality(trim_quality);
+    size_t sz = r.trimNsAndBadQuality(trim_quality);
   
     if (sz < hammer::K)
       return false;
     
     unsigned thread_id = omp_get_thread_num();
-    ValidKMerGenerator<hammer::K> gen(cr);
+    ValidKMerGenerator<hammer::K> gen(r);
     bool stop = false;
     for (; gen.HasMore(); gen.Next()) {
       KMer seq = gen.kmer();
@@ -96,7 +94,7 @@ HammerFilteringKMerSplitter::RawKMers HammerFilteringKMerSplitter::Split(size_t
   BufferFiller filler(*this);
   for (const auto &reads : cfg::get().dataset.reads()) {
     INFO("Processing " << reads);
-    ireadstream irs(reads, cfg::get().input_qvoffset);
+    hammer::ReadBatchStream irs(reads, cfg::get().input_qvoffset, nthreads);
     while (!irs.eof()) {
       hammer::ReadProcessor rp(nthreads);
       rp.Run(irs, filler);
@@ -161,18 +159,16 @@ class KMerDataFiller {
   KMerDataFiller(KMerData &data)
       : data_(data) {}
 
-  bool operator()(std::unique_ptr<Read> r) {
+  bool operator()(Read &r) {
     uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
-    // FIXME: Get rid of this
-    Read cr = *r;
-    size_t sz = cr.trimNsAndBadQuality(trim_quality);
+    size_t sz = r.trimNsAndBadQuality(trim_quality);
 
     if (sz < hammer::K)
       return false;
 
-    ValidKMerGenerator<hammer::K> gen(cr);
-    const char *q = cr.getQualityString().data();
+    ValidKMerGenerator<hammer::K> gen(r);
+    const char *q = r.getQualityString().data();
     while (gen.HasMore()) {
       KMer kmer = gen.kmer();
       const unsigned char *kq = (const unsigned char*)(q + gen.pos() - 1);
@@ -199,17 +195,15 @@ class KMerMultiplicityCounter {
 
   ~KMerMultiplicityCounter() {}
 
-    bool operator()(std::unique_ptr<Read> r) {
+    bool operator()(Read &r) {
       uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
-      // FIXME: Get rid of this
-      Read cr = *r;
-      size_t sz = cr.trimNsAndBadQuality(trim_quality);
+      size_t sz = r.trimNsAndBadQuality(trim_quality);
 
       if (sz < hammer::K)
         return false;
 
-      ValidKMerGenerator<hammer::K> gen(cr);
+      ValidKMerGenerator<hammer::K> gen(r);
       for (; gen.HasMore(); gen.Next()) {
           KMer kmer = gen.kmer();
 
@@ -237,17 +231,15 @@ class KMerCountEstimator {
 
   ~KMerCountEstimator() {}
 
-    bool operator()(std::unique_ptr<Read> r) {
+    bool operator()(Read &r) {
       uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
-      // FIXME: Get rid of this
-      Read cr = *r;
-      size_t sz = cr.trimNsAndBadQuality(trim_quality);
+      size_t sz = r.trimNsAndBadQuality(trim_quality);
 
       if (sz < hammer::K)
         return false;
 
-      ValidKMerGenerator<hammer::K> gen(cr);
+      ValidKMerGenerator<hammer::K> gen(r);
       for (; gen.HasMore(); gen.Next()) {
           KMer kmer = gen.kmer();
           auto &hll = hll_[omp_get_thread_num()];
@@ -287,7 +279,7 @@ void KMerDataCounter::BuildKMerIndex(KMerData &data) {
           KMerCountEstimator mcounter(omp_get_max_threads());
           for (const auto &reads : cfg::get().dataset.reads()) {
               INFO("Processing " << reads);
-              ireadstream irs(reads, cfg::get().input_qvoffset);
+              hammer::ReadBatchStream irs(reads, cfg::get().input_qvoffset, omp_get_max_threads());
               while (!irs.eof()) {
                   hammer::ReadProcessor rp(omp_get_max_threads());
                   rp.Run(irs, mcounter);
@@ -314,7 +306,7 @@ void KMerDataCounter::BuildKMerIndex(KMerData &data) {
       size_t n = 15, processed = 0;
       for (const auto &reads : cfg::get().dataset.reads()) {
           INFO("Processing " << reads);
-          ireadstream irs(reads, cfg::get().input_qvoffset);
+          hammer::ReadBatchStream irs(reads, cfg::get().input_qvoffset, omp_get_max_threads());
           while (!irs.eof()) {
               hammer::ReadProcessor rp(omp_get_max_threads());
               rp.Run(irs, mcounter);
@@ -376,7 +368,7 @@ void KMerDataCounter::FillKMerData(KMerData &data) {
   const auto& dataset = cfg::get().dataset;
   for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
     INFO("Processing " << *I);
-    ireadstream irs(*I, cfg::get().input_qvoffset);
+    hammer::ReadBatchStream irs(*I, cfg::get().input_qvoffset, omp_get_max_threads());
     hammer::ReadProcessor rp(omp_get_max_threads());
     rp.Run(irs, filler);
     VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
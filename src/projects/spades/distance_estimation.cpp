@@ -15,6 +15,7 @@
 #include "library/library.hpp"
 
 #include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
 
 #include <set>
 #include <unordered_set>
@@ -38,19 +39,29 @@ void DistanceEstimation::run(graph_pack::GraphPack &gp, const char*) {
         if (lib.type() != io::LibraryType::PairedEnd)
             continue;
 
-        if (lib.data().mean_insert_size != 0.0) {
-            INFO("Processing library #" << i);
-            EstimatePairedDistances(clustered_indices[i], graph, lib, paired_indices[i],
-                                    max_repeat_length, config.de);
-            if (cfg::get().pe_params.param_set.scaffolder_options.cluster_info)
-                EstimateScaffoldingDistances(scaffolding_indices[i], graph, lib, paired_indices[i],
-                                             config.ade, config.de);
+        if (lib.data().mean_insert_size == 0.0) {
+            if (!cfg::get().preserve_raw_paired_index) {
+                INFO("Clearing raw paired index");
+                paired_indices[i].clear();
+            }
+            continue;
         }
 
+        INFO("Processing library #" << i);
+        // Raw index is not modified anymore, so estimators use its compact copy
+        FrozenUnclusteredPairedInfoIndexT<Graph> paired_index(paired_indices[i]);
+        INFO("Raw paired index frozen, " << paired_index.size() << " points, "
+             << utils::human_readable_memory(paired_index.mem_size() / 1024) << " used");
         if (!cfg::get().preserve_raw_paired_index) {
             INFO("Clearing raw paired index");
             paired_indices[i].clear();
         }
+
+        EstimatePairedDistances(clustered_indices[i], graph, lib, paired_index,
+                                max_repeat_length, config.de);
+        if (cfg::get().pe_params.param_set.scaffolder_options.cluster_info)
+            EstimateScaffoldingDistances(scaffolding_indices[i], graph, lib, paired_index,
+                                         config.ade, config.de);
     }
 }
 
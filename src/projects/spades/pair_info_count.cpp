@@ -199,7 +199,10 @@ void PairInfoCount::run(graph_pack::GraphPack &gp, const char *) {
                 unsigned filter_threshold = cfg::get().de.raw_filter_threshold;
 
                 // Only filter paired-end libraries
-                if (filter_threshold && lib.type() == io::LibraryType::PairedEnd) {
+                bool use_filter = filter_threshold && lib.type() == io::LibraryType::PairedEnd;
+                // Single-pass mode counts edge pairs while filling the index
+                bool single_pass = use_filter && cfg::get().de.raw_filter_single_pass;
+                if (use_filter && !single_pass) {
                     INFO("Filtering data for library #" << i);
                     filter = paired_info::FillEdgePairFilter(graph, *ChooseProperMapper(gp, lib), lib, edgepairs);
                 }
@@ -211,13 +214,19 @@ void PairInfoCount::run(graph_pack::GraphPack &gp, const char *) {
 
                     unsigned round_thr = 0;
                     // Do not round if filtering is disabled
-                    if (filter)
+                    if (use_filter)
                         round_thr = unsigned(std::min(cfg::get().de.max_distance_coeff * lib.data().insert_size_deviation * cfg::get().de.rounding_coeff,
                                                       cfg::get().de.rounding_thr));
 
-                    paired_info::FillPairedIndex(graph, *ChooseProperMapper(gp, lib),
-                                                 lib, gp.get_mutable<Indices>()[i],
-                                                 std::move(filter), filter_threshold, round_thr);
+                    if (single_pass)
+                        paired_info::FillFilteredPairedIndex(graph, *ChooseProperMapper(gp, lib),
+                                                             lib, gp.get_mutable<Indices>()[i],
+                                                             gp.workdir(), filter_threshold, round_thr);
+                    else
+                        paired_info::FillPairedIndex(graph, *ChooseProperMapper(gp, lib),
+                                                     lib, gp.get_mutable<Indices>()[i],
+                                                     std::move(filter), filter_threshold, round_thr,
+                                                     /*use_binary*/true, cfg::get().de.sharded_paired_buffer);
                 }
             }
 
@@ -41,6 +41,13 @@ ST_SIZE = 8
 ST_NUC = ST_SIZE * 4
 
 def show_kmidx(file):
+    magic = file.read(8)
+    if magic == b"SPAKMIDX":
+        # Memory mapped layout, only the header is shown
+        print("Version: %d" % read_int(file, 8))
+        print("k: %d" % read_int(file, 8))
+        return
+    file.seek(0)
     k = read_int(file)
     print("k: %d" % k)
     size = read_int(file, 8)
@@ -41,6 +41,7 @@ static BRConfig br_config(bool enabled = false) {
     config.buff_size = 10000;
     config.buff_cov_diff = 2.;
     config.buff_cov_rel_diff = 0.2;
+    config.speculation_batch = 256;
     return config;
 }
 
@@ -9,6 +9,7 @@
 #include "tmp_folder_fixture.hpp"
 
 #include "alignment/edge_index.hpp"
+#include "io/binary/edge_index.hpp"
 #include "io/reads/rc_reader_wrapper.hpp"
 #include "io/reads/read_stream_vector.hpp"
 #include "io/reads/vector_reader.hpp"
@@ -63,24 +64,32 @@ TEST_F( GraphConstruction, CondenseSimple ) {
     AssertGraph (5, reads, edges);
 }
 
-void CheckIndex(const std::vector<std::string> &reads, const std::filesystem::path &tmpdir, size_t k) {
+void CheckIndex(const std::vector<std::string> &reads, const std::filesystem::path &tmpdir, size_t k,
+                const config::debruijn_config::construction &params = config::debruijn_config::construction()) {
     typedef io::VectorReadStream<io::SingleRead> RawStream;
     graph_pack::GraphPack gp(k, tmpdir, 0);
     auto workdir = fs::tmp::make_temp_dir(gp.workdir(), "tests");
     io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
     auto &graph = gp.get_mutable<Graph>();
     auto &index = gp.get_mutable<EdgeIndex<Graph>>();
-    ConstructGraphWithIndex(config::debruijn_config::construction(), workdir, streams, graph, index);
+    ConstructGraphWithIndex(params, workdir, streams, graph, index);
     auto &stream = streams.back();
     stream.reset();
     io::SingleRead read;
     while (!stream.eof()) {
         stream >> read;
+        std::vector<RtSeq> kmers;
         RtSeq kmer = read.sequence().start<RtSeq>(k + 1) >> 'A';
         for (size_t i = k; i < read.size(); i++) {
             kmer = kmer << read[i];
             EXPECT_TRUE(index.contains(kmer));
+            kmers.push_back(kmer);
         }
+
+        std::vector<std::pair<EdgeId, size_t>> positions(kmers.size());
+        index.get(kmers.data(), kmers.size(), positions.data());
+        for (size_t i = 0; i < kmers.size(); ++i)
+            EXPECT_EQ(index.get(kmers[i]), positions[i]);
     }
 }
 
@@ -94,6 +103,72 @@ TEST_F( GraphConstruction, TestKmerFreeIndex ) {
     CheckIndex(reads, tmp_folder(), 5);
 }
 
+TEST_F( GraphConstruction, TestInMemoryCounting ) {
+    std::vector<std::string> reads = { "CGAAACCAC", "CGAAAACAC", "AACCACACC", "AAACACACC" };
+    config::debruijn_config::construction params;
+    params.in_memory_counting = true;
+    CheckIndex(reads, tmp_folder(), 5, params);
+}
+
+TEST_F( GraphConstruction, TestCompressedRawKMers ) {
+    std::vector<std::string> reads = { "CGAAACCAC", "CGAAAACAC", "AACCACACC", "AAACACACC" };
+    config::debruijn_config::construction params;
+    params.compress_raw_kmers = true;
+    CheckIndex(reads, tmp_folder(), 5, params);
+}
+
+void CheckSavedIndex(const EdgeIndex<Graph> &index, const EdgeIndex<Graph> &loaded,
+                     const std::vector<std::string> &reads, size_t k) {
+    for (const auto &s : reads) {
+        Sequence seq(s);
+        for (const Sequence &read : { seq, !seq }) {
+            RtSeq kmer = read.start<RtSeq>(k + 1) >> 'A';
+            for (size_t i = k; i < read.size(); ++i) {
+                kmer = kmer << read[i];
+                EXPECT_TRUE(loaded.contains(kmer));
+                EXPECT_EQ(index.get(kmer), loaded.get(kmer));
+            }
+        }
+    }
+}
+
+TEST_F( GraphConstruction, TestMappedIndexIO ) {
+    std::vector<std::string> reads = { "CGAAACCAC", "CGAAAACAC", "AACCACACC", "AAACACACC" };
+    size_t k = 5;
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    graph_pack::GraphPack gp(k, tmp_folder(), 0);
+    auto workdir = fs::tmp::make_temp_dir(gp.workdir(), "tests");
+    io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
+    auto &graph = gp.get_mutable<Graph>();
+    auto &index = gp.get_mutable<EdgeIndex<Graph>>();
+    ConstructGraphWithIndex(config::debruijn_config::construction(), workdir, streams, graph, index);
+
+    std::string basename = tmp_folder() / "index";
+    {
+        // Mapped layout
+        io::binary::Save(basename, index);
+        EdgeIndex<Graph> loaded(graph, workdir->dir());
+        EXPECT_TRUE(io::binary::Load(basename, loaded));
+        CheckSavedIndex(index, loaded, reads, k);
+        auto sz = std::filesystem::file_size(basename + ".kmidx");
+        for (size_t cut : {size_t(20), size_t(40), size_t(sz / 2), size_t(sz - 8)}) {
+            std::filesystem::resize_file(basename + ".kmidx", cut);
+            EdgeIndex<Graph> truncated(graph, workdir->dir());
+            EXPECT_DEATH(io::binary::Load(basename, truncated), "");
+            io::binary::Save(basename, index);
+        }
+    }
+
+    {
+        // Stream layout of the older saves
+        io::binary::EdgeIndexIO<Graph> io;
+        io.io::binary::IOSingle<EdgeIndex<Graph>>::Save(basename, index);
+        EdgeIndex<Graph> loaded(graph, workdir->dir());
+        EXPECT_TRUE(io::binary::Load(basename, loaded));
+        CheckSavedIndex(index, loaded, reads, k);
+    }
+}
+
 TEST_F( GraphConstruction, SimpleTestEarlyPairedInfo ) {
     std::vector<MyPairedRead> paired_reads = {{"CCCAC", "CCACG"}, {"ACCAC", "CCACA"}};
     std::vector<MyEdge> edges = {"CCCA", "ACCA", "CCAC", "CACG", "CACA"};
@@ -8,15 +8,20 @@
 #include "graphio.hpp"
 
 #include "alignment/pacbio/g_aligner.hpp"
+#include "alignment/sequence_mapper_notifier.hpp"
 #include "assembly_graph/core/graph.hpp"
 #include "configs/config_struct.hpp"
 #include "edlib/edlib.h"
 #include "io/reads/io_helper.hpp"
+#include "io/reads/vector_reader.hpp"
 #include "utils/logger/log_writers.hpp"
 #include "utils/stl_utils.hpp"
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+
 using namespace debruijn_graph;
 
 TEST(GraphAligner, EdlibSHWFULLTest) {
@@ -133,7 +138,15 @@ TEST(GraphAligner, TrivialTest ) {
             EXPECT_EQ(idealMapping, pathStr);
         }
     }
-    
+
+    // The distance cache of the fresh aligner is filled concurrently
+    sensitive_aligner::GAligner shared_galigner(g, sensitive_aligner::GAlignerConfig(pb, mode, gap_cfg, ends_cfg));
+    std::vector<std::vector<std::vector<EdgeId>>> concurrent_paths(4);
+    #pragma omp parallel for num_threads(4)
+    for (size_t i = 0; i < concurrent_paths.size(); ++i)
+        concurrent_paths[i] = shared_galigner.GetReadAlignment(r).edge_paths;
+    for (const auto &paths : concurrent_paths)
+        EXPECT_EQ(aligned_edges, paths);
 }
 
 
@@ -165,6 +178,12 @@ TEST(GraphAligner, DijkstraOneEdgeTest ) {
     gap_filler.CloseGap();
     int score = gap_filler.edit_distance();
     EXPECT_EQ(ideal_score, score);
+
+    // The second run reuses the workspace of the first one
+    sensitive_aligner::DijkstraGapFiller next_filler(g, gap_cfg, s, eid, eid, 0, (int) s.size(), path_maxlen, vertex_pathlen);
+    next_filler.CloseGap();
+    EXPECT_EQ(ideal_score, next_filler.edit_distance());
+    EXPECT_EQ(gap_filler.path_str(), next_filler.path_str());
 }
 
 
@@ -195,3 +214,93 @@ TEST(GraphAligner, DijkstraGrowEndsTest ) {
     int score = ends_filler.edit_distance();
     EXPECT_EQ(ideal_score, score);
 }
+
+namespace {
+
+class EmptyMapper : public SequenceMapper<Graph> {
+  public:
+    omnigraph::MappingPath<EdgeId> MapSequence(const Sequence &, bool) const override {
+        return {};
+    }
+
+    omnigraph::MappingPath<EdgeId> MapRead(const io::SingleRead &, bool) const override {
+        return {};
+    }
+};
+
+// Keeps the read names in the buffers of the threads, the way the listeners
+// keep their per-thread data
+class ReadNamesListener : public SequenceMapperListener {
+  public:
+    void StartProcessLibrary(size_t threads_count) override {
+        buffers_.assign(threads_count, {});
+        names_.clear();
+        wrong_thread_ = false;
+    }
+
+    void ProcessSingleRead(size_t thread_index, const io::SingleRead &r,
+                           const omnigraph::MappingPath<EdgeId> &) override {
+        if (thread_index != size_t(omp_get_thread_num()))
+            wrong_thread_ = true;
+        buffers_[omp_get_thread_num()].push_back(r.name());
+    }
+
+    void MergeBuffer(size_t thread_index) override {
+        auto &buffer = buffers_[thread_index];
+        names_.insert(names_.end(), buffer.begin(), buffer.end());
+        buffer.clear();
+    }
+
+    std::vector<std::string> names() const {
+        auto res = names_;
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    bool wrong_thread() const {
+        return wrong_thread_;
+    }
+
+  private:
+    std::vector<std::vector<std::string>> buffers_;
+    std::vector<std::string> names_;
+    std::atomic<bool> wrong_thread_;
+};
+
+}
+
+TEST(SequenceMapperNotifier, FewerStreamsThanThreads) {
+    std::vector<std::string> names;
+    std::vector<std::vector<io::SingleRead>> reads(2);
+    for (size_t i = 0; i < 10000; ++i) {
+        names.push_back("read" + std::to_string(i));
+        reads[i % 2].emplace_back(names.back(), "ACGTACGTAC");
+    }
+    std::sort(names.begin(), names.end());
+
+    EmptyMapper mapper;
+    for (size_t nstreams : { 1, 2 }) {
+        auto run = [&](size_t threads) {
+            io::ReadStreamList<io::SingleRead> streams;
+            if (nstreams == 1) {
+                std::vector<io::SingleRead> all(reads[0]);
+                all.insert(all.end(), reads[1].begin(), reads[1].end());
+                streams.push_back(io::VectorReadStream<io::SingleRead>(all));
+            } else {
+                for (const auto &part : reads)
+                    streams.push_back(io::VectorReadStream<io::SingleRead>(part));
+            }
+
+            ReadNamesListener listener;
+            SequenceMapperNotifier notifier;
+            notifier.Subscribe(&listener);
+            notifier.ProcessLibrary(streams, mapper, threads);
+            EXPECT_FALSE(listener.wrong_thread());
+            return listener.names();
+        };
+
+        auto serial = run(1);
+        EXPECT_EQ(names, serial);
+        EXPECT_EQ(serial, run(4));
+    }
+}
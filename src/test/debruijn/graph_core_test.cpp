@@ -6,7 +6,15 @@
 //***************************************************************************
 
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/core/graph_snapshot.hpp"
+#include "assembly_graph/core/basic_graph_stats.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+#include "assembly_graph/graph_support/marks_and_locks.hpp"
+#include "paired_info/distance_estimation.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "graphio.hpp"
 
+#include <map>
 #include <vector>
 #include <set>
 #include <string>
@@ -107,3 +115,217 @@ TEST( GraphCore, SelfRCEdgeMerge ) {
     EXPECT_EQ(1u, g.OutgoingEdgeCount(v1));
     EXPECT_EQ(Sequence("AACGCTATTCACGTGAATAGCGTT"), g.EdgeNucls(g.GetUniqueOutgoingEdge(v1)));
 }
+
+class EventCounter : public omnigraph::GraphActionHandler<Graph> {
+public:
+    size_t added = 0, deleted = 0, merged = 0;
+
+    EventCounter(const Graph &g)
+            : omnigraph::GraphActionHandler<Graph>(g, "EventCounter") {}
+
+    void HandleAdd(EdgeId) override { added += 1; }
+    void HandleMerge(const std::vector<EdgeId> &, EdgeId) override { merged += 1; }
+    void HandleDelete(EdgeId e) override {
+        // Removed edges are destroyed after the handlers are notified
+        EXPECT_NE(0u, g().EdgeNucls(e).size());
+        deleted += 1;
+    }
+};
+
+TEST( GraphCore, ConcurrentModification ) {
+    const size_t nthreads = 4, ncomponents = 1000;
+    Graph g(11);
+    g.reserve(8 * ncomponents, 6 * ncomponents);
+    EventCounter counter(g);
+
+    // Components v0 -> v1 -> v2 with the tip v1 -> v3
+    std::vector<Sequence> seqs(ncomponents);
+    std::vector<std::vector<VertexId>> vertices(ncomponents);
+    std::vector<EdgeId> tips(ncomponents);
+    for (size_t i = 0; i < ncomponents; ++i) {
+        std::string s;
+        for (size_t j = 0; j < 30; ++j)
+            s.push_back(nucl(char(((i >> (2 * (j % 8))) + j) & 3)));
+        seqs[i] = Sequence(s);
+    }
+
+    g.StartConcurrentModification(nthreads);
+    #pragma omp parallel for num_threads(nthreads)
+    for (size_t i = 0; i < ncomponents; ++i) {
+        auto &vs = vertices[i];
+        for (size_t j = 0; j < 4; ++j)
+            vs.push_back(g.AddVertex());
+        omnigraph::VertexTransaction<Graph> lock(g, vs.begin(), vs.end());
+        g.AddEdge(vs[0], vs[1], seqs[i].Subseq(0, 20));
+        g.AddEdge(vs[1], vs[2], seqs[i].Subseq(9, 30));
+        tips[i] = g.AddEdge(vs[1], vs[3], seqs[i].Subseq(9, 25));
+    }
+    g.FinishConcurrentModification();
+    EXPECT_EQ(6 * ncomponents, g.e_size());
+    EXPECT_EQ(6 * ncomponents, counter.added);
+
+    g.StartConcurrentModification(nthreads);
+    #pragma omp parallel for num_threads(nthreads)
+    for (size_t i = 0; i < ncomponents; ++i) {
+        const auto &vs = vertices[i];
+        omnigraph::VertexTransaction<Graph> lock(g, {vs[0], vs[1], vs[2], vs[3]});
+        g.DeleteEdge(tips[i]);
+        g.DeleteVertex(vs[3]);
+        g.CompressVertex(vs[1]);
+    }
+    g.FinishConcurrentModification();
+
+    EXPECT_EQ(4 * ncomponents, g.size());
+    EXPECT_EQ(2 * ncomponents, g.e_size());
+    EXPECT_EQ(2 * ncomponents, counter.merged);
+    EXPECT_EQ(8 * ncomponents, counter.added);
+    EXPECT_EQ(6 * ncomponents, counter.deleted);
+    for (size_t i = 0; i < ncomponents; ++i) {
+        VertexId v0 = vertices[i][0];
+        ASSERT_EQ(1u, g.OutgoingEdgeCount(v0));
+        EdgeId e = g.GetUniqueOutgoingEdge(v0);
+        EXPECT_EQ(vertices[i][2], g.EdgeEnd(e));
+        EXPECT_EQ(seqs[i], g.EdgeNucls(e));
+    }
+}
+
+TEST( GraphCore, CompactSequences ) {
+    const size_t ncomponents = 2000;
+    Graph g(11);
+    ASSERT_NE(nullptr, g.master().arena());
+
+    std::vector<EdgeId> edges;
+    std::vector<std::string> seqs;
+    for (size_t i = 0; i < ncomponents; ++i) {
+        std::string s;
+        for (size_t j = 0; j < 200; ++j)
+            s.push_back(nucl(char(((i >> (2 * (j % 8))) + j * j) & 3)));
+        edges.push_back(g.AddEdge(g.AddVertex(), g.AddVertex(), Sequence(s)));
+        EXPECT_TRUE(g.EdgeNucls(edges.back()).in_arena());
+        seqs.push_back(s);
+    }
+
+    // Short pieces of the edges keep the whole original sequences
+    std::vector<EdgeId> pieces;
+    for (size_t i = 0; i < ncomponents; ++i) {
+        auto [e, rest] = g.SplitEdge(edges[i], 10);
+        g.DeleteEdge(rest);
+        auto [piece, piece_rest] = g.SplitEdge(e, 5);
+        g.DeleteEdge(piece_rest);
+        pieces.push_back(piece);
+    }
+    size_t live = g.master().arena()->live();
+
+    g.CompactSequences();
+    EXPECT_LT(2 * g.master().arena()->live(), live);
+    for (size_t i = 0; i < ncomponents; ++i) {
+        EXPECT_TRUE(g.EdgeNucls(pieces[i]).in_arena());
+        EXPECT_EQ(seqs[i].substr(0, 16), g.EdgeNucls(pieces[i]).str());
+        EXPECT_EQ(!g.EdgeNucls(pieces[i]), g.EdgeNucls(g.conjugate(pieces[i])));
+    }
+}
+
+TEST( GraphCore, CompactRemovedSequences ) {
+    const size_t nedges = 2000;
+    Graph g(11);
+    ASSERT_NE(nullptr, g.master().arena());
+
+    std::vector<EdgeId> edges;
+    for (size_t i = 0; i < nedges; ++i) {
+        std::string s;
+        for (size_t j = 0; j < 10000; ++j)
+            s.push_back(nucl(char(((i >> (2 * (j % 8))) + j * j) & 3)));
+        edges.push_back(g.AddEdge(g.AddVertex(), g.AddVertex(), Sequence(s)));
+    }
+    size_t reserved = g.master().arena()->reserved();
+    EXPECT_LT(4 * NuclArena::SLAB_SIZE, reserved);
+
+    // Nothing to compact
+    g.CompactSequences();
+    EXPECT_EQ(reserved, g.master().arena()->reserved());
+
+    // The slabs are taken by the removed edges
+    std::vector<std::string> seqs;
+    for (size_t i = 0; i < nedges; ++i) {
+        if (i % 100 == 0)
+            seqs.push_back(g.EdgeNucls(edges[i]).str());
+        else
+            g.DeleteEdge(edges[i]);
+    }
+    g.CompactSequences();
+    EXPECT_EQ(NuclArena::SLAB_SIZE, g.master().arena()->reserved());
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        EXPECT_TRUE(g.EdgeNucls(edges[100 * i]).in_arena());
+        EXPECT_EQ(seqs[i], g.EdgeNucls(edges[100 * i]).str());
+    }
+}
+
+TEST( GraphCore, Snapshot ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g));
+    typedef omnigraph::GraphSnapshot<Graph> Snapshot;
+    Snapshot s(g);
+
+    EXPECT_EQ(g.size(), s.size());
+    EXPECT_EQ(g.e_size(), s.e_size());
+    for (VertexId v : g) {
+        ASSERT_TRUE(s.contains(v));
+        EXPECT_EQ(v, s.vertex(s.index(v)));
+        EXPECT_EQ(g.conjugate(v), s.conjugate(v));
+        EXPECT_EQ(std::vector<EdgeId>(g.OutgoingEdges(v).begin(), g.OutgoingEdges(v).end()),
+                  std::vector<EdgeId>(s.OutgoingEdges(v).begin(), s.OutgoingEdges(v).end()));
+        EXPECT_EQ(g.IncidentEdges(v), s.IncidentEdges(v));
+    }
+    for (EdgeId e : g.edges()) {
+        ASSERT_TRUE(s.contains(e));
+        EXPECT_EQ(e, s.edge(s.index(e)));
+        EXPECT_EQ(g.EdgeStart(e), s.EdgeStart(e));
+        EXPECT_EQ(g.EdgeEnd(e), s.EdgeEnd(e));
+        EXPECT_EQ(g.conjugate(e), s.conjugate(e));
+        EXPECT_EQ(g.length(e), s.length(e));
+        EXPECT_EQ(g.coverage(e), s.coverage(e));
+    }
+    EXPECT_EQ(omnigraph::CumulativeLengthCounter<Graph>(g).Count(),
+              omnigraph::CumulativeLengthCounter<Snapshot>(s).Count());
+    EXPECT_EQ(omnigraph::CumulativeLengthCounter<Graph>(g).Count(false),
+              omnigraph::CumulativeLengthCounter<Snapshot>(s).Count(false));
+
+    size_t checked = 0;
+    for (VertexId v : g.canonical_vertices()) {
+        if (++checked > 100)
+            break;
+        auto gd = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(g, 1000);
+        auto sd = omnigraph::DijkstraHelper<Snapshot>::CreateBoundedDijkstra(s, 1000);
+        gd.Run(v);
+        sd.Run(v);
+        auto reached = gd.ReachedVertices();
+        EXPECT_EQ(reached.size(), sd.ReachedVertices().size());
+        for (VertexId u : reached) {
+            ASSERT_TRUE(sd.DistanceCounted(u));
+            EXPECT_EQ(gd.GetDistance(u), sd.GetDistance(u));
+        }
+    }
+
+    // Same distances are found by the path search on the snapshot
+    omnigraph::de::GraphDistanceFinder gf(g, 300, 100, 20), sf(g, 300, 100, 20, &s);
+    checked = 0;
+    size_t found = 0;
+    for (EdgeId e1 : g.edges()) {
+        if (++checked > 100)
+            break;
+        std::map<EdgeId, std::vector<size_t>> glengths, slengths;
+        // Next edges and the ones after them
+        for (EdgeId e2 : g.OutgoingEdges(g.EdgeEnd(e1))) {
+            glengths[e2];
+            for (EdgeId e3 : g.OutgoingEdges(g.EdgeEnd(e2)))
+                glengths[e3];
+        }
+        slengths = glengths;
+        gf.FillGraphDistancesLengths(e1, glengths);
+        sf.FillGraphDistancesLengths(e1, slengths);
+        EXPECT_EQ(glengths, slengths);
+        for (const auto &entry : glengths)
+            found += entry.second.size();
+    }
+    EXPECT_LT(0, found);
+}
@@ -0,0 +1,183 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Runs the smoothing kernels of the distance estimators over all the
+// histograms of a raw paired index and compares the per-point evaluation of
+// the weight function with the scalar and the dispatched (AVX2) kernels.
+//
+// Usage: histogram_kernels_bench [<saves basename> <k>]
+// The basename should point to a saved graph along with a raw paired index
+// (.grp/.sqn/.prd files). Without it a random graph and index are generated.
+
+#include "random_graph.hpp"
+
+#include "io/binary/graph.hpp"
+#include "io/binary/paired_index.hpp"
+#include "paired_info/frozen_paired_info.hpp"
+#include "paired_info/histogram_kernels.hpp"
+
+#include "utils/logger/log_writers.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace debruijn_graph;
+using namespace omnigraph::de;
+
+using Index = UnclusteredPairedInfoIndexT<Graph>;
+
+static void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+// Cluster of points smoothed at once (see DataDivider::DivideAndSmoothData)
+struct Cluster {
+    std::vector<int> dists;
+    std::vector<double> weights;
+};
+
+static std::vector<Cluster> CollectClusters(const FrozenUnclusteredPairedInfoIndexT<Graph> &index,
+                                            const Graph &g, int threshold) {
+    std::vector<Cluster> res;
+    for (EdgeId e1 : g.edges()) {
+        for (auto entry : index.GetHalf(e1)) {
+            Cluster cluster;
+            for (auto point : entry.second) {
+                int d = rounded_d(point);
+                if (!cluster.dists.empty() && d - cluster.dists.back() > threshold) {
+                    res.push_back(std::move(cluster));
+                    cluster = Cluster();
+                }
+                cluster.dists.push_back(d);
+                cluster.weights.push_back(point.weight);
+            }
+            if (!cluster.dists.empty())
+                res.push_back(std::move(cluster));
+        }
+    }
+
+    return res;
+}
+
+// Points around few distances for every edge pair, like the ones of a
+// paired-end library
+static void GenerateIndex(Graph &g, Index &index) {
+    std::mt19937_64 rnd(42);
+    std::vector<VertexId> vertices;
+    for (size_t i = 0; i < 1000; ++i)
+        vertices.push_back(g.AddVertex());
+
+    std::vector<EdgeId> edges;
+    for (size_t i = 0; i < 2000; ++i)
+        edges.push_back(g.AddEdge(vertices[rnd() % vertices.size()], vertices[rnd() % vertices.size()],
+                                  RandomSequence(g.k() + 1 + rnd() % 1000)));
+
+    for (size_t i = 0; i < 20000; ++i) {
+        EdgeId e1 = edges[rnd() % edges.size()], e2 = edges[rnd() % edges.size()];
+        for (size_t peaks = 1 + rnd() % 2; peaks > 0; --peaks) {
+            std::normal_distribution<double> dist(double(rnd() % 2000), 30.);
+            for (size_t j = 0; j < 100; ++j)
+                index.Add(e1, e2, RawPoint(DEDistance(std::round(dist(rnd))), 1));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    create_console_logger();
+
+    std::unique_ptr<Graph> g;
+    std::unique_ptr<Index> raw;
+    if (argc > 2) {
+        g.reset(new Graph(unsigned(std::stoul(argv[2]))));
+        CHECK_FATAL_ERROR(io::binary::Load(argv[1], *g), "Failed to load graph from " << argv[1]);
+        raw.reset(new Index(*g));
+        CHECK_FATAL_ERROR(io::binary::Load(argv[1], *raw), "Failed to load paired index from " << argv[1]);
+    } else {
+        g.reset(new Graph(55));
+        raw.reset(new Index(*g));
+        GenerateIndex(*g, *raw);
+    }
+    FrozenUnclusteredPairedInfoIndexT<Graph> index(*raw);
+    raw.reset();
+    INFO("Paired index with " << index.size() << " points loaded");
+
+    auto clusters = CollectClusters(index, *g, /*threshold*/50);
+    INFO(clusters.size() << " clusters collected");
+
+    // Insert size distribution of a typical library
+    std::function<double(int)> weight_f = [](int x) {
+        return 1000. * std::exp(-double(x) * double(x) / (2. * 50. * 50.));
+    };
+
+    std::vector<std::vector<double>> naive(clusters.size()), scalar(clusters.size()), dispatched(clusters.size());
+
+    utils::perf_counter pc;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        const auto &cluster = clusters[c];
+        int low = cluster.dists.front(), high = cluster.dists.back();
+        for (int j = low; j <= high; ++j) {
+            double val = 0.;
+            for (size_t k = 0; k < cluster.dists.size(); ++k)
+                val += cluster.weights[k] * weight_f(j - cluster.dists[k]);
+            naive[c].push_back(val);
+        }
+    }
+    double naive_time = pc.time();
+
+    auto convolve = [&](auto kernel, std::vector<std::vector<double>> &res) {
+        utils::perf_counter pc;
+        std::vector<double> table;
+        for (size_t c = 0; c < clusters.size(); ++c) {
+            const auto &cluster = clusters[c];
+            int low = cluster.dists.front(), span = cluster.dists.back() - low;
+            table.resize(2 * span + 1);
+            for (int t = -span; t <= span; ++t)
+                table[t + span] = weight_f(t);
+            res[c].resize(span + 1);
+            kernel(cluster.dists.data(), cluster.weights.data(), cluster.dists.size(),
+                   table.data(), -span, low, res[c].size(), res[c].data());
+        }
+        return pc.time();
+    };
+    double scalar_time = convolve(kernels::scalar::ConvolveWeights, scalar);
+    double dispatched_time = convolve(kernels::ConvolveWeights, dispatched);
+
+    INFO("Weight convolution: per point " << naive_time << "s, scalar kernel " << scalar_time
+         << "s, " << (kernels::UseAVX2() ? "AVX2" : "scalar") << " kernel " << dispatched_time << "s");
+    if (naive != scalar || naive != dispatched) {
+        ERROR("Convolution results differ");
+        return 1;
+    }
+
+    // Peak detection scans the whole smoothed window for every candidate
+    auto find_peaks = [&](auto kernel, std::vector<size_t> &res) {
+        utils::perf_counter pc;
+        for (const auto &values : naive)
+            for (size_t i = 0; i < values.size(); ++i)
+                res.push_back(kernel(values.data(), values.size(), i));
+        return pc.time();
+    };
+    std::vector<size_t> scalar_peaks, dispatched_peaks;
+    double scalar_peaks_time = find_peaks(kernels::scalar::FuzzyArgMax, scalar_peaks);
+    double dispatched_peaks_time = find_peaks(kernels::FuzzyArgMax, dispatched_peaks);
+
+    INFO("Peak detection: scalar kernel " << scalar_peaks_time << "s, "
+         << (kernels::UseAVX2() ? "AVX2" : "scalar") << " kernel " << dispatched_peaks_time << "s");
+    if (scalar_peaks != dispatched_peaks) {
+        ERROR("Peak detection results differ");
+        return 1;
+    }
+
+    return 0;
+}
@@ -6,9 +6,16 @@
 //***************************************************************************
 
 #include "paired_info/histogram.hpp"
+#include "paired_info/histogram_kernels.hpp"
 #include "paired_info/histptr.hpp"
 
+#include "math/xmath.h"
+
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
 
 using namespace omnigraph::de;
 
@@ -49,3 +56,60 @@ TEST(Histogram, StrongWeakPtrBasic) {
     //Free
     EXPECT_EQ(Counter::Count(), 0);
 }
+
+TEST(Histogram, ConvolveWeights) {
+    std::mt19937 rnd(42);
+    for (size_t iter = 0; iter < 100; ++iter) {
+        int low = int(rnd() % 1000) - 500;
+        size_t len = 1 + rnd() % 50;
+        std::vector<int> dists;
+        std::vector<double> weights;
+        for (size_t n = rnd() % 10; n > 0; --n) {
+            dists.push_back(low + int(rnd() % len));
+            weights.push_back(double(rnd() % 100) / 7);
+        }
+        std::sort(dists.begin(), dists.end());
+
+        int span = int(len) - 1;
+        std::vector<double> table;
+        for (int t = -span; t <= span; ++t)
+            table.push_back(std::exp(-double(t * t) / 50.));
+
+        std::vector<double> expected(len);
+        for (size_t j = 0; j < len; ++j)
+            for (size_t k = 0; k < dists.size(); ++k)
+                expected[j] += weights[k] * table[low + int(j) - dists[k] + span];
+
+        std::vector<double> scalar(len), dispatched(len);
+        kernels::scalar::ConvolveWeights(dists.data(), weights.data(), dists.size(),
+                                         table.data(), -span, low, len, scalar.data());
+        kernels::ConvolveWeights(dists.data(), weights.data(), dists.size(),
+                                 table.data(), -span, low, len, dispatched.data());
+        EXPECT_EQ(expected, scalar);
+        EXPECT_EQ(expected, dispatched);
+    }
+}
+
+TEST(Histogram, FuzzyArgMax) {
+    std::mt19937 rnd(42);
+    for (size_t iter = 0; iter < 1000; ++iter) {
+        size_t n = 1 + rnd() % 40;
+        std::vector<double> values;
+        for (size_t i = 0; i < n; ++i) {
+            double v = double(rnd() % 10);
+            // Values almost equal to each other are not replacing the maximum
+            if (rnd() % 3 == 0)
+                v = std::nextafter(v, 100.);
+            values.push_back(v);
+        }
+        size_t start = rnd() % n;
+
+        size_t expected = start;
+        for (size_t j = 0; j < n; ++j)
+            if (math::ls(values[expected], values[j]))
+                expected = j;
+
+        EXPECT_EQ(expected, kernels::scalar::FuzzyArgMax(values.data(), n, start));
+        EXPECT_EQ(expected, kernels::FuzzyArgMax(values.data(), n, start));
+    }
+}
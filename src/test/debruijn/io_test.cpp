@@ -14,6 +14,9 @@
 #include "io/binary/paired_index.hpp"
 #include "io/graph/gfa_reader.hpp"
 #include "io/graph/gfa_writer.hpp"
+#include "io/reads/ireadstream.hpp"
+#include "io/reads/read_processor.hpp"
+#include "tmp_folder_fixture.hpp"
 
 #include <filesystem>
 #include <gtest/gtest.h>
@@ -152,3 +155,137 @@ TEST(Io, GFADBG) {
     //fixme support 0-in-2-out DBG vertices in GFAWriter
 //    CheckGFAInOut("src/test/debruijn/graph_fragments/topology_ec/big_bad", "big_bad", gfa_out_base);
 }
+
+typedef std::vector<std::tuple<std::string, std::string, std::string>> ReadRecords;
+
+ReadRecords ReadBatched(const std::filesystem::path &fname, unsigned nchunks, size_t block_size, unsigned nthreads) {
+    ReadRecords res;
+    auto collect = [&res](::Read &r) {
+#       pragma omp critical
+        res.emplace_back(r.getName(), r.getSequenceString(), r.getQualityString());
+        return false;
+    };
+
+    hammer::ReadBatchStream irs(fname, ::Read::PHRED_OFFSET, nchunks, block_size);
+    hammer::ReadProcessor rp(nthreads);
+    rp.Run(irs, collect);
+    EXPECT_TRUE(irs.eof());
+    EXPECT_EQ(rp.read(), res.size());
+    EXPECT_EQ(rp.processed(), res.size());
+
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+TEST(Io, ReadBatchStream) {
+    TmpFolderFixture fixture("tmp");
+    std::filesystem::path gz_reads("src/test/data/s_6_1.fastq.gz");
+    std::filesystem::path reads = fixture.tmp_folder() / "s_6_1.fastq";
+
+    ReadRecords expected;
+    {
+        ireadstream irs(gz_reads);
+        ::Read r;
+        while (!irs.eof()) {
+            irs >> r;
+            expected.emplace_back(r.getName(), r.getSequenceString(), r.getQualityString());
+        }
+        std::sort(expected.begin(), expected.end());
+    }
+    ASSERT_EQ(251, expected.size());
+
+    {
+        gzFile in = gzopen(gz_reads.c_str(), "r");
+        std::ofstream out(reads);
+        char buf[4096];
+        int len;
+        while ((len = gzread(in, buf, sizeof(buf))) > 0)
+            out.write(buf, len);
+        gzclose(in);
+    }
+
+    for (unsigned nthreads : { 1, 3 }) {
+        EXPECT_EQ(expected, ReadBatched(gz_reads, 1, 1 << 20, nthreads));
+        EXPECT_EQ(expected, ReadBatched(gz_reads, 4, 1000, nthreads));
+        EXPECT_EQ(expected, ReadBatched(reads, 1, 1 << 20, nthreads));
+        EXPECT_EQ(expected, ReadBatched(reads, 7, 1000, nthreads));
+    }
+    EXPECT_EQ(7, hammer::ReadBatchStream(reads, ::Read::PHRED_OFFSET, 7, 1000).chunks());
+}
+
+TEST(Io, ReadBatchStreamFasta) {
+    TmpFolderFixture fixture("tmp");
+    std::filesystem::path reads = fixture.tmp_folder() / "reads.fasta";
+    {
+        std::ofstream out(reads, std::ios::binary);
+        out << ">r1 first read\r\nACGT\r\nTTGCA\r\n>r2\n\n>r3\tthird\nGGGGCCCC\nAAAA\nCC";
+    }
+
+    ReadRecords expected = { { "r1", "ACGTTTGCA", "" }, { "r2", "", "" }, { "r3", "GGGGCCCCAAAACC", "" } };
+    EXPECT_EQ(expected, ReadBatched(reads, 1, 1 << 20, 1));
+    EXPECT_EQ(expected, ReadBatched(reads, 1, 5, 1));
+    EXPECT_EQ(expected, ReadBatched(reads, 3, 8, 2));
+}
+
+TEST(Io, ReadBatchStreamMultilineFastq) {
+    TmpFolderFixture fixture("tmp");
+    // Quality lines of the wrapped records start with '@' and '+'
+    std::string wrapped =
+            "@w1 wrapped\nACGTA\nCGT\n+\n@IIII\n+II\n"
+            "@w2\r\nAC\r\nGT\r\n+w2\r\n+@\r\n@@\r\n"
+            "@w3\n\n+\n\n";
+    std::string single = "@s1\nACGT\n+\nIIII\n@s2\nTTTT\n+\n@@@@\n";
+    auto qual = [](std::string q) {
+        for (char &c : q)
+            c = char(c - ::Read::PHRED_OFFSET);
+        return q;
+    };
+    ReadRecords wrapped_reads = { { "w1", "ACGTACGT", qual("@IIII+II") }, { "w2", "ACGT", qual("+@@@") }, { "w3", "", "" } };
+    ReadRecords single_reads = { { "s1", "ACGT", qual("IIII") }, { "s2", "TTTT", qual("@@@@") } };
+
+    std::filesystem::path reads = fixture.tmp_folder() / "wrapped.fastq";
+    {
+        std::ofstream out(reads, std::ios::binary);
+        out << wrapped << single;
+    }
+    ReadRecords expected = wrapped_reads;
+    expected.insert(expected.end(), single_reads.begin(), single_reads.end());
+    std::sort(expected.begin(), expected.end());
+
+    EXPECT_EQ(expected, ReadBatched(reads, 1, 1 << 20, 1));
+    EXPECT_EQ(expected, ReadBatched(reads, 1, 7, 1));
+    // Starts with the wrapped record, so it is not split
+    EXPECT_EQ(1, hammer::ReadBatchStream(reads, ::Read::PHRED_OFFSET, 4, 8).chunks());
+    EXPECT_EQ(expected, ReadBatched(reads, 4, 8, 2));
+
+    // Split only between the single-line records
+    reads = fixture.tmp_folder() / "mixed.fastq";
+    {
+        std::ofstream out(reads, std::ios::binary);
+        for (size_t i = 0; i < 20; ++i)
+            out << single;
+        out << wrapped << single;
+    }
+    expected.clear();
+    for (size_t i = 0; i < 21; ++i)
+        expected.insert(expected.end(), single_reads.begin(), single_reads.end());
+    expected.insert(expected.end(), wrapped_reads.begin(), wrapped_reads.end());
+    std::sort(expected.begin(), expected.end());
+    for (unsigned nchunks : { 1, 3, 8 })
+        EXPECT_EQ(expected, ReadBatched(reads, nchunks, 64, 2));
+}
+
+TEST(Io, ReadProcessorStop) {
+    std::filesystem::path reads("src/test/data/s_6_1.fastq.gz");
+    size_t calls = 0;
+    auto stop = [&calls](::Read &) {
+        calls += 1;
+        return calls == 10;
+    };
+
+    hammer::ReadBatchStream irs(reads, ::Read::PHRED_OFFSET);
+    hammer::ReadProcessor rp(1);
+    EXPECT_TRUE(rp.Run(irs, stop));
+    EXPECT_EQ(10, calls);
+    EXPECT_EQ(10, rp.processed());
+}
@@ -647,3 +647,54 @@ TEST( OverlapRemoval, OverlapWithMiddle ) {
 }
 
 //TODO add more tricky tests on whole the process
+
+TEST( OverlapRemoval, IndexedComparison ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g));
+
+    GraphCoverageMap cov_map(g);
+    PathContainer container;
+    size_t id = 0;
+    for (EdgeId e : g.edges()) {
+        if (++id > 40)
+            break;
+
+        auto path = BidirectionalPath::create(g, e);
+        for (size_t step = 0; step < 8; ++step) {
+            auto outgoing = g.OutgoingEdges(g.EdgeEnd(path->Back()));
+            size_t cnt = std::distance(outgoing.begin(), outgoing.end());
+            if (cnt == 0)
+                break;
+            path->PushBack(*std::next(outgoing.begin(), (step + id) % cnt), Gap(id % 5 == 0 ? 10 : 0));
+        }
+        AddPath(container, BidirectionalPath::create(path->SubPath(path->Size() / 2)), cov_map);
+        AddPath(container, BidirectionalPath::create(path->SubPath(0, path->Size() - 1)), cov_map);
+        AddPath(container, std::move(path), cov_map);
+    }
+
+    OverlapFindingHelper helper(g, cov_map, 0, 0);
+    OverlapFindingHelper indexed_helper(g, cov_map, 0, 0, &container);
+    std::vector<const BidirectionalPath*> paths;
+    for (const auto &path_pair : container) {
+        paths.push_back(path_pair.first.get());
+        paths.push_back(path_pair.second.get());
+    }
+
+    size_t subpaths = 0, overlaps = 0;
+    for (const BidirectionalPath *path1 : paths) {
+        for (const BidirectionalPath *path2 : paths) {
+            EXPECT_EQ(helper.IsEqual(*path1, *path2), indexed_helper.IsEqual(*path1, *path2));
+            EXPECT_EQ(helper.IsSubpath(*path1, *path2), indexed_helper.IsSubpath(*path1, *path2));
+            subpaths += helper.IsSubpath(*path1, *path2);
+            for (bool end_start_only : {false, true}) {
+                auto ranges = helper.FindOverlap(*path1, *path2, end_start_only);
+                auto indexed_ranges = indexed_helper.FindOverlap(*path1, *path2, end_start_only);
+                EXPECT_EQ(ranges.first, indexed_ranges.first);
+                EXPECT_EQ(ranges.second, indexed_ranges.second);
+                overlaps += ranges.first.size() > 0;
+            }
+        }
+    }
+    EXPECT_GT(subpaths, paths.size());
+    EXPECT_GT(overlaps, 2 * paths.size());
+}
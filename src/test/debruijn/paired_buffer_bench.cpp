@@ -0,0 +1,160 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Compares the concurrent and the sharded paired info buffers filled the same
+// way SequenceMapperNotifier fills them: every thread adds the points of its
+// reads and merges its buffer every BUFFER_SIZE reads.
+//
+// Usage: paired_buffer_bench [edges] [points] [threads] [max distance]
+
+#include "paired_info/concurrent_pair_info_buffer.hpp"
+#include "paired_info/paired_info.hpp"
+#include "paired_info/paired_info_helpers.hpp"
+#include "paired_info/sharded_pair_info_buffer.hpp"
+
+#include "assembly_graph/core/graph.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace debruijn_graph;
+using namespace omnigraph::de;
+
+using Index = UnclusteredPairedInfoIndexT<Graph>;
+
+static void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+static std::vector<EdgeId> RandomGraph(Graph &g, size_t edges, std::mt19937_64 &rnd) {
+    std::vector<VertexId> vertices;
+    for (size_t i = 0; i < edges / 2 + 1; ++i)
+        vertices.push_back(g.AddVertex());
+
+    std::string seq(g.k() + 100, 'A');
+    std::vector<EdgeId> res;
+    for (size_t i = 0; i < edges; ++i) {
+        for (auto &c : seq)
+            c = nucl(char(rnd() % 4));
+        res.push_back(g.AddEdge(vertices[rnd() % vertices.size()], vertices[rnd() % vertices.size()],
+                                Sequence(seq)));
+    }
+
+    return res;
+}
+
+// Emulates the read processing loop of SequenceMapperNotifier
+template<class AddF, class MergeF>
+static double Fill(size_t points, size_t nthreads, AddF add, MergeF merge) {
+    const size_t BUFFER_SIZE = 200000;
+
+    utils::perf_counter pc;
+    std::mutex merge_lock;
+    #pragma omp parallel num_threads(nthreads)
+    {
+        size_t thread_id = omp_get_thread_num();
+        size_t unmerged = 0;
+        #pragma omp for schedule(static)
+        for (size_t i = 0; i < points; ++i) {
+            add(thread_id, i);
+            if (++unmerged >= BUFFER_SIZE && merge_lock.try_lock()) {
+                merge(thread_id);
+                merge_lock.unlock();
+                unmerged = 0;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < nthreads; ++i)
+        merge(i);
+
+    return pc.time();
+}
+
+static std::vector<std::tuple<uint64_t, uint64_t, float, float>> GetPoints(const Index &pi) {
+    std::vector<std::tuple<uint64_t, uint64_t, float, float>> res;
+    for (auto it = pair_begin(pi); it != pair_end(pi); ++it)
+        for (auto p : *it)
+            res.emplace_back(it.first().int_id(), it.second().int_id(), p.d, p.weight);
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+int main(int argc, char **argv) {
+    create_console_logger();
+
+    size_t nedges = argc > 1 ? std::stoull(argv[1]) : 100000;
+    size_t npoints = argc > 2 ? std::stoull(argv[2]) : 20000000;
+    size_t nthreads = argc > 3 ? std::stoull(argv[3]) : omp_get_max_threads();
+    size_t max_distance = argc > 4 ? std::stoull(argv[4]) : 500;
+
+    std::mt19937_64 rnd(42);
+    Graph g(55);
+    std::vector<EdgeId> edges = RandomGraph(g, nedges, rnd);
+    INFO("Graph with " << g.e_size() << " edges generated");
+
+    // Pairs are local the same way mapped read pairs are: the second edge is
+    // chosen from a small neighbourhood of the first one
+    std::vector<std::tuple<EdgeId, EdgeId, RawPoint>> points;
+    points.reserve(npoints);
+    for (size_t i = 0; i < npoints; ++i) {
+        size_t idx = rnd() % edges.size();
+        EdgeId e1 = edges[idx], e2 = edges[(idx + rnd() % 16) % edges.size()];
+        points.emplace_back(e1, e2, RawPoint(DEDistance(rnd() % max_distance), 1));
+    }
+    INFO(points.size() << " points generated, " << nthreads << " threads");
+
+    Index concurrent_index(g);
+    {
+        ConcurrentPairedInfoBuffer<Graph> buffer(g);
+        double fill = Fill(points.size(), nthreads,
+                           [&](size_t, size_t i) {
+                               const auto &p = points[i];
+                               buffer.Add(std::get<0>(p), std::get<1>(p), std::get<2>(p));
+                           },
+                           [](size_t) {});
+        utils::perf_counter pc;
+        concurrent_index.MoveAssign(buffer);
+        INFO("Concurrent buffer: fill " << fill << "s, move " << pc.time() << "s");
+    }
+
+    Index sharded_index(g);
+    {
+        ShardedPairedInfoBuffer<Graph> buffer(g, nthreads);
+        double fill = Fill(points.size(), nthreads,
+                           [&](size_t thread_id, size_t i) {
+                               const auto &p = points[i];
+                               buffer.Add(thread_id, std::get<0>(p), std::get<1>(p), std::get<2>(p));
+                           },
+                           [&](size_t thread_id) { buffer.Compact(thread_id); });
+        utils::perf_counter pc;
+        buffer.Reduce();
+        double reduce = pc.time();
+        pc.reset();
+        sharded_index.MoveAssign(buffer);
+        INFO("Sharded buffer: fill " << fill << "s, reduce " << reduce << "s, move " << pc.time() << "s");
+    }
+
+    if (concurrent_index.size() != sharded_index.size() ||
+        GetPoints(concurrent_index) != GetPoints(sharded_index)) {
+        ERROR("Indices differ");
+        return 1;
+    }
+
+    INFO("Indices are the same, size " << sharded_index.size());
+    return 0;
+}
@@ -6,8 +6,12 @@
 //***************************************************************************
 
 #include "random_graph.hpp"
+#include "tmp_folder_fixture.hpp"
 
+#include "paired_info/filtering_pair_info_filler.hpp"
+#include "paired_info/frozen_paired_info.hpp"
 #include "paired_info/index_point.hpp"
+#include "paired_info/pair_info_filler.hpp"
 #include "paired_info/paired_info_helpers.hpp"
 //#include "io/binary/paired_index.hpp"
 
@@ -459,3 +463,170 @@ TEST(PairedInfo, RandomSymmetry) {
         }
     }
 }
+
+TEST(PairedInfo, Frozen) {
+    debruijn_graph::Graph graph(55);
+    debruijn_graph::RandomGraph<debruijn_graph::Graph>(graph, /*max_size*/100).Generate(/*iterations*/1000);
+
+    TestIndex pi(graph);
+    debruijn_graph::RandomPairedIndex<TestIndex>(pi, 200).Generate(100);
+    FrozenUnclusteredPairedInfoIndexT<debruijn_graph::Graph> frozen(pi);
+
+    EXPECT_EQ(pi.size(), frozen.size());
+    auto to_vector = [](const auto &hist) {
+        return std::vector<RawPoint>(hist.begin(), hist.end());
+    };
+    for (EdgeId e1 : graph.edges()) {
+        EXPECT_EQ(pi.contains(e1), frozen.contains(e1));
+        for (bool half : { false, true }) {
+            auto neighbours = half ? pi.GetHalf(e1) : pi.Get(e1);
+            auto frozen_neighbours = half ? frozen.GetHalf(e1) : frozen.Get(e1);
+            auto i = neighbours.begin();
+            auto j = frozen_neighbours.begin();
+            for (; i != neighbours.end() && j != frozen_neighbours.end(); ++i, ++j) {
+                EXPECT_EQ((*i).first, (*j).first);
+                EXPECT_EQ(to_vector((*i).second), to_vector((*j).second));
+            }
+            EXPECT_TRUE(i == neighbours.end() && j == frozen_neighbours.end());
+        }
+
+        for (EdgeId e2 : graph.edges()) {
+            EXPECT_EQ(pi.contains(e1, e2), frozen.contains(e1, e2));
+            EXPECT_EQ(to_vector(pi.Get(e1, e2)), to_vector(frozen.Get(e1, e2)));
+        }
+    }
+}
+
+std::vector<std::tuple<uint64_t, uint64_t, float, float>> GetPoints(const TestIndex &pi) {
+    std::vector<std::tuple<uint64_t, uint64_t, float, float>> res;
+    for (auto it = pair_begin(pi); it != pair_end(pi); ++it)
+        for (auto p : *it)
+            res.emplace_back(it.first().int_id(), it.second().int_id(), p.d, p.weight);
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+TEST(PairedInfo, SinglePassFiltering) {
+    using debruijn_graph::EdgeId;
+    using omnigraph::MappingPath;
+    using omnigraph::MappingRange;
+
+    TmpFolderFixture fixture("tmp");
+    debruijn_graph::Graph graph(55);
+    debruijn_graph::RandomGraph<debruijn_graph::Graph>(graph, /*max_size*/100).Generate(/*iterations*/1000);
+    debruijn_graph::RandomGraphAccessor<debruijn_graph::Graph> accessor(graph);
+
+    // Few edges, so some edge pairs are repeated
+    std::vector<EdgeId> edges;
+    for (size_t i = 0; i < 30; ++i)
+        edges.push_back(accessor.GetRandomEdge());
+
+    auto random_path = [&]() {
+        std::vector<std::pair<EdgeId, MappingRange>> path;
+        for (size_t i = 0, n = 1 + rand() % 2; i < n; ++i) {
+            size_t start = rand() % 50, mapped_start = rand() % 50;
+            path.emplace_back(edges[rand() % edges.size()],
+                              MappingRange(start, start + 20, mapped_start, mapped_start + 20));
+        }
+        return MappingPath<EdgeId>(path);
+    };
+
+    io::PairedRead read(io::SingleRead("r1", std::string(100, 'A')),
+                        io::SingleRead("r2", std::string(100, 'C')), 300);
+    std::vector<std::pair<MappingPath<EdgeId>, MappingPath<EdgeId>>> pairs;
+    for (size_t i = 0; i < 200; ++i)
+        pairs.emplace_back(random_path(), random_path());
+
+    for (unsigned threshold : { 1, 2 }) {
+        for (unsigned round : { 0, 5 }) {
+            // Exact counts of the edge pair filter
+            std::map<std::pair<EdgeId, EdgeId>, unsigned> counts;
+            for (const auto &pair : pairs)
+                for (size_t i = 0; i < pair.first.size(); ++i)
+                    for (size_t j = 0; j < pair.second.size(); ++j) {
+                        EdgeId e1 = pair.first.edge_at(i), e2 = pair.second.edge_at(j);
+                        counts[{e1, e2}] += 1;
+                        counts[{graph.conjugate(e2), graph.conjugate(e1)}] += 1;
+                    }
+
+            TestIndex expected(graph);
+            debruijn_graph::LatePairedIndexFiller late(graph,
+                                                       [&](const std::pair<EdgeId, EdgeId> &ep,
+                                                           const MappingRange&, const MappingRange&) {
+                                                           return counts[ep] > threshold ? 1. : 0.;
+                                                       }, round, expected);
+            TestIndex index(graph);
+            debruijn_graph::FilteringPairedIndexFiller filler(graph, threshold, round, index,
+                                                              fs::tmp::make_temp_dir(fixture.tmp_folder(), "pairs"),
+                                                              /*buffer size*/16, /*max merged runs*/4);
+            for (debruijn_graph::SequenceMapperListener *listener :
+                     std::initializer_list<debruijn_graph::SequenceMapperListener*>{ &late, &filler }) {
+                listener->StartProcessLibrary(3);
+                for (size_t i = 0; i < pairs.size(); ++i)
+                    listener->ProcessPairedRead(i % 3, read, pairs[i].first, pairs[i].second);
+                listener->StopProcessLibrary();
+            }
+
+            EXPECT_LT(0, expected.size());
+            EXPECT_EQ(expected.size(), index.size());
+            EXPECT_EQ(GetPoints(expected), GetPoints(index));
+        }
+    }
+}
+
+TEST(PairedInfo, ShardedBuffer) {
+    using debruijn_graph::EdgeId;
+    using omnigraph::MappingPath;
+    using omnigraph::MappingRange;
+
+    debruijn_graph::Graph graph(55);
+    debruijn_graph::RandomGraph<debruijn_graph::Graph>(graph, /*max_size*/100).Generate(/*iterations*/1000);
+    debruijn_graph::RandomGraphAccessor<debruijn_graph::Graph> accessor(graph);
+
+    std::vector<EdgeId> edges;
+    for (size_t i = 0; i < 30; ++i)
+        edges.push_back(accessor.GetRandomEdge());
+
+    auto random_path = [&]() {
+        std::vector<std::pair<EdgeId, MappingRange>> path;
+        for (size_t i = 0, n = 1 + rand() % 3; i < n; ++i) {
+            size_t start = rand() % 50, mapped_start = rand() % 50;
+            path.emplace_back(edges[rand() % edges.size()],
+                              MappingRange(start, start + 20, mapped_start, mapped_start + 20));
+        }
+        return MappingPath<EdgeId>(path);
+    };
+
+    io::PairedRead read(io::SingleRead("r1", std::string(100, 'A')),
+                        io::SingleRead("r2", std::string(100, 'C')), 300);
+    std::vector<std::pair<MappingPath<EdgeId>, MappingPath<EdgeId>>> pairs;
+    for (size_t i = 0; i < 500; ++i)
+        pairs.emplace_back(random_path(), random_path());
+
+    auto weight = [](const std::pair<EdgeId, EdgeId> &, const MappingRange&, const MappingRange&) {
+        return 1.;
+    };
+
+    for (unsigned round : { 0, 5 }) {
+        TestIndex expected(graph);
+        debruijn_graph::LatePairedIndexFiller late(graph, weight, round, expected);
+        TestIndex index(graph);
+        debruijn_graph::ShardedPairedIndexFiller sharded(graph, weight, round, index);
+        for (debruijn_graph::SequenceMapperListener *listener :
+                 std::initializer_list<debruijn_graph::SequenceMapperListener*>{ &late, &sharded }) {
+            listener->StartProcessLibrary(3);
+            for (size_t i = 0; i < pairs.size(); ++i) {
+                listener->ProcessPairedRead(i % 3, read, pairs[i].first, pairs[i].second);
+                if (i % 37 == 0)
+                    listener->MergeBuffer(i % 3);
+            }
+            for (size_t i = 0; i < 3; ++i)
+                listener->MergeBuffer(i);
+            listener->StopProcessLibrary();
+        }
+
+        EXPECT_LT(0, expected.size());
+        EXPECT_EQ(expected.size(), index.size());
+        EXPECT_EQ(GetPoints(expected), GetPoints(index));
+    }
+}
@@ -6,6 +6,7 @@
 //***************************************************************************
 
 
+#include "modules/path_extend/path_extender.hpp"
 #include "modules/path_extend/path_visualizer.hpp"
 #include "modules/path_extend/pe_utils.hpp"
 
@@ -756,3 +757,93 @@ TEST( PathExtend, BidirectionalPathLoopDetector ) {
     EXPECT_EQ(path1->Size(), 12);
     EXPECT_EQ(path1->Back(), e7);
 }
+
+static std::vector<std::vector<EdgeId>> ExtendSeeds(Graph &g, size_t threads) {
+    omnigraph::FlankingCoverage<Graph> flanking_cov(g, 50);
+    ScaffoldingUniqueEdgeStorage unique;
+    UsedUniqueStorage used(unique, g);
+    GraphCoverageMap cover_map(g);
+
+    auto make_extenders = [&](const GraphCoverageMap &cov_map, UsedUniqueStorage &used_storage) {
+        auto ec = std::make_shared<TrivialExtensionChooser>(g);
+        return CompositeExtender::Extenders{
+            std::make_shared<SimpleExtender>(g, flanking_cov, cov_map, used_storage, ec,
+                                             true, false, 300)};
+    };
+    CompositeExtender extender(g, cover_map, used, make_extenders(cover_map, used),
+                               make_extenders, threads);
+
+    PathContainer seeds;
+    for (EdgeId e : g.canonical_edges())
+        seeds.Create(g, e);
+    seeds.SortByLength();
+
+    PathContainer paths;
+    extender.GrowAll(seeds, paths);
+
+    std::vector<std::vector<EdgeId>> res;
+    for (const auto &path_pair : paths) {
+        for (const BidirectionalPath *path : { path_pair.first.get(), path_pair.second.get() }) {
+            res.emplace_back();
+            for (size_t i = 0; i < path->Size(); ++i)
+                res.back().push_back(path->At(i));
+        }
+    }
+    return res;
+}
+
+TEST( PathExtend, ParallelSeedExtension ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g));
+
+    auto serial = ExtendSeeds(g, 1);
+    EXPECT_FALSE(serial.empty());
+    EXPECT_EQ(serial, ExtendSeeds(g, 4));
+}
+
+TEST( PathExtend, ConcurrentCoverageMap ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g));
+
+    PathContainer paths;
+    for (EdgeId e : g.canonical_edges()) {
+        auto path_pair = paths.CreatePair(g, e);
+        for (EdgeId next : g.OutgoingEdges(g.EdgeEnd(e)))
+            path_pair.first.PushBack(next);
+        path_pair.first.PushBack(e);
+    }
+
+    GraphCoverageMap serial_map(g, paths, true);
+    GraphCoverageMap cover_map(g, /* concurrent */ true);
+    std::vector<BidirectionalPath*> all_paths;
+    for (const auto &path_pair : paths) {
+        all_paths.push_back(path_pair.first.get());
+        all_paths.push_back(path_pair.second.get());
+    }
+
+    #pragma omp parallel for num_threads(4)
+    for (size_t i = 0; i < all_paths.size(); ++i)
+        cover_map.Subscribe(*all_paths[i]);
+
+    auto check = [&]() {
+        EXPECT_EQ(serial_map.size(), cover_map.size());
+        for (EdgeId e : g.edges()) {
+            ASSERT_EQ(serial_map.GetCoveringPaths(e), cover_map.GetCoveringPaths(e));
+            for (const auto &entry : serial_map.GetEdgePaths(e))
+                EXPECT_EQ(entry.count, cover_map.Count(e, *entry.path));
+        }
+    };
+    check();
+
+    // Conjugate paths are changed together
+    #pragma omp parallel for num_threads(4)
+    for (size_t i = 0; i < all_paths.size(); i += 2)
+        all_paths[i]->PopBack();
+    check();
+
+    #pragma omp parallel for num_threads(4)
+    for (size_t i = 0; i < all_paths.size(); i += 2)
+        all_paths[i]->Clear();
+    check();
+    EXPECT_EQ(cover_map.size(), 0);
+}
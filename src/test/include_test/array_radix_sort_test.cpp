@@ -0,0 +1,75 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "adt/array_radix_sort.hpp"
+#include "adt/array_vector.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+template<class T>
+static std::vector<std::vector<T>> RandomArrays(size_t n, size_t elcnt, size_t distinct, unsigned seed) {
+    std::mt19937_64 rnd(seed);
+    std::vector<std::vector<T>> pool(distinct, std::vector<T>(elcnt));
+    for (auto &el : pool)
+        for (auto &w : el)
+            // Keep the higher bytes of the words mostly constant, like in k-mers
+            w = T(rnd() >> (rnd() % 2 ? 0 : 8 * sizeof(T) / 2));
+
+    std::vector<std::vector<T>> res;
+    for (size_t i = 0; i < n; ++i)
+        res.push_back(pool[rnd() % distinct]);
+
+    return res;
+}
+
+template<class T>
+static void CheckSort(size_t n, size_t elcnt, size_t distinct, unsigned nthreads, bool dedup) {
+    auto arrays = RandomArrays<T>(n, elcnt, distinct, unsigned(n + elcnt));
+    std::vector<T> data;
+    for (const auto &el : arrays)
+        data.insert(data.end(), el.begin(), el.end());
+
+    std::sort(arrays.begin(), arrays.end());
+    size_t cnt = n;
+    if (dedup) {
+        arrays.erase(std::unique(arrays.begin(), arrays.end()), arrays.end());
+        cnt = adt::array_radix_sort_unique(data.data(), n, elcnt, nthreads);
+    } else
+        adt::array_radix_sort(data.data(), n, elcnt, nthreads);
+
+    ASSERT_EQ(arrays.size(), cnt);
+    for (size_t i = 0; i < cnt; ++i)
+        for (size_t j = 0; j < elcnt; ++j)
+            ASSERT_EQ(arrays[i][j], data[i * elcnt + j]);
+
+    adt::array_vector<T> v(data.data(), cnt, elcnt);
+    EXPECT_TRUE(std::is_sorted(v.begin(), v.end(), adt::array_less<T>()));
+}
+
+TEST( ArrayRadixSort, Small ) {
+    CheckSort<uint64_t>(10, 2, 5, 1, false);
+    CheckSort<uint64_t>(10, 2, 5, 1, true);
+    CheckSort<uint64_t>(0, 2, 1, 1, true);
+}
+
+TEST( ArrayRadixSort, SingleWord ) {
+    CheckSort<uint64_t>(100000, 1, 50000, 1, false);
+    CheckSort<uint64_t>(100000, 1, 50000, 4, true);
+}
+
+TEST( ArrayRadixSort, MultiWord ) {
+    CheckSort<uint64_t>(100000, 4, 1000, 1, true);
+    CheckSort<uint64_t>(100000, 3, 100000, 4, false);
+    CheckSort<uint32_t>(100000, 5, 30000, 4, true);
+}
+
+TEST( ArrayRadixSort, AllEqual ) {
+    CheckSort<uint64_t>(10000, 2, 1, 2, false);
+    CheckSort<uint64_t>(10000, 2, 1, 2, true);
+}
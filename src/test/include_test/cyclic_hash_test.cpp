@@ -8,6 +8,7 @@
 #include "sequence/rtseq.hpp"
 #include "sequence/sequence.hpp"
 #include "adt/cyclichash.hpp"
+#include "kmer_index/kmer_mph/kmer_segment_hash.hpp"
 #include <gtest/gtest.h>
 
 TEST( CyclicHash, TestBasic ) {
@@ -75,3 +76,35 @@ TEST( CyclicHash, TestRoll ) {
         EXPECT_EQ((digest) hasher(RtSeq(k, s, i)), (digest) hash);
     }
 }
+
+TEST( CyclicHash, TestRollLong ) {
+    typedef uint64_t digest;
+    Sequence s("ACGTTGCAAGCTTAGCGATCGATCGGCTAGCTAGGATCCGATATCGCGATTAGCACGATCGATGCATGCTAGCTAGCTACGACTGACTAGCATCGAAGCTACGACTAGCATCGACTAGCAGCTTCGATCGTAGCAGATCAGCTAGCATCGATCGAGGCGCT");
+    for (unsigned k : { 63u, 64u, 65u, 77u, 127u }) {
+        rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> hasher(k);
+
+        size_t kmer_cnt = s.size() - k + 1;
+        auto hash = hasher(s);
+        for (size_t i = 1; i < kmer_cnt; ++i) {
+            hash = hasher.hash_update(hash, s[i - 1], s[i - 1 + k]);
+            EXPECT_EQ((digest) hasher(RtSeq(k, s, i)), (digest) hash);
+        }
+    }
+}
+
+TEST( CyclicHash, TestRollingSegmentHash ) {
+    Sequence s("ACGTTGCAAGCTTAGCGATCGATCGGCTAGCTAGGATCCGATATCGCGATTAGCACGATCGATGCATGCTAGCTAGCTACGACTGACTAGCATCGAAGCTACGACTAGCATCGACTAGCAGCTTCGATCGTAGCAGATCAGCTAGCATCGATCGAGGCGCT");
+    kmer::KMerSegmentHash<RtSeq> segment_hash;
+    for (unsigned k : { 5u, 21u, 32u, 33u, 55u, 64u, 77u, 127u }) {
+        kmer::RollingKMerHash hash(k);
+        hash.reset(s);
+        for (size_t i = 0; i + k <= s.size(); ++i) {
+            if (i)
+                hash.update(s[i - 1], s[i - 1 + k]);
+            RtSeq kmer(k, s, i);
+            EXPECT_EQ(segment_hash(kmer), hash.segment_hash());
+            EXPECT_EQ(segment_hash(!kmer), hash.rc_segment_hash());
+            EXPECT_EQ(segment_hash(kmer.data(), kmer.data_size()), hash.segment_hash());
+        }
+    }
+}
@@ -0,0 +1,109 @@
+//***************************************************************************
+//* Copyright (c) 2023-2024 SPAdes team
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "adt/queue_iterator.hpp"
+
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+struct ModPriority {
+    double operator()(size_t key) const {
+        return double(key % 97) / 3.0;
+    }
+};
+
+struct BucketedModPriority : public ModPriority {
+    static size_t bucket(double priority) {
+        return size_t(priority);
+    }
+};
+
+}
+
+static_assert(!adt::has_priority_buckets<ModPriority>::value);
+static_assert(adt::has_priority_buckets<BucketedModPriority>::value);
+
+TEST( QueueIterator, BucketQueueOrder ) {
+    adt::erasable_priority_queue_key_dirty_heap<size_t, ModPriority> heap;
+    adt::erasable_priority_queue_key_buckets<size_t, BucketedModPriority> buckets;
+
+    // Starting far from the first bucket
+    for (size_t key : {96, 95, 50}) {
+        heap.push(key);
+        buckets.push(key);
+        ASSERT_EQ(heap.top(), buckets.top());
+    }
+
+    std::mt19937 rnd(42);
+    for (size_t i = 0; i < 100000; ++i) {
+        size_t key = rnd() % 1000;
+        switch (rnd() % 4) {
+            case 0:
+            case 1:
+                heap.push(key);
+                buckets.push(key);
+                break;
+            case 2:
+                ASSERT_EQ(heap.erase(key), buckets.erase(key));
+                break;
+            case 3:
+                ASSERT_EQ(heap.empty(), buckets.empty());
+                if (!heap.empty()) {
+                    ASSERT_EQ(heap.top(), buckets.top());
+                    heap.pop();
+                    buckets.pop();
+                }
+                break;
+        }
+        ASSERT_EQ(heap.size(), buckets.size());
+        if (i % 1000 == 0) {
+            ASSERT_EQ(heap.peek(50), buckets.peek(50));
+        }
+        if (i % 10000 == 0) {
+            // Drain and refill
+            while (!heap.empty()) {
+                heap.pop();
+                buckets.pop();
+            }
+            ASSERT_TRUE(buckets.empty());
+            heap.push(90);
+            buckets.push(90);
+            ASSERT_EQ(heap.top(), buckets.top());
+        }
+    }
+
+    while (!heap.empty()) {
+        ASSERT_FALSE(buckets.empty());
+        ASSERT_EQ(heap.top(), buckets.top());
+        heap.pop();
+        buckets.pop();
+    }
+    ASSERT_TRUE(buckets.empty());
+}
+
+TEST( QueueIterator, BucketQueueIterator ) {
+    std::vector<size_t> keys;
+    for (size_t i = 0; i < 1000; ++i)
+        keys.push_back(i * 7);
+
+    adt::DynamicQueueIteratorKey<size_t, BucketedModPriority> it;
+    it.insert(keys.begin(), keys.end());
+    it.erase(0);
+
+    ModPriority priority;
+    std::vector<size_t> expected(keys.begin() + 1, keys.end());
+    std::sort(expected.begin(), expected.end(), [&](size_t a, size_t b) {
+        return std::make_pair(priority(a), a) < std::make_pair(priority(b), b);
+    });
+
+    ASSERT_EQ(it.Upcoming(10), std::vector<size_t>(expected.begin(), expected.begin() + 10));
+    std::vector<size_t> order;
+    for (; !it.IsEnd(); ++it)
+        order.push_back(*it);
+    ASSERT_EQ(expected, order);
+}
@@ -43,3 +43,50 @@ TEST( Sequence, ReverseComplement ) {
     Sequence s2 = Sequence("ACG");
     EXPECT_EQ("CGT", (!s2).str());
 }
+
+TEST( Sequence, Arena ) {
+    std::string str;
+    for (size_t i = 0; i < 1000; ++i)
+        str += "ACGT"[(i * i + 7 * i) % 4];
+    Sequence s(str);
+
+    std::vector<Sequence> stored;
+    {
+        NuclArena arena;
+        for (size_t from : {0, 1, 31, 32, 33, 500}) {
+            for (size_t len : {0, 1, 31, 32, 100, 400}) {
+                Sequence sub = s.Subseq(from, from + len);
+                Sequence copy(sub, arena);
+                EXPECT_TRUE(copy.in_arena());
+                EXPECT_EQ(sub, copy);
+                EXPECT_EQ(!sub, Sequence(!sub, arena));
+                stored.push_back(copy);
+            }
+        }
+        EXPECT_GT(arena.live(), 0);
+
+        std::string large(NuclArena::MAX_ALLOC * 8, 'A');
+        EXPECT_FALSE(Sequence(Sequence(large), arena).in_arena());
+    }
+
+    // The buffers outlive the arena
+    size_t i = 0;
+    for (size_t from : {0, 1, 31, 32, 33, 500})
+        for (size_t len : {0, 1, 31, 32, 100, 400})
+            EXPECT_EQ(str.substr(from, len), stored[i++].str());
+}
+
+TEST( Sequence, ArenaRenew ) {
+    NuclArena arena;
+    Sequence s("ACGTACGTACGTTTGCA");
+    Sequence kept(s, arena);
+    for (size_t i = 0; i < 100000; ++i)
+        Sequence(s, arena);
+    EXPECT_GT(arena.reserved(), NuclArena::SLAB_SIZE);
+    EXPECT_LT(arena.live(), 100);
+
+    arena.Renew();
+    EXPECT_EQ(0, arena.reserved());
+    EXPECT_EQ(s, Sequence(kept, arena));
+    EXPECT_EQ(s, kept);
+}